@@ -17,6 +17,14 @@
 
 #include "CHE_L0.hpp"
 
+#include "../common/Parallel.hpp"
+
+#include "../common/Ply_mmap.hpp"
+
+#include "../common/Snapshot.hpp"
+
+#include "../common/Space_curve.hpp"
+
 
 
 #include <set>
@@ -31,6 +39,22 @@
 
 using namespace std;
 
+/** \brief Vertex of the next of a half-edge, without validity test*/
+static inline Vid he_nextV( const Vid *V, const HEid h ) { return V[ 3*(h/3) + (h+1)%3 ]; }
+
+/** \brief Order of the half-edge index: vertex, vertex of the next, id*/
+struct HE_index_less
+{
+  const Vid *V;
+  HE_index_less( const Vid *v ) : V(v) {}
+  bool operator()( const HEid h, const HEid k ) const
+  {
+    if( V[h] != V[k] ) return V[h] < V[k];
+    const Vid a = he_nextV( V, h ), b = he_nextV( V, k );
+    if( a != b ) return a < b;
+    return h < k;
+  }
+};
 //--------------------------------------------------//
 vector<Vid> CHE_L0::R_00(const Vid v)
 //--------------------------------------------------//
@@ -45,6 +69,14 @@ vector<Vid> CHE_L0::R_00(const Vid v)
     return star; 
   }
 
+  if( has_index() )
+  {
+    for( int k = index_lower( v, INV ); k < (int)_HI.size() && _V[_HI[k]] == v; ++k ) {
+      sstar.insert( V(next(_HI[k])) );
+      sstar.insert( V(prev(_HI[k])) );
+    }
+  }
+  else
   for(HEid i=0; i<3*ntrig(); ++i)
     if( V(i) == v ) {
       sstar.insert( V(next(i)) );
@@ -71,6 +103,15 @@ vector<TRid> CHE_L0::R_02(const Vid v)
     return star; 
   }
 
+  if( has_index() )
+  {
+    // the index sorts them by edge key: back to the triangle order
+    for( int k = index_lower( v, INV ); k < (int)_HI.size() && _V[_HI[k]] == v; ++k )
+      star.push_back( trig(_HI[k]) );
+    sort( star.begin(), star.end() );
+    return star;
+  }
+
   for(HEid i=0; i<3*ntrig(); ++i)
     if( V(i) == v ) 
       star.push_back( trig(i) );
@@ -94,6 +135,14 @@ vector<Vid> CHE_L0::R_10(const HEid h)
   Vid a = V(h); Vid b = V(next(h));
   star.push_back( V(prev(h)) );
 
+  if( has_index() )
+  {
+    const int k = index_lower( b, a );
+    if( k < (int)_HI.size() && _V[_HI[k]] == b && he_nextV( &_V[0], _HI[k] ) == a )
+      star.push_back( V(prev(_HI[k])) );
+    return star;
+  }
+
   for(HEid i=0; i<3*ntrig(); ++i)
   {
     if( b == V(i) && a == V(next(i)) ){
@@ -120,6 +169,14 @@ vector<TRid> CHE_L0::R_12(const HEid h)
   Vid a = V(h); Vid b = V(next(h));
   star.push_back( trig(h) );
 
+  if( has_index() )
+  {
+    const int k = index_lower( b, a );
+    if( k < (int)_HI.size() && _V[_HI[k]] == b && he_nextV( &_V[0], _HI[k] ) == a )
+      star.push_back( trig(_HI[k]) );
+    return star;
+  }
+
   for(HEid i=0; i<3*ntrig(); ++i)
   {
     if( b == V(i) && a == V(next(i)) ){
@@ -147,6 +204,20 @@ vector<TRid> CHE_L0::R_22(const TRid t)
         b = V(3*t+1),
         c = V(3*t+2);
 
+  if( has_index() )
+  {
+    // the opposite half-edges of the three edges, in half-edge order
+    const Vid e[3][2] = { {b,a}, {a,c}, {c,b} };
+    vector<HEid> hs;
+    for( int j=0; j<3; ++j )
+      for( int k = index_lower( e[j][0], e[j][1] ); k < (int)_HI.size() && _V[_HI[k]] == e[j][0] && he_nextV( &_V[0], _HI[k] ) == e[j][1]; ++k )
+        hs.push_back( _HI[k] );
+    sort( hs.begin(), hs.end() );
+    hs.erase( unique( hs.begin(), hs.end() ), hs.end() );
+    for( int k=0; k<(int)hs.size(); ++k ) star.push_back( trig(hs[k]) );
+    return star;
+  }
+
   for(HEid i=0; i<3*ntrig(); ++i)
   {
     if( ( b == V(i) && a == V(next(i)) ) ||   
@@ -158,59 +229,184 @@ vector<TRid> CHE_L0::R_22(const TRid t)
   return star;
 }
 //--------------------------------------------------//
-void CHE_L0::compute_normals()
+void CHE_L0::build_index()
 //--------------------------------------------------//
-/** Computes the normals of the triangles.*/
+/** Sorts the valid half-edges by vertex (counting sort), then each vertex by edge key.*/
 {
-  double norm[3];
-  double  nrm[3];
+  const Vid nv = nvert();
+  vector<int> off( nv+1, 0 );
+  for(HEid h=0; h<3*ntrig(); ++h)
+    if( _V[h] >= 0 && _V[h] < nv ) ++off[ _V[h]+1 ];
+  for(Vid v=0; v<nv; ++v) off[v+1] += off[v];
+
+  _HI.resize( off[nv] );
+  vector<int> pos( off.begin(), off.end()-1 );
+  for(HEid h=0; h<3*ntrig(); ++h)
+    if( _V[h] >= 0 && _V[h] < nv ) _HI[ pos[_V[h]]++ ] = h;
+
+  if( _HI.empty() ) return;
+  const HE_index_less less( &_V[0] );
+  #pragma omp parallel for schedule(dynamic,1024)
+  for(Vid v=0; v<nv; ++v)
+    if( off[v+1] - off[v] > 1 ) sort( _HI.begin()+off[v], _HI.begin()+off[v+1], less );
+}
+//--------------------------------------------------//
+const int CHE_L0::index_lower( const Vid a, const Vid b ) const
+//--------------------------------------------------//
+/** Binary search of the first half-edge from a to b or after in the index.*/
+{
+  int lo = 0, hi = (int)_HI.size();
+  while( lo < hi )
+  {
+    const int m = lo + ( hi-lo ) / 2;
+    const HEid h = _HI[m];
+    if( _V[h] < a || ( _V[h] == a && he_nextV( &_V[0], h ) < b ) ) lo = m+1; else hi = m;
+  }
+  return lo;
+}
+//--------------------------------------------------//
+void CHE_L0::set_layout( const bool soa )
+//--------------------------------------------------//
+/** Moves the geometry to the vector of Vertex or to the structure of arrays.*/
+{
+  if( soa == _soa ) return;
 
+  if( soa )
+  {
+    _S.resize( (int)_G.size() );
+    for(Vid i=0; i<(Vid)_G.size(); ++i) _S.set( i, _G[i] );
+    vector<Vertex>().swap( _G );
+  }
+  else
+  {
+    _G.resize( _S.size() );
+    for(Vid i=0; i<_S.size(); ++i) _G[i] = _S.get(i);
+    _S.clear();
+  }
+  _soa = soa;
+}
+//--------------------------------------------------//
+void CHE_L0::compute_normals()
+//--------------------------------------------------//
+/** Computes the normals of the vertices.*/
+{
   cout << "Pet_CHE::compute_normals... " ;
 
-  for(Vid i=0; i< ntrig(); i++)
-  {
-    if( !v_valid(V(3*i)) || !v_valid(V(3*i+1)) || !v_valid(V(3*i+2)) ) continue;
+  const Vid  nv = nvert();
+  const TRid nt = ntrig();
 
-    Vertex &v0 = G( V( 3*i ) );
-    Vertex &v1 = G( V(3*i+1) );
-    Vertex &v2 = G( V(3*i+2) );
+  //--- vertex to triangle index ---//
+  _NO.assign( nv+1, 0 );
+  for(HEid h=0; h<3*nt; ++h)
+    if( _V[h] >= 0 && _V[h] < nv ) ++_NO[ _V[h]+1 ];
+  for(Vid v=0; v<nv; ++v) _NO[v+1] += _NO[v];
 
-    Vertex::normal( v0,v1,v2, norm ) ;
+  _NT.resize( _NO[nv] );
+  vector<int> pos( _NO.begin(), _NO.end()-1 );
+  for(HEid h=0; h<3*nt; ++h)
+    if( _V[h] >= 0 && _V[h] < nv ) _NT[ pos[_V[h]]++ ] = h/3;
 
-    //--- V0 ----//
-    nrm[0] = norm[0] + v0.nx();
-    nrm[1] = norm[1] + v0.ny();
-    nrm[2] = norm[2] + v0.nz();
+  //--- triangle normals, then one gather per vertex ---//
+  _FN.resize( 3*nt );
+  face_normals( 0, nt );
 
-    Vertex::normalize( nrm ) ;
-    
-    v0.set_nx( nrm[0] );
-    v0.set_ny( nrm[1] );
-    v0.set_nz( nrm[2] );
+  #pragma omp parallel for schedule(static)
+  for(Vid v=0; v<nv; ++v) gather_normal(v);
 
-    //--- V1 ----//
-    nrm[0] = norm[0] + v1.nx();
-    nrm[1] = norm[1] + v1.ny();
-    nrm[2] = norm[2] + v1.nz();
+  _ND.assign( nv, 0 );
+  _NDL.assign( nv, INV );
+  _ndn = 0;
 
-    Vertex::normalize( nrm ) ;
-            
-    v1.set_nx( nrm[0] );
-    v1.set_ny( nrm[1] );
-    v1.set_nz( nrm[2] );
+  cout << " done." << endl;
+}
+//--------------------------------------------------//
+void CHE_L0::update_normals()
+//--------------------------------------------------//
+/** Recomputes the normals around the moved vertices.*/
+{
+  if( (Vid)_NO.size() != nvert()+1 || (TRid)_FN.size() != 3*ntrig() || (Vid)_ND.size() != nvert() )
+  { compute_normals(); return; }
 
-    //--- V2 ----//
-    nrm[0] = norm[0] + v2.nx();
-    nrm[1] = norm[1] + v2.ny();
-    nrm[2] = norm[2] + v2.nz();
+  // triangles of the moved vertices: new normals, and their vertices need a new gather
+  vector<Vid> regather;
+  for(int i=0; i<_ndn; ++i)
+  {
+    const Vid v = _NDL[i];
+    for(int k=_NO[v]; k<_NO[v+1]; ++k)
+    {
+      const TRid t = _NT[k];
+      face_normals( t, t+1 );
+      for(int j=0; j<3; ++j)
+      {
+        const Vid w = _V[3*t+j];
+        if( w < 0 || w >= nvert() || _ND[w] == 2 ) continue;
+        _ND[w] = 2;
+        regather.push_back(w);
+      }
+    }
+  }
 
-    Vertex::normalize( nrm ) ;
+  const int n = (int)regather.size();
+  #pragma omp parallel for schedule(static)
+  for(int i=0; i<n; ++i) gather_normal( regather[i] );
 
-    v2.set_nx( nrm[0] );
-    v2.set_ny( nrm[1] );
-    v2.set_nz( nrm[2] );
+  for(int i=0; i<_ndn; ++i) _ND[ _NDL[i] ] = 0;
+  for(int i=0; i<n; ++i) _ND[ regather[i] ] = 0;
+  _ndn = 0;
+}
+//--------------------------------------------------//
+void CHE_L0::face_normals( const TRid t0, const TRid t1 )
+//--------------------------------------------------//
+/** Computes the unnormalized normals of the triangles t0 to t1-1.*/
+{
+  const Vid nv = nvert();
+  double *fn = _FN.empty() ? NULL : &_FN[0];
+
+  if( _soa )
+  {
+    // flat loop on the coordinate arrays
+    const VertexSoA::real_type *px = _S.x.data(), *py = _S.y.data(), *pz = _S.z.data();
+    #pragma omp parallel for schedule(static) if( t1-t0 > 1024 )
+    for(TRid t=t0; t<t1; ++t)
+    {
+      const Vid a = _V[3*t], b = _V[3*t+1], c = _V[3*t+2];
+      if( a < 0 || b < 0 || c < 0 || a >= nv || b >= nv || c >= nv || !v_valid(a) || !v_valid(b) || !v_valid(c) )
+      { fn[3*t] = fn[3*t+1] = fn[3*t+2] = 0.0; continue; }
+
+      const double ux = px[b]-px[a], uy = py[b]-py[a], uz = pz[b]-pz[a];
+      const double wx = px[c]-px[a], wy = py[c]-py[a], wz = pz[c]-pz[a];
+      fn[3*t  ] = uy*wz - wy*uz;
+      fn[3*t+1] = uz*wx - wz*ux;
+      fn[3*t+2] = ux*wy - wx*uy;
+    }
+    return;
+  }
+
+  #pragma omp parallel for schedule(static) if( t1-t0 > 1024 )
+  for(TRid t=t0; t<t1; ++t)
+  {
+    const Vid a = _V[3*t], b = _V[3*t+1], c = _V[3*t+2];
+    if( a < 0 || b < 0 || c < 0 || a >= nv || b >= nv || c >= nv || !v_valid(a) || !v_valid(b) || !v_valid(c) )
+    { fn[3*t] = fn[3*t+1] = fn[3*t+2] = 0.0; continue; }
+
+    Vertex::normal( _G[a], _G[b], _G[c], fn+3*t );
   }
-  cout << " done." << endl;
+}
+//--------------------------------------------------//
+void CHE_L0::gather_normal( const Vid v )
+//--------------------------------------------------//
+/** Sums the normals of the triangles of v and normalizes the result.*/
+{
+  if( _NO[v] == _NO[v+1] ) return; // isolated vertex: keeps its normal
+
+  double n[3] = { 0.0, 0.0, 0.0 };
+  for(int k=_NO[v]; k<_NO[v+1]; ++k)
+  {
+    const double *f = &_FN[ 3*_NT[k] ];
+    n[0] += f[0]; n[1] += f[1]; n[2] += f[2];
+  }
+  Vertex::normalize( n );
+  set_normal( v, n[0], n[1], n[2] );
 }
 //--------------------------------------------------//
 void CHE_L0::bounding_box( float *min, float *max )
@@ -218,6 +414,20 @@ void CHE_L0::bounding_box( float *min, float *max )
 {
   float t_mx,t_Mx,t_my,t_My,t_mz,t_Mz;
 
+  if( _soa )
+  {
+    // one pass per coordinate array
+    const VertexSoA::real_type *px = _S.x.data(), *py = _S.y.data(), *pz = _S.z.data();
+    VertexSoA::real_type mx = px[0], Mx = px[0], my = py[0], My = py[0], mz = pz[0], Mz = pz[0];
+    for(Vid i=1; i<nvert(); ++i) { mx = px[i] < mx ? px[i] : mx; Mx = px[i] > Mx ? px[i] : Mx; }
+    for(Vid i=1; i<nvert(); ++i) { my = py[i] < my ? py[i] : my; My = py[i] > My ? py[i] : My; }
+    for(Vid i=1; i<nvert(); ++i) { mz = pz[i] < mz ? pz[i] : mz; Mz = pz[i] > Mz ? pz[i] : Mz; }
+
+    min[0]=(float)mx; min[1]=(float)my; min[2]=(float)mz;
+    max[0]=(float)Mx; max[1]=(float)My; max[2]=(float)Mz;
+    return;
+  }
+
   t_mx=t_Mx=_G[0].x();
   t_my=t_My=_G[0].y();
   t_mz=t_Mz=_G[0].z();
@@ -258,21 +468,19 @@ void CHE_L0::legalize_model (float *min, float *max)
 
   for(Vid i=0; i<nvert(); i++)
   {
-    float tx = _G[i].x();
-    float ty = _G[i].y();
-    float tz = _G[i].z();
+    float tx = x(i);
+    float ty = y(i);
+    float tz = z(i);
 
      tx -= c[0];
     if(size != 0) tx /= size;
-    _G[i].set_x(tx);
 
      ty -= c[1];
     if(size != 0) ty /= size;
-    _G[i].set_y(ty);
 
      tz -= c[2];
     if(size != 0) tz /= size;
-    _G[i].set_z(tz);
+    set_position( i, tx, ty, tz );
   }
 
   for(Vid i=0; i<3; i++)
@@ -288,11 +496,12 @@ void CHE_L0::check()
 //--------------------------------------------------//
 /** Checks the mesh.*/
 {
-  if(   nvert() != static_cast<int>(_G.size())  ){ cout << "CHE_L0:: Erro nvert()!= G.size"   << endl; return;}
+  if(   nvert() != ( _soa ? _S.size() : static_cast<int>(_G.size()) )  ){ cout << "CHE_L0:: Erro nvert()!= G.size"   << endl; return;}
   if(3*ntrig() != static_cast<int>(_V.size())  ) { cout << "CHE_L0:: Erro 3*ntrig()!= V.size" << endl; return;}
 
   for(int i=0; i<3*ntrig(); ++i)
   {
+    if( _V[i] == INV ) continue;  // removed
     if( V(i) >= nvert() )
     {
       cout << "CHE_L0:: Erro V(" << i <<") >= nvert." << endl;
@@ -314,11 +523,11 @@ void CHE_L0::draw_smooth()
 
 	{
 
-		const Vertex &v1 = G(V(r));
+		const Vertex v1 = vertex(V(r));
 
-		const Vertex &v2 = G(V(r+1));
+		const Vertex v2 = vertex(V(r+1));
 
-		const Vertex &v3 = G(V(r+2));
+		const Vertex v3 = vertex(V(r+2));
 
 
 
@@ -356,11 +565,11 @@ void CHE_L0::draw_wire()
 {
   for(int r=0; r< 3*ntrig(); r+=3)
   {
-		const Vertex &v1 = G(V(r));
+		const Vertex v1 = vertex(V(r));
 
-		const Vertex &v2 = G(V(r+1));
+		const Vertex v2 = vertex(V(r+1));
 
-		const Vertex &v3 = G(V(r+2));
+		const Vertex v3 = vertex(V(r+2));
 
 
 
@@ -416,7 +625,7 @@ void CHE_L0::draw_verts()
 
 	{
 
-		const Vertex &v1 = G(i);
+		const Vertex v1 = vertex(i);
 
 		glColor3f(0.9,0.9543,0.1239);
 
@@ -488,6 +697,13 @@ PlyProperty plyface_props[]  = {
 void CHE_L0::read_ply( const char* file )
 //--------------------------------------------------//
 /** Reads a 3D triangulated model in the PLY file format.*/
+{
+  if( load_ply( file ) ) compute_normals();
+}
+//--------------------------------------------------//
+bool CHE_L0::load_ply( const char* file )
+//--------------------------------------------------//
+/** Reads the geometry and the triangles of a PLY file.*/
 {
   // Stores Start && L0 time;
   clock_t start_time = static_cast<clock_t>(0.0),
@@ -498,12 +714,26 @@ void CHE_L0::read_ply( const char* file )
 
 	_G.clear();
 
+	_S.clear();
+
 	_V.clear();
 
+	_HI.clear();
+
 
 
   printf("Pet_CHE::read_ply(%s)...", file) ;
 
+  if( load_ply_mmap( file ) )
+  {
+    printf(" %d vertices and %d triangles found\n", nvert(), ntrig() ) ;
+
+    float min[3], max[3];
+    bounding_box  ( min, max);
+    legalize_model( min, max);
+    return true;
+  }
+
 
 
   /*** the Ply object ***/
@@ -530,7 +760,7 @@ void CHE_L0::read_ply( const char* file )
 
 
 
-  if( fp==NULL ) { printf(" file not found.\n" ); return; }
+  if( fp==NULL ) { printf(" file not found.\n" ); return false; }
 
 
 
@@ -566,7 +796,9 @@ void CHE_L0::read_ply( const char* file )
 
 
 
-  _G.resize(  nverts  );
+  if( _soa ) _S.resize( nverts );
+
+  else       _G.resize( nverts );
 
   _V.resize( 3*ntrigs );
 
@@ -678,14 +910,89 @@ void CHE_L0::read_ply( const char* file )
 
 	legalize_model( min, max);
 
-  compute_normals();
-
 
 
   L0_time = clock();
 
   //cout << "L0 load time:" << static_cast<double>(L0_time-start_time)/static_cast<double>(CLOCKS_PER_SEC) << endl;
 
+  return true;
+}
+//--------------------------------------------------//
+/** Stores the vertices parsed from an ascii PLY file in a vector of Vertex*/
+struct Ply_to_G
+//--------------------------------------------------//
+{
+  Vertex *G;
+  Ply_to_G( Vertex *g ) : G(g) {}
+  inline void operator()( const int v, const double x, const double y, const double z ) const { G[v] = Vertex( x, y, z ); }
+};
+//--------------------------------------------------//
+/** Stores the vertices parsed from an ascii PLY file in the coordinate arrays*/
+struct Ply_to_S
+//--------------------------------------------------//
+{
+  VertexSoA::real_type *x, *y, *z;
+  Ply_to_S( VertexSoA &s ) : x( s.x.data() ), y( s.y.data() ), z( s.z.data() ) {}
+  inline void operator()( const int v, const double a, const double b, const double c ) const
+  { x[v] = (VertexSoA::real_type)a; y[v] = (VertexSoA::real_type)b; z[v] = (VertexSoA::real_type)c; }
+};
+//--------------------------------------------------//
+bool CHE_L0::load_ply_mmap( const char* file )
+//--------------------------------------------------//
+/** Reads a binary little endian or ascii PLY file through a memory map.*/
+{
+  Ply_mmap ply;
+  if( !ply.open( file ) ) return false;
+
+  const Vid  nv = ply.nvert();
+  const TRid nt = ply.nface();
+
+  _HI.clear();
+  _V.resize( 3*nt );
+
+  if( ply.ascii() )
+  {
+    // parallel parse, straight into the final tables
+    bool ok;
+    if( _soa ) { _S.resize( nv );  ok = ply.read_ascii( Ply_to_S( _S ), nt ? &_V[0] : NULL, 3 ); }
+    else       { _G.resize( nv );  ok = ply.read_ascii( Ply_to_G( nv ? &_G[0] : NULL ), nt ? &_V[0] : NULL, 3 ); }
+    if( !ok ) { _V.clear(); _G.clear(); _S.clear(); return false; }
+
+    set_nvert(nv);
+    set_ntrig(nt);
+    return true;
+  }
+
+  if( nt > 0 && !ply.read_faces( &_V[0], 3 ) ) { _V.clear(); return false; }
+
+  set_nvert(nv);
+  set_ntrig(nt);
+
+  if( _soa )
+  {
+    // straight into the coordinate arrays
+    _S.resize( nv );
+    ply.read_vertex_property( ply.property("x"), _S.x.data(), 1, 0, nv );
+    ply.read_vertex_property( ply.property("y"), _S.y.data(), 1, 0, nv );
+    ply.read_vertex_property( ply.property("z"), _S.z.data(), 1, 0, nv );
+    return true;
+  }
+
+  // by blocks of vertices, through a small interleaved buffer
+  const int bs = 1024;
+  const int nb = ( nv + bs-1 ) / bs;
+  _G.resize( nv );
+  #pragma omp parallel for schedule(static)
+  for( int b=0; b<nb; ++b )
+  {
+    Vertex::real_type xyz[3*bs];
+    const Vid v0 = b*bs, v1 = ( v0+bs < nv ) ? v0+bs : nv;
+    ply.read_positions( v0, v1, xyz );
+    for( Vid v=v0; v<v1; ++v )
+      _G[v] = Vertex( xyz[3*(v-v0)], xyz[3*(v-v0)+1], xyz[3*(v-v0)+2] );
+  }
+  return true;
 }
 //--------------------------------------------------//
 void CHE_L0::write_ply( const char* file, bool bin )
@@ -753,7 +1060,7 @@ void CHE_L0::write_ply( const char* file, bool bin )
 
   {
 
-    Vertex &vt = _G[i] ;
+    const Vertex vt = vertex(i) ;
 
 	  PlyPoint p;
 
@@ -812,3 +1119,278 @@ void CHE_L0::write_ply( const char* file, bool bin )
   printf(" %d vertices and %d triangles written\n", nvert(), ntrig() ) ;
 
 }
+//--------------------------------------------------//
+bool CHE_L0::write_snapshot( const char* file )
+//--------------------------------------------------//
+/** Writes the tables of the structure in a snapshot file.*/
+{
+  printf("Pet_CHE::write_snapshot(%s)...", file) ;
+
+  materialize();
+  Snapshot_writer w;
+
+  // the geometry is always stored as a vector of Vertex
+  vector<Vertex> g;
+  if( _soa )
+  {
+    g.resize( nvert() );
+    for(Vid v=0; v<nvert(); ++v) g[v] = _S.get(v);
+  }
+  w.add( "G", _soa ? g : _G );
+  write_tables( w );
+
+  if( !w.write( file, "CHE", snapshot_level() ) ) { printf(" cannot write the file.\n" ); return false; }
+
+  printf(" level %d written\n", snapshot_level() ) ;
+  return true;
+}
+//--------------------------------------------------//
+bool CHE_L0::read_snapshot( const char* file )
+//--------------------------------------------------//
+/** Reads the tables of the structure from a snapshot file.*/
+{
+  printf("Pet_CHE::read_snapshot(%s)...", file) ;
+
+  clear();
+
+  Snapshot_reader r;
+  bool ok = r.open( file, "CHE" ) && r.level() >= snapshot_level();
+  if( ok )
+  {
+    if( _soa )
+    {
+      vector<Vertex> g;
+      ok = r.get( "G", g );
+      _S.resize( (int)g.size() );
+      for(Vid v=0; v<(Vid)g.size(); ++v) _S.set( v, g[v] );
+    }
+    else ok = r.get( "G", _G );
+  }
+  ok = ok && read_tables( r );
+  ok = ok && ( _soa ? _S.size() : (int)_G.size() ) == nvert() && (TRid)_V.size() == 3*ntrig();
+
+  if( !ok )
+  {
+    printf(" not a valid snapshot of this level.\n" );
+    clear();
+    return false;
+  }
+
+  printf(" %d vertices and %d triangles found\n", nvert(), ntrig() ) ;
+  return true;
+}
+//--------------------------------------------------//
+void CHE_L0::write_tables( Snapshot_writer &w ) const
+//--------------------------------------------------//
+/** Adds the number of vertices and triangles and the vertex table.*/
+{
+  w.add_value( "NV", _nvert );
+  w.add_value( "NT", _ntrig );
+  w.add( "V", _V );
+}
+//--------------------------------------------------//
+bool CHE_L0::read_tables( const Snapshot_reader &r )
+//--------------------------------------------------//
+/** Reads the number of vertices and triangles and the vertex table.*/
+{
+  return r.get_value( "NV", _nvert ) && r.get_value( "NT", _ntrig ) && r.get( "V", _V );
+}
+//--------------------------------------------------//
+void CHE_L0::reorder( vector<Vid> &vorder, vector<TRid> &torder, const bool hilbert )
+//--------------------------------------------------//
+/** Sorts the vertices and the triangles by their keys along a space filling curve.*/
+{
+  const Vid  nv = nvert();
+  const TRid nt = ntrig();
+
+  vorder.clear();
+  torder.clear();
+  if( nv == 0 ) return;
+
+  cout << "Pet_CHE::reorder...  " ;
+
+  // box of the valid vertices: the removed ones would stretch the grid
+  double min[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for(Vid v=0; v<nv; ++v)
+  {
+    if( !v_valid(v) ) continue;
+    const double p[3] = { x(v), y(v), z(v) };
+    for(int k=0; k<3; ++k) { if( p[k] < min[k] ) min[k] = p[k]; if( p[k] > max[k] ) max[k] = p[k]; }
+  }
+  const Space_curve curve( min, max, hilbert );
+
+  // vertex keys, the ids break the ties and the removed vertices go to the end
+  vector< pair<uint64_t,Vid> > vk( nv );
+  #pragma omp parallel for schedule(static)
+  for(Vid v=0; v<nv; ++v) vk[v] = make_pair( v_valid(v) ? curve.key( x(v), y(v), z(v) ) : ~(uint64_t)0, v );
+  sort( vk.begin(), vk.end() );
+
+  // triangle keys from the centroids, the invalid triangles go to the end
+  vector< pair<uint64_t,TRid> > tk( nt );
+  #pragma omp parallel for schedule(static)
+  for(TRid t=0; t<nt; ++t)
+  {
+    const Vid a = _V[3*t], b = _V[3*t+1], c = _V[3*t+2];
+    if( a < 0 || b < 0 || c < 0 || a >= nv || b >= nv || c >= nv ) { tk[t] = make_pair( ~(uint64_t)0, t ); continue; }
+    tk[t] = make_pair( curve.key( ( x(a)+x(b)+x(c) ) / 3, ( y(a)+y(b)+y(c) ) / 3, ( z(a)+z(b)+z(c) ) / 3 ), t );
+  }
+  sort( tk.begin(), tk.end() );
+
+  vector<Vid>  vnew( nv );
+  vector<TRid> tnew( nt );
+  vorder.resize( nv );
+  torder.resize( nt );
+  for(Vid  i=0; i<nv; ++i) { vorder[i] = vk[i].second; vnew[ vorder[i] ] = i; }
+  for(TRid i=0; i<nt; ++i) { torder[i] = tk[i].second; tnew[ torder[i] ] = i; }
+
+  remap( vnew, tnew );
+
+  cout << " done." << endl;
+}
+//--------------------------------------------------//
+/** \brief Numbers the kept entries of a table by a parallel prefix sum:
+  * id[i] is 1 to keep the entry i and 0 to drop it, and becomes its new
+  * id, or -1. Returns the number of kept entries.
+  * \param id - vector<int>& */
+static int compact_ids( vector<int> &id )
+//--------------------------------------------------//
+{
+  const int n   = (int)id.size();
+  int nth = 1;
+  vector<int> sum;
+
+  #pragma omp parallel num_threads( par_nthreads() )
+  {
+    // the chunks follow the threads granted, not the ones requested
+    #pragma omp single
+    {
+      nth = par_team_size();
+      sum.assign( nth+1, 0 );
+    }
+
+    const int t  = par_thread();
+    const int c0 = (int)( (long long)n* t   /nth );
+    const int c1 = (int)( (long long)n*(t+1)/nth );
+
+    int c = 0;
+    for(int i=c0; i<c1; ++i) c += id[i];
+    sum[t+1] = c;
+
+    #pragma omp barrier
+    #pragma omp single
+    for(int k=0; k<nth; ++k) sum[k+1] += sum[k];
+
+    c = sum[t];
+    for(int i=c0; i<c1; ++i) id[i] = id[i] ? c++ : -1;
+  }
+  return sum[nth];
+}
+//--------------------------------------------------//
+void CHE_L0::compact( vector<Vid> &vnew, vector<TRid> &tnew )
+//--------------------------------------------------//
+/** Removes the invalid vertices and triangles, keeping the order of the others.*/
+{
+  const Vid  nv = nvert();
+  const TRid nt = ntrig();
+
+  cout << "Pet_CHE::compact...  " ;
+
+  vnew.resize( nv );
+  tnew.resize( nt );
+  #pragma omp parallel for schedule(static)
+  for(Vid v=0; v<nv; ++v) vnew[v] = CHE_L0::v_valid( v ) ? 1 : 0;
+  #pragma omp parallel for schedule(static)
+  for(TRid t=0; t<nt; ++t)
+  {
+    tnew[t] = 1;
+    for(int j=0; j<3; ++j)
+      if( _V[3*t+j] == INV || !CHE_L0::v_valid( _V[3*t+j] ) ) tnew[t] = 0;
+  }
+  const Vid  mv = compact_ids( vnew );
+  const TRid mt = compact_ids( tnew );
+
+  if( mv < nv || mt < nt ) remap( vnew, tnew );
+
+  cout << " " << nv-mv << " vertices and " << nt-mt << " triangles removed." << endl;
+}
+//--------------------------------------------------//
+void CHE_L0::remap( const vector<Vid> &vnew, const vector<TRid> &tnew )
+//--------------------------------------------------//
+/** Permutes the geometry and the vertex table, dropping the elements of new id -1.*/
+{
+  const Vid  nv = (Vid) vnew.size();
+  const TRid nt = (TRid)tnew.size();
+
+  // number of kept elements: all of them for a permutation
+  Vid  mv = 0;
+  TRid mt = 0;
+  #pragma omp parallel for reduction(+:mv)
+  for(Vid  v=0; v<nv; ++v) if( vnew[v] >= 0 ) ++mv;
+  #pragma omp parallel for reduction(+:mt)
+  for(TRid t=0; t<nt; ++t) if( tnew[t] >= 0 ) ++mt;
+
+  if( _soa )
+  {
+    VertexSoA s;
+    s.resize( mv );
+    #pragma omp parallel for schedule(static)
+    for(Vid v=0; v<nv; ++v) if( vnew[v] >= 0 ) s.set( vnew[v], _S.get(v) );
+    _S.swap( s );
+  }
+  else
+  {
+    vector<Vertex> g( mv );
+    #pragma omp parallel for schedule(static)
+    for(Vid v=0; v<nv; ++v) if( vnew[v] >= 0 ) g[ vnew[v] ] = _G[v];
+    _G.swap( g );
+  }
+
+  vector<Vid> V( 3*mt );
+  #pragma omp parallel for schedule(static)
+  for(TRid t=0; t<nt; ++t)
+  {
+    if( tnew[t] < 0 ) continue;
+    for(int j=0; j<3; ++j)
+    {
+      const Vid v = _V[3*t+j];
+      V[ 3*tnew[t]+j ] = ( v >= 0 && v < nv ) ? vnew[v] : v;
+    }
+  }
+  _V.swap( V );
+
+  _nvert = mv;
+  _ntrig = mt;
+
+  // the normals are permuted with the geometry, but the vertex to
+  // triangle index refers to the old ids: update_normals rebuilds it
+  _NO.clear(); _NT.clear(); _FN.clear(); _ND.clear(); _NDL.clear(); _ndn = 0; _HI.clear();
+}
+//--------------------------------------------------//
+void CHE_L0::take( CHE_L0 &c )
+//--------------------------------------------------//
+/** Swaps the tables with c and leaves c empty.*/
+{
+  _nvert = c._nvert;  c._nvert = 0;
+  _ntrig = c._ntrig;  c._ntrig = 0;
+  _soa   = c._soa;    c._soa   = false;
+
+  _V.swap( c._V );  c._V.clear();
+  _G.swap( c._G );  c._G.clear();
+  _S.swap( c._S );  c._S.clear();
+
+  _NO.swap( c._NO ); _NT.swap( c._NT ); _FN.swap( c._FN ); _ND.swap( c._ND ); _NDL.swap( c._NDL );
+  c._NO.clear(); c._NT.clear(); c._FN.clear(); c._ND.clear(); c._NDL.clear();
+  _ndn = c._ndn;  c._ndn = 0;
+  _HI.swap( c._HI ); c._HI.clear();
+}
+//--------------------------------------------------//
+void CHE_L0::clear()
+//--------------------------------------------------//
+/** Clears the vertex and geometry tables and the normal engine.*/
+{
+  _nvert = 0;
+  _ntrig = 0;
+  _V.clear();  _G.clear();  _S.clear();
+  _NO.clear(); _NT.clear(); _FN.clear(); _ND.clear(); _NDL.clear(); _ndn = 0;
+  _HI.clear();
+}
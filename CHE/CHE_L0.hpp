@@ -24,6 +24,14 @@
 
 #include "Vertex.hpp"
 
+#include "Geometry.hpp"
+
+#include "../common/Parallel.hpp"
+
+class Snapshot_writer;
+
+class Snapshot_reader;
+
 
 
 /** \brief Invalid integer*/
@@ -103,6 +111,24 @@ protected:
 
   
 
+  /** \brief Geometry table, structure of arrays layout
+
+    * 
+
+    * Used instead of _G when the mesh is set to the
+
+    * structure of arrays layout (see set_layout)*/
+
+  VertexSoA      _S;
+
+
+
+  /** \brief True if the geometry is stored in _S*/
+
+  bool           _soa;
+
+  
+
   /** \brief Vertices table 
 
     * 
@@ -115,6 +141,42 @@ protected:
 
 
 
+  /** \brief Normal engine: offsets of the triangles of each vertex in _NT (nvert+1)*/
+
+  vector<int>    _NO;
+
+  /** \brief Normal engine: triangles incident to each vertex, by vertex*/
+
+  vector<TRid>   _NT;
+
+  /** \brief Normal engine: unnormalized normal of each triangle (3 per triangle)*/
+
+  vector<double> _FN;
+
+  /** \brief Normal engine: true for the vertices moved since the last normal update*/
+
+  vector<int>    _ND;
+
+  /** \brief Normal engine: list of the vertices marked in _ND, in its first
+
+    * _ndn entries (sized to nvert, so that threads append without locking)*/
+
+  vector<Vid>    _NDL;
+
+  /** \brief Normal engine: number of vertices in _NDL*/
+
+  int            _ndn;
+
+
+
+  /** \brief Half-edge index: the valid half-edges sorted by vertex, then by
+
+    * the vertex of their next (edge key), then by id (empty if not built)*/
+
+  vector<HEid>   _HI;
+
+
+
 
 
 public:
@@ -127,7 +189,7 @@ public:
 
     * _nvert= 0 and _ntrig= 0.*/
 
-  CHE_L0(): _nvert(0), _ntrig(0) {}
+  CHE_L0(): _nvert(0), _ntrig(0), _soa(false), _ndn(0) {}
 
   
 
@@ -145,7 +207,7 @@ public:
 
     * \param ntrig - TRid CHE_L0 _ntrig.*/
 
-  CHE_L0(Vid nvert, TRid ntrig): _nvert(nvert), _ntrig(ntrig){ _V.resize( 3*ntrig, -1 ); _G.resize( nvert ); }
+  CHE_L0(Vid nvert, TRid ntrig): _nvert(nvert), _ntrig(ntrig), _soa(false), _ndn(0){ _V.resize( 3*ntrig, -1 ); _G.resize( nvert ); }
 
   
 
@@ -159,7 +221,7 @@ public:
 
     * \param c - CHE_L0&.*/
 
-  CHE_L0(const CHE_L0& c): _nvert( c.nvert() ), _ntrig( c.ntrig() ) { _V= c._V; _G=c._G; }
+  CHE_L0(const CHE_L0& c): _nvert( c.nvert() ), _ntrig( c.ntrig() ), _soa( c._soa ), _ndn(0) { _V= c._V; _G=c._G; _S=c._S; }
 
 
 
@@ -169,7 +231,7 @@ public:
 
     * Frees the memory used by _V and _G*/
 
-  virtual ~CHE_L0(){ _V.clear(); _G.clear(); }
+  virtual ~CHE_L0(){ _V.clear(); _G.clear(); _S.clear(); }
 
 
 
@@ -191,7 +253,7 @@ public:
 
     * \param const Vid v*/
 
-	inline const bool  v_valid( const  Vid v )  const { return (v >= 0 && v<nvert() && (Vertex)_G[v]!= V_INV); }
+	inline const bool  v_valid( const  Vid v )  const { return (v >= 0 && v<nvert() && ( _soa ? !_S.equals(v, V_INV) : (Vertex)_G[v]!= V_INV )); }
 
  	
 
@@ -211,19 +273,75 @@ public:
 
 
 
-  /** \breaf Access to the geometry of a vertex in the model 
+  /** \breaf Copy of the geometry of a vertex in the model 
+
+    *
+
+    * The geometry is modified through set_G or the set_* 
+
+    * accessors below, which write to either layout.
 
 	  * \param const Vid v*/
 
-	inline const Vertex G( const Vid  v ) const { if( !v_valid(v)  ) return V_INV;  return _G[v] ; }
+	inline const Vertex G( const Vid  v ) const { if( !v_valid(v)  ) return V_INV;  return _soa ? _S.get(v) : _G[v] ; }
 
-  
 
-  /** \breaf Access to the geometry of a vertex in the model 
+
+  /** \brief Copy of the geometry of a vertex, in any layout
 
 	  * \param const Vid v*/
 
-	inline Vertex &G( const Vid  v ) { if( !v_valid(v)  ) return V_INV;  return _G[v] ; }
+	inline const Vertex vertex( const Vid v ) const { return G(v); }
+
+
+
+  /** \brief True if the geometry uses the structure of arrays layout*/
+
+  inline const bool soa() const { return _soa; }
+
+
+
+  /** \brief Coordinate x of a valid vertex
+
+	  * \param const Vid v*/
+
+  inline const double x ( const Vid v ) const { return _soa ? _S.x [v] : _G[v].x (); }
+
+  /** \brief Coordinate y of a valid vertex
+
+	  * \param const Vid v*/
+
+  inline const double y ( const Vid v ) const { return _soa ? _S.y [v] : _G[v].y (); }
+
+  /** \brief Coordinate z of a valid vertex
+
+	  * \param const Vid v*/
+
+  inline const double z ( const Vid v ) const { return _soa ? _S.z [v] : _G[v].z (); }
+
+  /** \brief Normal coordinate x of a valid vertex
+
+	  * \param const Vid v*/
+
+  inline const double nx( const Vid v ) const { return _soa ? ( VertexSoA::attr ? _S.nx[v] : 0 ) : _G[v].nx(); }
+
+  /** \brief Normal coordinate y of a valid vertex
+
+	  * \param const Vid v*/
+
+  inline const double ny( const Vid v ) const { return _soa ? ( VertexSoA::attr ? _S.ny[v] : 0 ) : _G[v].ny(); }
+
+  /** \brief Normal coordinate z of a valid vertex
+
+	  * \param const Vid v*/
+
+  inline const double nz( const Vid v ) const { return _soa ? ( VertexSoA::attr ? _S.nz[v] : 0 ) : _G[v].nz(); }
+
+  /** \brief Scalar field of a valid vertex
+
+	  * \param const Vid v*/
+
+  inline const double field( const Vid v ) const { return _soa ? ( VertexSoA::attr ? _S.field[v] : 0 ) : _G[v].field(); }
 
 
 
@@ -257,7 +375,7 @@ public:
 
     * \param const Vid v */
 
-	inline const void v_invalid ( const   Vid v ){ if( v_valid(v) ) _G[v]= V_INV; return; }
+	inline const void v_invalid ( const   Vid v ){ if( v_valid(v) ) { if( _soa ) _S.set(v, V_INV); else _G[v]= V_INV; touch_vertex(v); } return; }
 
  	
 
@@ -265,7 +383,7 @@ public:
 
     * \param const HEid h  */
 
-	inline const void he_invalid( const  HEid h ){ if( he_valid(h) ) _V[h]= INV; return;}
+	inline const void he_invalid( const  HEid h ){ if( he_valid(h) ) { _V[h]= INV; _NO.clear(); _HI.clear(); } return;}
 
 
 
@@ -283,7 +401,53 @@ public:
 
     * \param Vertex p*/
 
-	inline const void set_G( const Vid  v, Vertex p ) { if(v>=0 && v<nvert()) _G[v]=p ; }
+	inline const void set_G( const Vid  v, Vertex p ) { if(v>=0 && v<nvert()) { if( _soa ) _S.set(v, p); else _G[v]=p ; touch_vertex(v); } }
+
+
+
+  /** \brief Sets the position of a vertex
+
+	  * \param const Vid v  
+
+    * \param x, y, z - const double*/
+
+	inline const void set_position( const Vid v, const double x, const double y, const double z ) 
+
+  { if( _soa ) { _S.x[v]=x; _S.y[v]=y; _S.z[v]=z; } else { _G[v].set_x(x); _G[v].set_y(y); _G[v].set_z(z); } touch_vertex(v); }
+
+
+
+  /** \brief Sets the normal of a vertex
+
+	  * \param const Vid v  
+
+    * \param nx, ny, nz - const double*/
+
+	inline const void set_normal( const Vid v, const double nx, const double ny, const double nz ) 
+
+  { if( _soa ) { if( VertexSoA::attr ) { _S.nx[v]=nx; _S.ny[v]=ny; _S.nz[v]=nz; } } else { _G[v].set_nx(nx); _G[v].set_ny(ny); _G[v].set_nz(nz); } }
+
+
+
+  /** \brief Sets the scalar field of a vertex
+
+	  * \param const Vid v  
+
+    * \param f - const double*/
+
+	inline const void set_field( const Vid v, const double f ) { if( _soa ) { if( VertexSoA::attr ) _S.field[v]=f; } else _G[v].set_field(f); }
+
+
+
+  /** \brief Selects the layout of the geometry table: 
+
+    * a vector of Vertex (false) or one aligned array per 
+
+    * coordinate (true). The geometry is moved to the new layout.
+
+	  * \param soa - const bool*/
+
+  void set_layout( const bool soa );
 
 
 
@@ -293,7 +457,7 @@ public:
 
     * \param Vid v*/
 
-	inline const void set_V( const  HEid h, Vid v ) { if( h>=0 && h<3*ntrig()) _V[h]=v ; }
+	inline const void set_V( const  HEid h, Vid v ) { if( h>=0 && h<3*ntrig()) { _V[h]=v ; _NO.clear(); _HI.clear(); } }
 
 
 
@@ -357,12 +521,92 @@ public:
 
 
 
+	/** \brief Builds the half-edge index: the queries above then find the
+
+	  * half-edges of a vertex or of an edge in O(log n) instead of scanning
+
+	  * the mesh, for 4 bytes per half-edge (the opposite table of level 1
+
+	  * costs as much, and is much longer to build). The index is dropped
+
+	  * when the vertex table changes.*/
+
+	void build_index () ;
+
+	/** \brief Frees the half-edge index*/
+
+	inline void clear_index () { vector<HEid>().swap( _HI ); }
+
+	/** \brief Tests if the half-edge index is built*/
+
+	inline const bool has_index () const { return !_HI.empty(); }
+
+
+
 public:
 
-	/** \brief Computes the normal of each triangle*/
+	/** \brief Computes the normal of each vertex
+
+	  *
+
+	  * Each vertex normal is the normalized sum of the unnormalized
+
+	  * (area weighted) normals of its triangles. The triangle normals
+
+	  * and the per-vertex gather run in parallel, without atomics,
+
+	  * using a vertex to triangle index that is kept for update_normals.*/
 
 	void compute_normals () ;
 
+	/** \brief Recomputes the normals of the vertices moved since the
+
+	  * last computation (see touch_vertex) and of their neighbours.
+
+	  * Falls back to compute_normals when the connectivity changed.*/
+
+	void update_normals () ;
+
+	/** \brief Marks a vertex as moved for update_normals.
+
+	  * Called by set_G and set_position, from several threads if needed.
+
+	  * \param v - const Vid */
+
+	inline const void touch_vertex( const Vid v ) { if( v>=0 && v<(Vid)_ND.size() && !_ND[v] && par_cas( &_ND[v], 0, 1 ) ) _NDL[ par_fetch_add( &_ndn, 1 ) ] = v; }
+
+	/** \brief Reorders the vertices and the triangles along a space filling
+
+	  * curve of their positions (the centroid for the triangles), so that
+
+	  * neighbourhood traversals access close ids. The tables of all the
+
+	  * levels are remapped; the half-edges of a triangle keep their order.
+
+	  * \param vorder - vector<Vid>&   old id of each new vertex
+
+	  * \param torder - vector<TRid>&  old id of each new triangle
+
+	  * \param hilbert= true - const bool  Hilbert curve, else Morton order*/
+
+	void reorder( vector<Vid> &vorder, vector<TRid> &torder, const bool hilbert = true );
+
+	/** \brief Squeezes out the invalid vertices and triangles (tombstones
+
+	  * left by v_invalid, tr_invalid and the edition operators): the
+
+	  * remaining ones keep their relative order, and the tables of all the
+
+	  * levels are renumbered. The opposites of the removed half-edges must
+
+	  * have been updated, otherwise their mates become boundary.
+
+	  * \param vnew - vector<Vid>&   new id of each old vertex, -1 if removed
+
+	  * \param tnew - vector<TRid>&  new id of each old triangle, -1 if removed*/
+
+	void compact( vector<Vid> &vnew, vector<TRid> &tnew );
+
   /** \brief Gets the model bouding_box
 
     * \param min - float*.
@@ -417,6 +661,128 @@ public:
 
   void write_ply( const char* file, bool bin=false );
 
+	/** \brief Writes the tables of the structure in a binary snapshot,
+
+	  * that read_snapshot loads without rebuilding anything
+
+	  * \param file - const char* */
+
+  bool write_snapshot( const char* file );
+
+	/** \brief Reads a snapshot written by write_snapshot at this level
+
+	  * or at a higher one. Returns false if the file is not a valid
+
+	  * snapshot; the mesh is then left empty.
+
+	  * \param file - const char* */
+
+  bool read_snapshot ( const char* file );
+
+	/** \brief Empties the structure: the tables of every level are
+
+	  * cleared, the layout of the geometry is kept*/
+
+  virtual void clear();
+
+protected:
+
+	/** \brief Level of the structure, stored in the snapshots*/
+
+  virtual const int snapshot_level() const { return 0; }
+
+	/** \brief Adds the tables of the level (except the geometry) to a snapshot
+
+	  * \param w - Snapshot_writer& */
+
+  virtual void write_tables( Snapshot_writer &w ) const;
+
+	/** \brief Reads the tables of the level (except the geometry) from a snapshot
+
+	  * \param r - const Snapshot_reader& */
+
+  virtual bool read_tables ( const Snapshot_reader &r );
+
+	/** \brief Applies a permutation of the vertices and of the triangles
+
+	  * to the tables of the level; the elements of new id -1 are dropped
+
+	  * \param vnew - const vector<Vid>&   new id of each vertex
+
+	  * \param tnew - const vector<TRid>&  new id of each triangle*/
+
+  virtual void remap( const vector<Vid> &vnew, const vector<TRid> &tnew );
+
+	/** \brief New id of a half-edge after a triangle permutation, -1 if
+
+	  * its triangle is dropped
+
+	  * \param h    - const HEid
+
+	  * \param tnew - const vector<TRid>& */
+
+  static inline HEid remap_he( const HEid h, const vector<TRid> &tnew ) { return h < 0 ? h : ( tnew[h/3] < 0 ? -1 : 3*tnew[h/3] + h%3 ); }
+
+
+
+	/** \brief Takes the tables of c, which is left empty: used by the
+
+	  * promotion constructors of the upper levels instead of a copy
+
+	  * \param c - CHE_L0& */
+
+  void take( CHE_L0 &c );
+
+	/** \brief Computes the tables that a promoted level builds on demand
+
+	  * (called before writing a snapshot)*/
+
+  virtual void materialize() {}
+
+	/** \brief First position in the half-edge index of the half-edges from a
+
+	  * to b (b = INV for all the half-edges of a)
+
+	  * \param a - const Vid
+
+	  * \param b - const Vid */
+
+  const int index_lower( const Vid a, const Vid b ) const;
+
+	/** \brief Reads the vertices and triangles of a .ply file and
+
+	  * legalizes the model, without computing the normals.
+
+	  * Returns false if the file could not be opened.
+
+	  * \param file - const char* */
+
+  bool  load_ply( const char* file );
+
+	/** \brief Fast path of load_ply for binary little endian and ascii
+
+	  * files: maps the file and converts the blocks in bulk, or parses
+
+	  * the ascii body by chunks in parallel. Returns false
+
+	  * if the file has to be read by the generic ply reader.
+
+	  * \param file - const char* */
+
+  bool  load_ply_mmap( const char* file );
+
+	/** \brief Computes the unnormalized normals of the triangles t0 to t1-1 in _FN
+
+	  * \param t0, t1 - const TRid */
+
+	void face_normals ( const TRid t0, const TRid t1 ) ;
+
+	/** \brief Sums the triangle normals of a vertex and normalizes the result
+
+	  * \param v - const Vid */
+
+	void gather_normal( const Vid v ) ;
+
 };
 
 #endif
@@ -14,43 +14,35 @@
 #include <ctime>
 
 #include <stack>
+#include <algorithm>
 
 #include "CHE_L1.hpp"
+#include "../common/Parallel.hpp"
+#include "../common/Snapshot.hpp"
 
 
 
 using namespace std;
 
+//--------------------------------------------------//
+/** Hash partition of the edge (a,b), a < b */
+static inline int edge_partition( const Vid a, const Vid b, const int np )
+//--------------------------------------------------//
+{
+  unsigned int k = (unsigned int)a * 2654435761u ^ (unsigned int)b * 2246822519u;
+  return (int)( (k ^ (k >> 15)) % (unsigned int)np );
+}
 //--------------------------------------------------//
 vector<Vid> CHE_L1::R_00(const Vid v)
 //--------------------------------------------------//
 /** Computes the vertices in the star of a given vertex.*/
 {
   vector<Vid> star;
+  Star_collector<Vid> f( star );
 
-  if( !v_valid(v) ) { 
+  if( !visit_R_00( v, f ) ) { 
     cout << "CHE_L1::Vertex Star ERROR: invalid vertex id" << endl;
     star.push_back(INV); 
-    return star; 
-  }
-
-  HEid h = 0, h0 = 0;
-  
-  //Gets the first incident half--edge
-  for(HEid i=0; i<3*ntrig(); ++i)
-    if( V(i) == v ) { h0 = h = i; break; }
-  
-  //Walks through the first wise.  
-  do 
-    star.push_back( V(next(h)) );
-  while( (O(h) != -1) && ( (h = next(O(h))) != h0) );
-
-  //Walks through the second wise.
-  if( h != h0 ){
-   h = h0;
-   do
-     star.push_back( V(prev(h)) );
-   while( (h = O(prev(h))) != -1 );
   }
   return star;
 }
@@ -59,30 +51,12 @@ vector<TRid> CHE_L1::R_02(const Vid v)
 //--------------------------------------------------//
 /** Computes the triangles in the star of a given vertex.*/
 {
-  vector<Vid> star;
+  vector<TRid> star;
+  Star_collector<TRid> f( star );
   
-  if( !v_valid(v) ) { 
+  if( !visit_R_02( v, f ) ) { 
     cout << "CHE_L1::Vertex Star ERROR: invalid vertex id" << endl;
     star.push_back(INV); 
-    return star; 
-  }
-
-  HEid h = 0, h0 = 0;
-  
-  //Gets the first incident half--edge
-  for(HEid i=0; i<3*ntrig(); ++i)
-    if( V(i) == v ) { h0 = h = i; break; }
-  
-  //Walks through the first wise.  
-  do 
-    star.push_back( trig(h) );
-  while( (O(h) != -1) && ( (h = next(O(h))) != h0) );
-
-  //Walks through the second wise.
-  if( h != h0 ){
-   h = h0;
-   while( (h = O(prev(h))) != -1 );
-      star.push_back( trig(h) );
   }
   return star;
 }
@@ -148,6 +122,172 @@ vector<TRid> CHE_L1::R_22(const TRid t)
 void CHE_L1::compute_opposites()
 //--------------------------------------------------//
 /** Computes the opposite of each half-edge.*/
+{
+  if( par_nthreads() > 1 ) compute_opposites_parallel();
+  else                     compute_opposites_radix();
+}
+//--------------------------------------------------//
+void CHE_L1::compute_opposites_radix()
+//--------------------------------------------------//
+/** Computes the opposite of each half-edge sorting the
+  * keys (min,max) of the edges with two counting sorts.*/
+{
+  if( _V.size() == 0 && _G.size() == 0 ) return;	
+
+  cout << "Pet_CHE::compute_opposites...  " ;
+
+  const HEid nhe = 3*ntrig();
+
+  _O.clear();
+  _O.resize( nhe, -1 );
+
+  /** pos: bucket positions, tmp: sorted by max, srt: sorted by (min,max)*/
+  vector<HEid> pos( nvert()+1, 0 ), tmp( nhe ), srt( nhe );
+  HEid n = 0;
+
+  /** First pass: stable counting sort by the greatest vertex*/
+  for( HEid c = 0 ; c < nhe ; ++c )
+  {
+    Vid a = _V[c], b = _V[3*(c/3) + (c+1)%3];
+    if( a < 0 || b < 0 || a >= nvert() || b >= nvert() ) continue;
+    ++pos[ (a < b ? b : a) + 1 ];
+  }
+  for( Vid v = 0 ; v < nvert() ; ++v ) pos[v+1] += pos[v];
+
+  for( HEid c = 0 ; c < nhe ; ++c )
+  {
+    Vid a = _V[c], b = _V[3*(c/3) + (c+1)%3];
+    if( a < 0 || b < 0 || a >= nvert() || b >= nvert() ) continue;
+    tmp[ pos[ a < b ? b : a ]++ ] = c;
+    ++n;
+  }
+
+  /** Second pass: stable counting sort by the smallest vertex*/
+  fill( pos.begin(), pos.end(), 0 );
+  for( HEid i = 0 ; i < n ; ++i )
+  {
+    HEid c = tmp[i];
+    Vid  a = _V[c], b = _V[3*(c/3) + (c+1)%3];
+    ++pos[ (a < b ? a : b) + 1 ];
+  }
+  for( Vid v = 0 ; v < nvert() ; ++v ) pos[v+1] += pos[v];
+
+  for( HEid i = 0 ; i < n ; ++i )
+  {
+    HEid c = tmp[i];
+    Vid  a = _V[c], b = _V[3*(c/3) + (c+1)%3];
+    srt[ pos[ a < b ? a : b ]++ ] = c;
+  }
+
+  /** Matches consecutive half-edges with the same key,
+    * pairing them in increasing order as the map does*/
+  for( HEid i = 0 ; i+1 < n ; ++i )
+  {
+    HEid c = srt[i], d = srt[i+1];
+    Vid  a = _V[c], b = _V[3*(c/3) + (c+1)%3];
+    Vid  e = _V[d], f = _V[3*(d/3) + (d+1)%3];
+
+    if( (a < b ? a : b) != (e < f ? e : f) || (a < b ? b : a) != (e < f ? f : e) ) continue;
+
+    _O[c] = d;
+    _O[d] = c;
+    ++i;
+  }
+  
+  cout << " done." << endl;
+}
+//--------------------------------------------------//
+void CHE_L1::compute_opposites_parallel()
+//--------------------------------------------------//
+/** Computes the opposite of each half-edge, matching the
+  * half-edges of each hash partition in a different thread.*/
+{
+  if( _V.size() == 0 && _G.size() == 0 ) return;	
+
+  cout << "Pet_CHE::compute_opposites...  " ;
+
+  typedef unsigned long long     Key;
+  typedef pair<Key,HEid>     KeyHE;
+
+  const HEid nhe = 3*ntrig();
+  int        nth = 1;       /** threads of the team*/
+  int        np  = 8;       /** more partitions than threads balances the load*/
+
+  _O.clear();
+  _O.resize( nhe, -1 );
+
+  /** cnt[p*nth+t]: position of the half-edges of partition p in the chunk of thread t*/
+  vector<HEid>  cnt;
+  vector<KeyHE> buf;
+
+  #pragma omp parallel num_threads( par_nthreads() )
+  {
+    /** The chunks follow the threads granted, not the ones requested*/
+    #pragma omp single
+    {
+      nth = par_team_size();
+      np  = 8*nth;
+      cnt.assign( np*nth+1, 0 );
+    }
+
+    const int  t  = par_thread();
+    const HEid c0 = (HEid)( (long long)nhe* t   /nth );
+    const HEid c1 = (HEid)( (long long)nhe*(t+1)/nth );
+
+    /** Counts the half-edges of each partition in the chunk*/
+    for( HEid c = c0 ; c < c1 ; ++c )
+    {
+      Vid a = _V[c], b = _V[3*(c/3) + (c+1)%3];
+      if( a < 0 || b < 0 || a >= nvert() || b >= nvert() ) continue;
+      if( b < a ) { Vid tmp = a ; a = b ; b = tmp ; }
+      ++cnt[ edge_partition( a, b, np )*nth + t + 1 ];
+    }
+
+    #pragma omp barrier
+    #pragma omp single
+    {
+      for( int i = 0 ; i < np*nth ; ++i ) cnt[i+1] += cnt[i];
+      buf.resize( cnt[np*nth] );
+    }
+
+    /** Scatters the keys: partitions are contiguous, chunks in order*/
+    for( HEid c = c0 ; c < c1 ; ++c )
+    {
+      Vid a = _V[c], b = _V[3*(c/3) + (c+1)%3];
+      if( a < 0 || b < 0 || a >= nvert() || b >= nvert() ) continue;
+      if( b < a ) { Vid tmp = a ; a = b ; b = tmp ; }
+      HEid &k = cnt[ edge_partition( a, b, np )*nth + t ];
+      buf[k++] = KeyHE( ((Key)a << 32) | (Key)(unsigned int)b, c );
+    }
+
+    #pragma omp barrier
+
+    /** Matches each partition. After the scatter cnt[i] holds
+      * the end of slot i, so partition p spans cnt[p*nth-1] to cnt[p*nth+nth-1]*/
+    #pragma omp for schedule(dynamic)
+    for( int p = 0 ; p < np ; ++p )
+    {
+      HEid b0 = (p == 0) ? 0 : cnt[p*nth-1];
+      HEid b1 = cnt[p*nth+nth-1];
+
+      sort( buf.begin()+b0, buf.begin()+b1 );
+
+      for( HEid i = b0 ; i+1 < b1 ; ++i )
+      {
+        if( buf[i].first != buf[i+1].first ) continue;
+        _O[ buf[i].second   ] = buf[i+1].second;
+        _O[ buf[i+1].second ] = buf[i].second;
+        ++i;
+      }
+    }
+  }
+  
+  cout << " done." << endl;
+}
+//--------------------------------------------------//
+void CHE_L1::compute_opposites_map()
+//--------------------------------------------------//
+/** Computes the opposite of each half-edge using a map.*/
 {
   if( _V.size() == 0 && _G.size() == 0 ) return;	
 
@@ -194,6 +334,8 @@ void CHE_L1::compute_connected()
 {
   if( _V.size() == 0 && _G.size() == 0 ) return;	
 
+  if( par_nthreads() > 1 ) { compute_connected_parallel(); return; }
+
   cout << "Pet_CHE::compute_bounds...  " ;
 
   _C.clear () ;
@@ -260,7 +402,9 @@ void CHE_L1::compute_connected()
   {
    if( !v_valid(v) ) continue;
 
-    Cid b= get_component( v );
+    /** The paths are already compressed: C(v) is the root, while
+      * get_component would follow the ids relabeled in this loop*/
+    Cid b= C( v );
     if(b<0) continue;
 
     set_C( v, m[b]);        
@@ -270,6 +414,88 @@ void CHE_L1::compute_connected()
   cout <<" "<< ncomp() << " connected compound(s) found." << endl;
 }
 //--------------------------------------------------//
+/** Root of x in the concurrent union-find p, with path halving*/
+static inline Cid uf_find( Cid *p, Cid x )
+//--------------------------------------------------//
+{
+  Cid px = p[x];
+  while( px != x )
+  {
+    Cid gx = p[px];
+    if( gx != px ) par_cas( &p[x], px, gx );
+    x  = px;
+    px = p[x];
+  }
+  return x;
+}
+//--------------------------------------------------//
+/** Merges the sets of a and b, the smallest root becomes the parent*/
+static inline void uf_union( Cid *p, Cid a, Cid b )
+//--------------------------------------------------//
+{
+  for(;;)
+  {
+    a = uf_find( p, a );
+    b = uf_find( p, b );
+    if( a == b ) return;
+    if( a < b ) { Cid tmp = a ; a = b ; b = tmp ; }
+    if( par_cas( &p[a], a, b ) ) return;
+  }
+}
+//--------------------------------------------------//
+void CHE_L1::compute_connected_parallel()
+//--------------------------------------------------//
+/** Computes the compound of each vertex in parallel.*/
+{
+  if( _V.size() == 0 && _G.size() == 0 ) return;	
+
+  cout << "Pet_CHE::compute_bounds...  " ;
+
+  const Vid nv = nvert();
+
+  _C.clear () ;
+  _C.resize( nv, -1 ) ;
+
+  Cid *p = &_C[0];
+
+  #pragma omp parallel for
+  for( Vid v=0; v< nv; ++v)
+    p[v] = v;
+
+  #pragma omp parallel for schedule(dynamic,4096)
+  for( TRid j=0; j< ntrig(); ++j)
+  {
+    Vid a = _V[3*j], b = _V[3*j+1], c = _V[3*j+2];
+    if( !CHE_L0::v_valid(a) || !CHE_L0::v_valid(b) || !CHE_L0::v_valid(c) ) continue;
+
+    uf_union( p, a, b );
+    uf_union( p, a, c );
+  }
+
+  /** Each root is the smallest vertex of its compound, so that
+    * numbering the roots in order gives the same ids as compute_connected*/
+  #pragma omp parallel for
+  for( Vid v=0; v< nv; ++v)
+    p[v] = uf_find( p, v );
+
+  vector<Cid> id( nv, -1 );
+  set_nbound(0);
+  for( Vid v=0; v< nv; ++v)
+  {
+    if( !CHE_L0::v_valid(v) ) continue;
+    if( p[v] == v ) id[v] = _ncomp++;
+  }
+
+  #pragma omp parallel for
+  for( Vid v=0; v< nv; ++v)
+  {
+    if( !CHE_L0::v_valid(v) ) continue;
+    p[v] = id[ p[v] ];
+  }
+
+  cout <<" "<< ncomp() << " connected compound(s) found." << endl;
+}
+//--------------------------------------------------//
 void CHE_L1::check()
 //--------------------------------------------------//
 /** Checks the mesh.*/
@@ -295,6 +521,7 @@ void CHE_L1::check()
 
   for(int i=0; i<nvert(); ++i)
   {
+    if( !v_valid(i) ) continue;
     if(C(i) > ncomp() )
     {
       cout << "CHE_L1:: C("<< i << ") > nbound." << endl;
@@ -310,49 +537,233 @@ void CHE_L1::check()
 //--------------------------------------------------//
 void CHE_L1::orient()
 //--------------------------------------------------//
-/** Orients the mesh.*/
+/** Orients each compound of the mesh as its first triangle.*/
 {
   if( _V.size() == 0 && _G.size() == 0 ) return;	
 
+  if( par_nthreads() > 1 ) { orient_parallel(); return; }
+
   cout << "Pet_CHE::orient... " ;
 
   stack<HEid> s;
   vector<bool> visited; 
   visited.resize( ntrig(), false );
 
-  s.push( 0 ); s.push( 1 ); s.push( 2 );
-  visited[0] = true;
-
-  while( !s.empty() )
+  TRid nflip = 0;
+  for( TRid r=0; r< ntrig(); ++r)
   {
-    HEid h = s.top();
-    s.pop();
+    if( visited[r] ) continue;
+
+    s.push( 3*r ); s.push( 3*r+1 ); s.push( 3*r+2 );
+    visited[r] = true;
+
+    while( !s.empty() )
+    {
+      HEid h = s.top();
+      s.pop();
     
-    /** Avoid null edges*/
-    HEid o = O(h); 
-    if( o == -1 ) continue;
+      /** Avoid null edges*/
+      HEid o = O(h); 
+      if( o == -1 ) continue;
 
-    /** Avoid Loops*/
-    TRid t = trig(o);
-    if( visited[t] ) continue;
+      /** Avoid Loops*/
+      TRid t = trig(o);
+      if( visited[t] ) continue;
 
-    /** Repairs orientation*/
-    if( !orient_check(h,o) ) orient_change( t );
+      /** Repairs orientation*/
+      if( !orient_check(h,o) ) { orient_change( t ); ++nflip; }
 
-    /** Marks as visited*/
-    visited[t] = true;
+      /** Marks as visited*/
+      visited[t] = true;
 
-    /** Push half-edges of t*/
-    s.push( 3*t ); s.push( 3*t+1 ); s.push( 3*t+2 );
+      /** Push half-edges of t*/
+      s.push( 3*t ); s.push( 3*t+1 ); s.push( 3*t+2 );
+    }
   }
-  cout << endl << "Pet_CHE::orient done." << endl;
+  cout << nflip << " triangle(s) flipped." << endl;
+}
+//--------------------------------------------------//
+/** Root of the search a in the forest up, with the parity of a relative
+  * to its root in p. The path is compressed.*/
+static TRid orient_find( TRid *up, char *par, TRid a, char &p )
+//--------------------------------------------------//
+{
+  TRid r = a;
+  p = 0;
+  while( up[r] != r ) { p ^= par[r]; r = up[r]; }
+
+  char q = p;
+  while( up[a] != a )
+  {
+    TRid n = up[a];
+    char o = par[a];
+    up[a] = r; par[a] = q;
+    q ^= o; a = n;
+  }
+  return r;
+}
+//--------------------------------------------------//
+void CHE_L1::orient_parallel()
+//--------------------------------------------------//
+/** Orients each compound of the mesh as its first triangle, in parallel.
+  *
+  * The triangles are handed to the threads by dynamic chunks: each
+  * triangle not yet reached starts a breadth first search, which claims
+  * the triangles of its frontier by compare and swap and records the
+  * parity of each one relative to its first triangle, without changing
+  * the mesh. Two searches meeting in the same compound leave the shared
+  * edges in a list, and a union-find with parity joins their
+  * first triangles. The flips are then applied in one parallel pass.*/
+{
+  if( _V.size() == 0 && _G.size() == 0 ) return;	
+
+  cout << "Pet_CHE::orient... " ;
+
+  const TRid nt = ntrig();
+  if( nt == 0 ) { cout << "0 triangle(s) flipped." << endl; return; }
+
+  /** First triangle of the search that reached each triangle*/
+  vector<TRid> seed( nt, -1 );
+  /** Parity of each triangle relative to its seed, then flip of the triangle*/
+  vector<char> flip( nt, 0 );
+  /** Smallest triangle reached by each search (indexed by its seed)*/
+  vector<TRid> low ( nt, -1 );
+  /** Half-edges shared by two searches, per thread*/
+  vector< vector<HEid> > cross( par_nthreads() );
+
+  TRid *s = &seed[0];
+  char *f = &flip[0];
+
+  #pragma omp parallel
+  {
+    vector<TRid>  q;
+    vector<HEid> &x = cross[ par_thread() ];
+
+    #pragma omp for schedule(dynamic,1024)
+    for( TRid r=0; r< nt; ++r)
+    {
+      if( !par_cas( s+r, -1, r ) ) continue;
+
+      TRid m = r;
+      q.clear();
+      q.push_back( r );
+      for( size_t i=0; i< q.size(); ++i)
+      {
+        const TRid t = q[i];
+        if( t < m ) m = t;
+
+        for( HEid h=3*t; h< 3*t+3; ++h)
+        {
+          const HEid o = _O[h];
+          if( o < 0 ) continue;
+
+          const TRid u = o/3;
+          if( par_cas( s+u, -1, r ) )
+          {
+            f[u] = f[t] ^ !orient_check( h, o );
+            q.push_back( u );
+          }
+          else if( s[u] != r )
+            x.push_back( h );
+        }
+      }
+      low[r] = m;
+    }
+  }
+
+  /** Joins the searches that met, with the parity of their seeds*/
+  vector<TRid> up ( nt, -1 );
+  vector<char> par( nt, 0 );
+  for( TRid r=0; r< nt; ++r)
+    if( s[r] == r ) up[r] = r;
+
+  for( size_t k=0; k< cross.size(); ++k)
+    for( size_t i=0; i< cross[k].size(); ++i)
+    {
+      const HEid h = cross[k][i];
+      const HEid o = _O[h];
+
+      char pa, pb;
+      TRid a = orient_find( &up[0], &par[0], s[h/3], pa );
+      TRid b = orient_find( &up[0], &par[0], s[o/3], pb );
+      if( a == b ) continue;
+
+      const char p = pa ^ pb ^ f[h/3] ^ f[o/3] ^ !orient_check( h, o );
+      if( a < b ) { up[b] = a; par[b] = p; }
+      else        { up[a] = b; par[a] = p; }
+    }
+  cross.clear();
+
+  /** Each compound keeps the orientation of its smallest triangle: the
+    * roots are visited first, and keep this triangle in low and the
+    * parity of its seed in par*/
+  for( TRid r=0; r< nt; ++r)
+  {
+    if( s[r] != r ) continue;
+
+    char p;
+    TRid a = orient_find( &up[0], &par[0], r, p );
+    if( a == r ) continue;
+
+    if( low[r] < low[a] ) { low[a] = low[r]; par[a] = p; }
+  }
+  for( TRid r=0; r< nt; ++r)
+    if( s[r] == r && up[r] == r ) par[r] ^= f[ low[r] ];
+  
+  /** Flip of each seed, relative to the smallest triangle of its compound*/
+  for( TRid r=0; r< nt; ++r)
+  {
+    if( s[r] != r || up[r] == r ) continue;
+    char p;
+    TRid a = orient_find( &up[0], &par[0], r, p );
+    low[r] = p ^ par[a];
+  }
+  for( TRid r=0; r< nt; ++r)
+    if( s[r] == r && up[r] == r ) low[r] = par[r];
+
+  TRid nflip = 0;
+  #pragma omp parallel for reduction(+:nflip)
+  for( TRid t=0; t< nt; ++t)
+  {
+    f[t] ^= (char)low[ s[t] ];
+    nflip += f[t];
+  }
+  up.clear(); par.clear(); low.clear();
+
+  /** Applies the flips: the vertices 0 and 1 of a flipped triangle are
+    * exchanged, so that its half-edges 1 and 2 are exchanged*/
+  if( nflip > 0 )
+  {
+    #pragma omp parallel for
+    for( TRid t=0; t< nt; ++t)
+    {
+      HEid o[3];
+      for( int j=0; j< 3; ++j)
+      {
+        const HEid h = _O[3*t+j];
+        o[j] = ( h >= 0 && f[h/3] && h%3 ) ? h + ( h%3 == 1 ? 1 : -1 ) : h;
+      }
+
+      if( f[t] )
+      {
+        Vid v = _V[3*t];  _V[3*t] = _V[3*t+1];  _V[3*t+1] = v;
+        _O[3*t] = o[0];  _O[3*t+1] = o[2];  _O[3*t+2] = o[1];
+      }
+      else
+      {
+        _O[3*t] = o[0];  _O[3*t+1] = o[1];  _O[3*t+2] = o[2];
+      }
+    }
+    _NO.clear(); _HI.clear();
+  }
+
+  cout << nflip << " triangle(s) flipped." << endl;
 }
 //--------------------------------------------------//
 void CHE_L1::orient_change(const TRid t)
 //--------------------------------------------------//
 /** Changes the orientation of a triangle.*/
 {
-  cout << endl << "Pet_CHE::orient_change... " << t ;	
   HEid h1= 3*t;
   HEid h2= 3*t+1;
   HEid h3= 3*t+2;
@@ -393,8 +804,11 @@ Cid CHE_L1::get_component( Cid i )
   Cid b = C(i) ;
   if( b < 0 || b == i ) return b ;
 
-  b = get_component(b) ;
-  set_C( i,b );
+  /** Finds the root iteratively: long chains would overflow the call stack*/
+  while( C(b) != b ) b = C(b) ;
+
+  /** Compresses the path*/
+  while( i != b ) { Cid n = C(i) ; set_C( i,b ) ; i = n ; }
 
   return b;
 }
@@ -410,7 +824,7 @@ void CHE_L1::read_ply( const char* file )
   start_time = clock();
 
 
-	CHE_L0::read_ply( file );
+	if( !CHE_L0::load_ply( file ) ) return;
 	compute_opposites();
 	orient();
 	compute_connected();
@@ -423,3 +837,64 @@ void CHE_L1::read_ply( const char* file )
 
 }
 //------------------------------------//
+void CHE_L1::write_tables( Snapshot_writer &w ) const
+//------------------------------------//
+/** Adds the opposite and compound tables.*/
+{
+  CHE_L0::write_tables( w );
+  w.add_value( "NC", _ncomp );
+  w.add( "O", _O );
+  w.add( "C", _C );
+}
+//------------------------------------//
+bool CHE_L1::read_tables( const Snapshot_reader &r )
+//------------------------------------//
+/** Reads the opposite and compound tables.*/
+{
+  return CHE_L0::read_tables( r ) && r.get_value( "NC", _ncomp ) && r.get( "O", _O ) && r.get( "C", _C )
+      && (TRid)_O.size() == 3*ntrig();
+}
+//------------------------------------//
+void CHE_L1::remap( const vector<Vid> &vnew, const vector<TRid> &tnew )
+//------------------------------------//
+/** Permutes the opposite and compound tables; the opposites of the
+  * dropped half-edges become boundary.*/
+{
+  CHE_L0::remap( vnew, tnew );
+
+  vector<HEid> O( 3*ntrig() );
+  #pragma omp parallel for schedule(static)
+  for(HEid h=0; h<(HEid)_O.size(); ++h)
+  {
+    const HEid n = remap_he( h, tnew );
+    if( n >= 0 ) O[n] = remap_he( _O[h], tnew );
+  }
+  _O.swap( O );
+
+  if( _C.size() != vnew.size() ) return;
+  vector<Cid> C( nvert() );
+  #pragma omp parallel for schedule(static)
+  for(Vid v=0; v<(Vid)vnew.size(); ++v) if( vnew[v] >= 0 ) C[ vnew[v] ] = _C[v];
+  _C.swap( C );
+}
+//------------------------------------//
+void CHE_L1::take( CHE_L1 &c )
+//------------------------------------//
+/** Swaps the opposite and compound tables with c and leaves c empty.*/
+{
+  CHE_L0::take( c );
+  _ncomp = c._ncomp;  c._ncomp = 0;
+  _O.swap( c._O );  c._O.clear();
+  _C.swap( c._C );  c._C.clear();
+}
+//------------------------------------//
+void CHE_L1::clear()
+//------------------------------------//
+/** Clears the opposite and compound tables.*/
+{
+  CHE_L0::clear();
+  _ncomp = 0;
+  _O.clear();
+  _C.clear();
+}
+//------------------------------------//
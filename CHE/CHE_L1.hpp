@@ -24,6 +24,21 @@ typedef int  Cid;
 /** \brief standart namespace definition*/
 using namespace std;
 
+/** \brief Star visitor that appends the visited ids to a vector
+  *
+  * Used by the vector R_* queries on top of the visit_R_* ones.*/
+template <class T> struct Star_collector
+{
+  /** \brief Output vector*/
+  vector<T> &star;
+  /** \brief Constructor 
+    * \param s - vector<T>& */
+  Star_collector( vector<T> &s ) : star(s) {}
+  /** \brief Visits an element 
+    * \param x - const T */
+  inline void operator()( const T x ) { star.push_back(x); }
+};
+
 /** CHE_L1 class
   *
   * Creates a structure for triangulated meshes,
@@ -76,6 +91,15 @@ public:
     * \param c - const CHE_L1&.*/
   CHE_L1(const CHE_L1& c): CHE_L0( c ), _ncomp( c.ncomp() ) { _O = c._O; _C = c._C; }
 
+  /** \brief Promotion constructor
+    *
+    * Takes the tables of a level 0 structure without copying them
+    * (c is left empty) and computes the opposites, the orientation,
+    * the compounds and the normals, as read_ply does after loading.
+    *
+    * \param c - CHE_L0&.*/
+  explicit CHE_L1(CHE_L0& c): CHE_L0(), _ncomp(0) { CHE_L0::take( c ); compute_opposites(); orient(); compute_connected(); compute_normals(); }
+
   /** \brief Destructor.
     *
     * Frees the memory used by _V, _G, _O, _C*/
@@ -149,18 +173,134 @@ public:
 	  * \param r - const TRid*/
   virtual vector<TRid> R_22( const TRid t );
 
+public:
+  /** \brief Visits the vertices in the star of a given vertex
+    *
+    * Allocation free version of R_00: f(Vid) is called for each
+    * vertex of the one-ring. Nothing is printed; returns false 
+    * if v is invalid or isolated.
+	  * \param v - const Vid
+	  * \param f - F& functor */
+  template <class F> inline bool visit_R_00( const Vid v, F &f ) const
+  { HEid h = first_he(v); if( h < 0 ) return false; fan_R_00( h, f ); return true; }
+  /** \brief Visits the triangles in the star of a given vertex 
+	  * \param v - const Vid
+	  * \param f - F& functor */
+  template <class F> inline bool visit_R_02( const Vid v, F &f ) const
+  { HEid h = first_he(v); if( h < 0 ) return false; fan_R_02( h, f ); return true; }
+  /** \brief Visits the vertices in the star of a given edge
+    * (the boundary side is skipped)
+	  * \param h - const HEid
+	  * \param f - F& functor */
+  template <class F> inline bool visit_R_10( const HEid h, F &f ) const
+  {
+    if( !he_valid(h) ) return false;
+    f( _V[he_prev(h)] );
+    const HEid o = _O[h]; if( o >= 0 ) f( _V[he_prev(o)] );
+    return true;
+  }
+  /** \brief Visits the triangles in the star of a given edge
+    * (the boundary side is skipped)
+	  * \param h - const HEid
+	  * \param f - F& functor */
+  template <class F> inline bool visit_R_12( const HEid h, F &f ) const
+  {
+    if( !he_valid(h) ) return false;
+    f( h/3 );
+    const HEid o = _O[h]; if( o >= 0 ) f( o/3 );
+    return true;
+  }
+  /** \brief Visits the triangles adjacent to a given triangle
+    * (the boundary sides are skipped)
+	  * \param t - const TRid
+	  * \param f - F& functor */
+  template <class F> inline bool visit_R_22( const TRid t, F &f ) const
+  {
+    if( !tr_valid(t) ) return false;
+    for( int k=0; k<3; ++k ) { const HEid o = _O[3*t+k]; if( o >= 0 ) f( o/3 ); }
+    return true;
+  }
+
+protected:
+  /** \brief Unchecked next of a half-edge 
+	  * \param h - const HEid */
+  static inline HEid he_next( const HEid h ) { return (h%3 == 2) ? h-2 : h+1; }
+  /** \brief Unchecked previous of a half-edge 
+	  * \param h - const HEid */
+  static inline HEid he_prev( const HEid h ) { return (h%3 == 0) ? h+2 : h-1; }
+  /** \brief First half-edge leaving a vertex (linear search at this level)
+	  * \param v - const Vid */
+  inline HEid first_he( const Vid v ) const
+  {
+    if( !v_valid(v) ) return INV;
+    for( HEid i=0; i<3*ntrig(); ++i ) if( _V[i] == v && _O[i] != INV ) return i;
+    return INV;
+  }
+  /** \brief Walks the fan of V(h0) from h0: forward until it closes 
+    * or reaches the boundary, then backward from h0.
+    * f(Vid) is called once for each vertex of the one-ring.
+	  * \param h0 - const HEid
+	  * \param f  - F& functor */
+  template <class F> inline void fan_R_00( const HEid h0, F &f ) const
+  {
+    HEid h = h0;
+    do { f( _V[he_next(h)] ); h = _O[h]; if( h < 0 ) break; h = he_next(h); } while( h != h0 );
+    if( h == h0 ) return;
+
+    h = h0;
+    for(;;) { const HEid p = he_prev(h); f( _V[p] ); h = _O[p]; if( h < 0 || h == h0 ) break; }
+  }
+  /** \brief Same walk as fan_R_00, visiting the triangles 
+	  * \param h0 - const HEid
+	  * \param f  - F& functor */
+  template <class F> inline void fan_R_02( const HEid h0, F &f ) const
+  {
+    HEid h = h0;
+    do { f( h/3 ); h = _O[h]; if( h < 0 ) break; h = he_next(h); } while( h != h0 );
+    if( h == h0 ) return;
+
+    h = _O[he_prev(h0)];
+    while( h >= 0 && h != h0 ) { f( h/3 ); h = _O[he_prev(h)]; }
+  }
+
 public:
 	/** \brief Computes the opposite of each half-edge*/
   void compute_opposites();
+	/** \brief Computes the opposite of each half-edge with a
+    * two-pass counting (radix) sort of the undirected edge keys.
+    *
+    * Linear in the number of half-edges and vertices, without
+    * any per-edge allocation. Used by compute_opposites().*/
+  void compute_opposites_radix();
+	/** \brief Computes the opposite of each half-edge with a map
+    * of the unmatched edges (reference implementation).*/
+  void compute_opposites_map();
+	/** \brief Computes the opposite of each half-edge in parallel.
+    *
+    * The half-edges are partitioned by a hash of their edge key,
+    * so that both half-edges of an edge fall in the same partition,
+    * and each thread matches its partitions without locks.*/
+  void compute_opposites_parallel();
  	/** \brief Computes the connected compound of each vertex*/
   void compute_connected();
+ 	/** \brief Computes the connected compound of each vertex in parallel
+    * with a concurrent union-find with path compression*/
+  void compute_connected_parallel();
 	/** \brief Checks the mesh*/
  void check () ;
+  /** \brief Empties the structure*/
+  virtual void clear();
 
 private:
-  /** \brief Orients the mesh*/
+  /** \brief Orients each compound of the mesh as its first triangle*/
   void orient();
 
+  /** \brief Orients each compound of the mesh in parallel, by breadth
+    * first searches started from several triangles of a compound and
+    * joined by a union-find with parity. The flips are applied in one
+    * pass at the end.*/
+  void orient_parallel();
+
   /** \brief Changes the orientation of a triangle
 	  * \param t - const TRid */
   void orient_change(const TRid t);
@@ -170,7 +310,7 @@ private:
 	  * \param o - const HEid */ 
   const bool orient_check(const HEid h, const HEid o);
 	
-  /** \brief Gets the connected compound
+  /** \brief Gets the connected compound, compressing the path to it
     * \param i - Cid*/
   Cid get_component( Cid i ) ;
 
@@ -178,6 +318,24 @@ public:
   /** \brief Reads a 3D model in the .ply format
     * \param file - const char* */
   void  read_ply( const char* file );
+
+protected:
+  /** \brief Level of the structure, stored in the snapshots*/
+  virtual const int snapshot_level() const { return 1; }
+  /** \brief Adds the tables of the level to a snapshot
+    * \param w - Snapshot_writer& */
+  virtual void write_tables( Snapshot_writer &w ) const;
+  /** \brief Reads the tables of the level from a snapshot
+    * \param r - const Snapshot_reader& */
+  virtual bool read_tables ( const Snapshot_reader &r );
+  /** \brief Applies a permutation of the vertices and of the triangles
+    * to the opposite and compound tables
+    * \param vnew - const vector<Vid>&
+    * \param tnew - const vector<TRid>& */
+  virtual void remap( const vector<Vid> &vnew, const vector<TRid> &tnew );
+  /** \brief Takes the tables of c, which is left empty
+    * \param c - CHE_L1& */
+  void take( CHE_L1 &c );
 };
 #endif
 //-----------------------------------------------//
@@ -12,8 +12,10 @@
 
 
 #include <GL/glut.h>
+#include <algorithm>
 
 #include "CHE_L2.hpp"
+#include "../common/Snapshot.hpp"
 
 
 
@@ -27,21 +29,13 @@ vector<Vid> CHE_L2::R_00(const Vid v)
 /** Computes the vertices in the star of a given vertex.*/
 {
   vector<Vid> star;
+  Star_collector<Vid> f( star );
   
-  if( !v_valid(v) ) { 
+  need_VH();
+  if( !visit_R_00( v, f ) ) { 
     cout << "CHE_L2::Vertex Star ERROR: invalid vertex id" << endl;
     star.push_back(INV); 
-    return star; 
   }
-
-  //Gets the first incident half--edge
-  HEid h = VH(v), h0 = h;
-  
-  //Walks through the star.  
-  do 
-    star.push_back( V(next(h)) );
-  while( (O(h) != -1) && ( (h = next(O(h))) != h0) );
-
   return star;
 }
 //--------------------------------------------------//
@@ -49,52 +43,52 @@ vector<TRid> CHE_L2::R_02(const Vid v)
 //--------------------------------------------------//
 /** Computes the triangles in the star of a given vertex.*/
 {
-  vector<Vid> star;
+  vector<TRid> star;
+  Star_collector<TRid> f( star );
   
-  if( !v_valid(v) ) { 
+  need_VH();
+  if( !visit_R_02( v, f ) ) { 
     cout << "CHE_L2::Vertex Star ERROR: invalid vertex id" << endl;
     star.push_back(INV); 
-    return star; 
   }
-
-  //Gets the first incident half--edge
-  HEid h = VH(v), h0 = h;
-  
-  //Walks through the star.  
-  do 
-    star.push_back( trig(h) );
-  while( (O(h) != -1) && ( (h = next(O(h))) != h0) );
-
   return star;
 }
 //--------------------------------------------------//
-void CHE_L2::compute_EH()
+void CHE_L2::compute_EH() const
 //--------------------------------------------------//
 /** Computes the edges of the model.*/
 {
   cout << "Pet_CHE::compute_EH...   " ;
 
   _EH.clear();
+  _FE.clear();
+  _E.clear();
+  _E.resize( 3*ntrig(), -1 );
 
+  // the canonical half-edges are numbered in increasing order
+  Eid ne = 0;
   for(HEid i=0; i<3*ntrig(); ++i)
-	{
-    if( !he_valid(i) ) continue;
+    if( he_valid(i) && e_canonical(i) ) ++ne;
+  _EH.reserve( ne );
 
-		HEid he0 = i;
-    HEid he1 = O(i);
+  for(HEid i=0; i<3*ntrig(); ++i)
+	{
+    if( !he_valid(i) || !e_canonical(i) ) continue;
 
-    if( he1 == -1 ) _EH.insert(make_pair(he0, he1));
-    else
-    {
-      if(he1 < he0) { HEid tmp = he0; he0 = he1; he1 = tmp; }
-      if(_EH.find(he0) == _EH.end())
-        _EH.insert(make_pair(he0, he1));
-    }
+    _E[i] = (Eid)_EH.size();
+    _EH.push_back( i );
 	}
+
+  // the other half of each interior edge shares its id
+  for(HEid i=0; i<3*ntrig(); ++i)
+  {
+    if( !he_valid(i) || e_canonical(i) ) continue;
+    _E[i] = _E[ O(i) ];
+  }
   cout << " " << (int)EH().size() << " edges found." << endl; 
 }
 //--------------------------------------------------//
-void CHE_L2::compute_VH()
+void CHE_L2::compute_VH() const
 //--------------------------------------------------//
 /** Computes the vertex Half-edge table.*/
 {
@@ -105,10 +99,12 @@ void CHE_L2::compute_VH()
 
    for( HEid i=0; i<3*ntrig(); ++i)
    {
+     const Vid v = V(i);
+     if( !v_valid(v) ) continue;
 	   if(O(i) == -1) 
-		   set_VH( V(i), i );
+		   _VH[v] = i;
 	   else
-		   if( VH( V(i) ) == -1 ) set_VH( V(i), i );
+		   if( _VH[v] == -1 ) _VH[v] = i;
    }
   cout << " done." << endl;
 }
@@ -118,11 +114,14 @@ void CHE_L2::check()
 /** Checks the mesh.*/
 {
   CHE_L1::check();
+  need_VH();
+  need_EH();
 
   if(nvert() != static_cast<int>(  _VH.size())  ){ cout << "CHE_L2:: Erro nvert()!= VH.size" << endl; return;}
 
   for(int i=0; i<nvert(); ++i)
   {
+    if( !v_valid(i) ) continue;
     if( VH(i) >= 3*ntrig() )
     {
       cout << "CHE_L2:: Erro VH(" << i << ") >= 3*ntrig()." << endl;
@@ -135,11 +134,25 @@ void CHE_L2::check()
     }
   }
 
-  for(Ecit i=EH().begin(); i!=EH().end(); ++i)
+  if( 3*ntrig() != static_cast<int>( _E.size() ) ){ cout << "CHE_L2:: Erro 3*ntrig()!= E.size" << endl; return;}
+
+  for(Eid e=0; e<nedge(); ++e)
+  {
+    HEid h = EH(e);
+    if( h == INV ) continue;
+    if( !he_valid(h) || !e_canonical(h) || E(h) != e )
+    {
+      cout << "CHE_L2:: invalid edge " << e << "." << endl;
+      return;
+    }
+  }
+
+  for(HEid h=0; h<3*ntrig(); ++h)
   {
-    if( (i->first >= 3*ntrig()) &&  (i->first < 0)   &&  (i->second != O(i->first)))
+    if( !he_valid(h) ) continue;
+    if( O(h) >= 0 && E(h) != E( O(h) ) )
     {
-      cout << "CHE_L2:: invalid edge." << endl;
+      cout << "CHE_L2:: Erro E(" << h << ") != E(O(" << h << "))." << endl;
       return;
     }
   }
@@ -149,13 +162,15 @@ void CHE_L2::draw_wire()
 //--------------------------------------------------//
 /** Draws the surface in wireframe with opengl.*/
 {
+  need_EH();
   for(Ecit i= EH().begin(); i!= EH().end(); ++i)
 
 	{
+		if( *i < 0 ) continue;
 
-		const Vertex &v1 = G(V(   i->first     ));
+		const Vertex v1 = vertex(V(   *i     ));
 
-		const Vertex &v2 = G(V( next(i->first) ));
+		const Vertex v2 = vertex(V( next(*i) ));
 
 
 
@@ -189,6 +204,7 @@ void CHE_L2::read_ply( const char* file )
   start_time = clock();
 
 
+  _FT.clear(); _FV.clear(); _VP.clear();
   CHE_L1::read_ply( file );
 	compute_EH();
 	compute_VH();
@@ -199,3 +215,503 @@ void CHE_L2::read_ply( const char* file )
 
 }
 //------------------------------------------------//
+void CHE_L2::write_tables( Snapshot_writer &w ) const
+//------------------------------------------------//
+/** Adds the vertex and edge tables.*/
+{
+  CHE_L1::write_tables( w );
+  w.add( "VH", _VH );
+  w.add( "EH", _EH );
+  w.add( "E" , _E  );
+}
+//------------------------------------------------//
+bool CHE_L2::read_tables( const Snapshot_reader &r )
+//------------------------------------------------//
+/** Reads the vertex and edge tables.*/
+{
+  _FT.clear(); _FV.clear(); _FE.clear(); _VP.clear();
+  return CHE_L1::read_tables( r ) && r.get( "VH", _VH ) && r.get( "EH", _EH ) && r.get( "E", _E )
+      && (Vid)_VH.size() == nvert() && (TRid)_E.size() == 3*ntrig();
+}
+//------------------------------------------------//
+void CHE_L2::remap( const vector<Vid> &vnew, const vector<TRid> &tnew )
+//------------------------------------------------//
+/** Permutes the vertex table and renumbers the edges. The free
+  * elements that are dropped leave the free lists.*/
+{
+  CHE_L1::remap( vnew, tnew );
+
+  if( _VH.size() == vnew.size() )
+  {
+    // a kept vertex whose half-edge is dropped gets a new one from compute_VH
+    int lost = 0;
+    vector<HEid> VH( nvert() );
+    #pragma omp parallel for schedule(static) reduction(+:lost)
+    for(Vid v=0; v<(Vid)vnew.size(); ++v)
+    {
+      if( vnew[v] < 0 ) continue;
+      VH[ vnew[v] ] = remap_he( _VH[v], tnew );
+      if( _VH[v] >= 0 && VH[ vnew[v] ] < 0 ) ++lost;
+    }
+    _VH.swap( VH );
+    if( lost ) compute_VH();
+  }
+
+  size_t n = 0;
+  for(size_t i=0; i<_FT.size(); ++i) if( tnew[ _FT[i] ] >= 0 ) _FT[n++] = tnew[ _FT[i] ];
+  _FT.resize( n );
+  n = 0;
+  for(size_t i=0; i<_FV.size(); ++i) if( vnew[ _FV[i] ] >= 0 ) _FV[n++] = vnew[ _FV[i] ];
+  _FV.resize( n );
+
+  // the canonical half-edge of an edge depends on the half-edge ids:
+  // the edges are numbered again, in the order of the new half-edges
+  if( !_E.empty() ) compute_EH();
+  _VP.clear();
+}
+//------------------------------------------------//
+void CHE_L2::materialize()
+//------------------------------------------------//
+/** Computes the vertex and edge tables of a promoted structure.*/
+{
+  CHE_L1::materialize();
+  need_VH();
+  need_EH();
+}
+//------------------------------------------------//
+void CHE_L2::take( CHE_L2 &c )
+//------------------------------------------------//
+/** Swaps the vertex and edge tables with c and leaves c empty.*/
+{
+  CHE_L1::take( c );
+  _VH.swap( c._VH );  c._VH.clear();
+  _EH.swap( c._EH );  c._EH.clear();
+  _E .swap( c._E  );  c._E .clear();
+  _FT.swap( c._FT );  c._FT.clear();
+  _FV.swap( c._FV );  c._FV.clear();
+  _FE.swap( c._FE );  c._FE.clear();
+  _VP.swap( c._VP );  c._VP.clear();
+}
+//------------------------------------------------//
+void CHE_L2::clear()
+//------------------------------------------------//
+/** Clears the vertex and edge tables and the free lists.*/
+{
+  CHE_L1::clear();
+  _VH.clear(); _EH.clear(); _E.clear();
+  _FT.clear(); _FV.clear(); _FE.clear(); _VP.clear();
+}
+//------------------------------------------------//
+void CHE_L2::edit_glue( const HEid h, const HEid o )
+//------------------------------------------------//
+/** Makes h and o opposite.*/
+{
+  if( h >= 0 ) _O[h] = o;
+  if( o >= 0 ) _O[o] = h;
+}
+//------------------------------------------------//
+void CHE_L2::edit_edge( const HEid h, Eid e )
+//------------------------------------------------//
+/** Gives an edge id to h and its opposite.*/
+{
+  if( !has_EH() || h < 0 ) return;
+
+  if( e < 0 )
+  {
+    if( _FE.empty() ) { e = (Eid)_EH.size(); _EH.push_back( INV ); }
+    else { e = _FE.back(); _FE.pop_back(); }
+  }
+
+  const HEid o = _O[h];
+  _E[h] = e;
+  if( o >= 0 ) _E[o] = e;
+  _EH[e] = ( o < 0 || h < o ) ? h : o;
+}
+//------------------------------------------------//
+void CHE_L2::edit_VH( const Vid v, const HEid h0 )
+//------------------------------------------------//
+/** Sets the half-edge of a vertex, on the boundary if possible.*/
+{
+  if( !has_VH() || h0 < 0 ) return;
+
+  HEid h = h0;
+  while( _O[h] >= 0 ) { h = he_next( _O[h] ); if( h == h0 ) break; }
+  _VH[v] = h;
+}
+//------------------------------------------------//
+const bool CHE_L2::edit_bound( const HEid h0 ) const
+//------------------------------------------------//
+/** Tests if the vertex of a half-edge is on the boundary.*/
+{
+  HEid h = h0;
+  while( _O[h] >= 0 ) { h = he_next( _O[h] ); if( h == h0 ) return false; }
+  return true;
+}
+//------------------------------------------------//
+void CHE_L2::compute_VP() const
+//------------------------------------------------//
+/** Marks the vertices whose fan, walked from VH(v), does not 
+  * hold all the half-edges leaving them.*/
+{
+  need_VH();
+
+  vector<int> deg( nvert(), 0 );
+  for(HEid h=0; h<3*ntrig(); ++h)
+    if( he_valid(h) && _V[h] >= 0 && _V[h] < nvert() ) ++deg[ _V[h] ];
+
+  _VP.assign( nvert(), 0 );
+  for(Vid v=0; v<nvert(); ++v)
+  {
+    HEid h0 = _VH[v];
+    if( h0 < 0 || deg[v] == 0 ) continue;
+
+    // the fan is walked from its boundary half-edge, if it has one
+    HEid h = h0;
+    while( _O[h] >= 0 ) { h = he_next( _O[h] ); if( h == h0 ) break; }
+    h0 = h;
+
+    int n = 0;
+    do { ++n; h = _O[ he_prev(h) ]; } while( h >= 0 && h != h0 && n <= deg[v] );
+    _VP[v] = ( n != deg[v] );
+  }
+}
+//------------------------------------------------//
+TRid CHE_L2::edit_new_trig()
+//------------------------------------------------//
+/** Takes a free triangle or adds one.*/
+{
+  if( !_FT.empty() ) { TRid t = _FT.back(); _FT.pop_back(); return t; }
+
+  const TRid t  = ntrig();
+  const bool eh = has_EH();
+  _V.resize( 3*t+3, INV );
+  _O.resize( 3*t+3, INV );
+  if( eh ) _E.resize( 3*t+3, -1 );
+  set_ntrig( t+1 );
+  return t;
+}
+//------------------------------------------------//
+Vid CHE_L2::edit_new_vertex( const Vertex &p, const Cid c )
+//------------------------------------------------//
+/** Takes a free vertex or adds one.*/
+{
+  Vid v;
+  if( !_FV.empty() ) { v = _FV.back(); _FV.pop_back(); }
+  else
+  {
+    v = nvert();
+    const bool vh = has_VH(), vp = ( (Vid)_VP.size() == v );
+    if( _soa ) _S.push_back( p ); else _G.push_back( p );
+    _C.push_back( INV );
+    if( vh ) _VH.push_back( INV );
+    if( vp ) _VP.push_back( 0 );
+    set_nvert( v+1 );
+  }
+  if( v < (Vid)_VP.size() ) _VP[v] = 0;
+  set_G( v, p );
+  set_C( v, c );
+  return v;
+}
+//------------------------------------------------//
+void CHE_L2::edit_free_trig( const TRid t )
+//------------------------------------------------//
+/** Removes a triangle.*/
+{
+  if( has_EH() ) _E[3*t] = _E[3*t+1] = _E[3*t+2] = -1;
+  CHE_L1::tr_invalid( t );
+  _FT.push_back( t );
+}
+//------------------------------------------------//
+void CHE_L2::edit_free_vertex( const Vid v )
+//------------------------------------------------//
+/** Removes a vertex.*/
+{
+  if( has_VH() ) _VH[v] = INV;
+  CHE_L1::v_invalid( v );
+  _FV.push_back( v );
+}
+//------------------------------------------------//
+void CHE_L2::edit_free_edge( const Eid e )
+//------------------------------------------------//
+/** Removes an edge.*/
+{
+  if( !has_EH() || e < 0 ) return;
+  _EH[e] = INV;
+  _FE.push_back( e );
+}
+//------------------------------------------------//
+const bool CHE_L2::can_collapse( const HEid h ) const
+//------------------------------------------------//
+/** Checks the link condition of an edge.*/
+{
+  if( !he_valid(h) ) return false;
+
+  const HEid n = he_next(h), p = he_prev(h), o = _O[h];
+  if( _V[h] == _V[n] ) return false;
+
+  // the fans of a bow-tie vertex are not seen by the rotations below
+  if( edit_pinched( _V[h] ) || edit_pinched( _V[n] ) ) return false;
+
+  // a triangle with two boundary edges would leave a dangling vertex
+  if( _O[n] < 0 && _O[p] < 0 ) return false;
+  if( o >= 0 && _O[he_next(o)] < 0 && _O[he_prev(o)] < 0 ) return false;
+
+  // an interior edge between two boundary vertices would pinch the surface
+  if( o >= 0 && edit_bound( h ) && edit_bound( n ) ) return false;
+
+  // link condition
+  vector<Vid> ra, rb;
+  Star_collector<Vid> fa( ra ), fb( rb );
+  fan_R_00( h, fa );
+  fan_R_00( n, fb );
+
+  int common = 0;
+  for(size_t i=0; i<ra.size(); ++i)
+    if( find( rb.begin(), rb.end(), ra[i] ) != rb.end() ) ++common;
+  if( common != ( o >= 0 ? 2 : 1 ) ) return false;
+
+  // the triangles glued along the removed edges must be different
+  const HEid x = _O[n], y = _O[p];
+  if( x >= 0 && y >= 0 && _V[he_prev(x)] == _V[he_prev(y)] ) return false;
+  if( o >= 0 )
+  {
+    const HEid z = _O[he_next(o)], w = _O[he_prev(o)];
+    if( z >= 0 && w >= 0 && _V[he_prev(z)] == _V[he_prev(w)] ) return false;
+  }
+  return true;
+}
+//------------------------------------------------//
+const bool CHE_L2::collapse_edge( const HEid h )
+//------------------------------------------------//
+/** Collapses V(h) onto V(next(h)).*/
+{
+  if( !can_collapse(h) ) return false;
+
+  // T0 = (a,b,c) : h = a->b, n = b->c, p = c->a
+  // T1 = (b,a,d) : o = b->a, on = a->d, op = d->b
+  const HEid n = he_next(h), p = he_prev(h), o = _O[h];
+  const Vid  a = _V[h], b = _V[n], c = _V[p];
+  const HEid x = _O[n], y = _O[p];
+  HEid on = -1, op = -1, z = -1, w = -1;
+  Vid  d  = INV;
+  if( o >= 0 ) { on = he_next(o); op = he_prev(o); z = _O[on]; w = _O[op]; d = _V[op]; }
+
+  const bool eh = has_EH();
+  const Eid  en  = eh ? _E[n] : -1, ep = eh ? _E[p] : -1, ee = eh ? _E[h] : -1;
+  const Eid  eon = ( eh && o >= 0 ) ? _E[on] : -1, eop = ( eh && o >= 0 ) ? _E[op] : -1;
+
+  // half-edges leaving a, out of T0 and T1
+  vector<HEid> out;
+  HEid k = h;
+  for(;;)
+  {
+    k = _O[k];
+    if( k < 0 ) break;
+    k = he_next(k);
+    if( k == h ) break;
+    out.push_back( k );
+  }
+  if( k != h )
+    for( k = y; k >= 0 && k != h; k = _O[he_prev(k)] ) out.push_back( k );
+
+  for(size_t i=0; i<out.size(); ++i)
+    if( out[i] != on ) set_V( out[i], b );
+
+  // the edges c-a and d-a are glued to c-b and d-b
+  edit_glue( x, y );
+  edit_edge( x >= 0 ? x : y, en );
+  edit_free_edge( ep );
+  edit_free_edge( ee );
+  if( o >= 0 )
+  {
+    edit_glue( z, w );
+    edit_edge( w >= 0 ? w : z, eop );
+    edit_free_edge( eon );
+  }
+
+  // boundary half-edges that change
+  HEid from[4], to[4];
+  int  nr = 0;
+  if( x < 0 ) { from[nr] = n;  to[nr] = y; ++nr; }
+  if( y < 0 ) { from[nr] = p;  to[nr] = x; ++nr; }
+  if( o >= 0 && z < 0 ) { from[nr] = on; to[nr] = w; ++nr; }
+  if( o >= 0 && w < 0 ) { from[nr] = op; to[nr] = z; ++nr; }
+  if( nr ) edit_rename( from, to, nr );
+  if( o < 0 ) edit_remove( h );
+
+  edit_free_trig( h/3 );
+  if( o >= 0 ) edit_free_trig( o/3 );
+  edit_free_vertex( a );
+
+  edit_VH( b, y >= 0 ? y : he_next(x) );
+  edit_VH( c, x >= 0 ? x : he_next(y) );
+  if( o >= 0 ) edit_VH( d, z >= 0 ? z : he_next(w) );
+
+  return true;
+}
+//------------------------------------------------//
+const bool CHE_L2::can_flip( const HEid h ) const
+//------------------------------------------------//
+/** Checks if an edge can be flipped.*/
+{
+  if( !he_valid(h) ) return false;
+
+  const HEid o = _O[h];
+  if( o < 0 || o/3 == h/3 ) return false;
+
+  const Vid c = _V[he_prev(h)], d = _V[he_prev(o)];
+  if( c == d ) return false;
+
+  // the star of a pinched vertex has several fans: d is searched
+  // around c, or c around d
+  const bool pc = edit_pinched( c );
+  if( pc && edit_pinched( d ) ) return false;
+
+  vector<Vid> rc;
+  Star_collector<Vid> f( rc );
+  fan_R_00( pc ? he_prev(o) : he_prev(h), f );
+  return find( rc.begin(), rc.end(), pc ? c : d ) == rc.end();
+}
+//------------------------------------------------//
+const bool CHE_L2::flip_edge( const HEid h )
+//------------------------------------------------//
+/** Flips an interior edge.*/
+{
+  if( !can_flip(h) ) return false;
+
+  // T0 = (a,b,c), T1 = (b,a,d) become T0 = (d,c,a), T1 = (c,d,b)
+  const HEid n  = he_next(h), p  = he_prev(h), o = _O[h];
+  const HEid on = he_next(o), op = he_prev(o);
+  const Vid  a  = _V[h], b = _V[n], c = _V[p], d = _V[op];
+  const HEid xn = _O[n], xp = _O[p], xon = _O[on], xop = _O[op];
+
+  const bool eh = has_EH();
+  const Eid  en = eh ? _E[n] : -1, ep = eh ? _E[p] : -1, eon = eh ? _E[on] : -1, eop = eh ? _E[op] : -1;
+
+  set_V( h, d );  set_V( n , c );  set_V( p , a );
+  set_V( o, c );  set_V( on, d );  set_V( op, b );
+
+  edit_glue( n , xp  );
+  edit_glue( p , xon );
+  edit_glue( on, xop );
+  edit_glue( op, xn  );
+
+  edit_edge( h , eh ? _E[h] : -1 );
+  edit_edge( n , ep  );
+  edit_edge( p , eon );
+  edit_edge( on, eop );
+  edit_edge( op, en  );
+
+  // the boundary half-edges of the quad move to the half-edge glued
+  // to their outer side
+  HEid from[4], to[4];
+  int  nr = 0;
+  if( xp  < 0 ) { from[nr] = p;  to[nr] = n;  ++nr; }
+  if( xon < 0 ) { from[nr] = on; to[nr] = p;  ++nr; }
+  if( xop < 0 ) { from[nr] = op; to[nr] = on; ++nr; }
+  if( xn  < 0 ) { from[nr] = n;  to[nr] = op; ++nr; }
+  if( nr ) edit_rename( from, to, nr );
+
+  edit_VH( a, p  );
+  edit_VH( b, op );
+  edit_VH( c, n  );
+  edit_VH( d, on );
+
+  return true;
+}
+//------------------------------------------------//
+Vid CHE_L2::split_edge( const HEid h )
+//------------------------------------------------//
+/** Splits an edge at its midpoint.*/
+{
+  if( !he_valid(h) ) return INV;
+
+  // T0 = (a,b,c) becomes (a,m,c) and T2 = (m,b,c)
+  // T1 = (b,a,d) becomes (m,a,d) and T3 = (b,m,d)
+  const HEid n = he_next(h), p = he_prev(h), o = _O[h];
+  const Vid  a = _V[h], b = _V[n], c = _V[p];
+  const HEid xn = _O[n];
+
+  const bool eh = has_EH();
+  const Eid  ee = eh ? _E[h] : -1, en = eh ? _E[n] : -1;
+
+  const Vertex m( ( x(a)+x(b) )/2, ( y(a)+y(b) )/2, ( z(a)+z(b) )/2,
+                  ( nx(a)+nx(b) )/2, ( ny(a)+ny(b) )/2, ( nz(a)+nz(b) )/2, ( field(a)+field(b) )/2 );
+  const Vid  v  = edit_new_vertex( m, _C[a] );
+
+  const TRid t2 = edit_new_trig();
+  const HEid q0 = 3*t2, q1 = q0+1, q2 = q0+2;
+
+  set_V( n , v );
+  set_V( q0, v );  set_V( q1, b );  set_V( q2, c );
+  edit_glue( n , q2 );
+  edit_glue( q1, xn );
+  _O[q0] = -1;
+
+  HEid op = -1, r2 = -1, xop = -1;
+  Eid  eop = -1;
+  if( o >= 0 )
+  {
+    op = he_prev(o);
+    const Vid  d  = _V[op];
+    xop = _O[op];
+    eop = eh ? _E[op] : -1;
+
+    const TRid t3 = edit_new_trig();
+    const HEid r0 = 3*t3, r1 = r0+1;
+    r2 = r0+2;
+
+    set_V( o , v );
+    set_V( r0, b );  set_V( r1, v );  set_V( r2, d );
+    edit_glue( op, r1  );
+    edit_glue( r2, xop );
+    edit_glue( q0, r0  );
+  }
+
+  edit_edge( h , ee );
+  edit_edge( q1, en );
+  edit_edge( n , -1 );
+  edit_edge( q0, -1 );
+  if( o >= 0 )
+  {
+    edit_edge( r2, eop );
+    edit_edge( op, -1  );
+  }
+
+  HEid from[2], to[2];
+  int  nr = 0;
+  if( xn < 0 ) { from[nr] = n;  to[nr] = q1; ++nr; }
+  if( o >= 0 && xop < 0 ) { from[nr] = op; to[nr] = r2; ++nr; }
+  if( nr ) edit_rename( from, to, nr );
+  if( o < 0 ) edit_insert( h, q0 );
+
+  edit_VH( v, q0 );
+  edit_VH( b, q1 );
+  if( o >= 0 ) edit_VH( _V[r2], r2 );
+  touch_vertex( v );
+
+  return v;
+}
+//------------------------------------------------//
+const bool CHE_L2::remove_vertex( const Vid v )
+//------------------------------------------------//
+/** Removes a vertex by collapsing one of its edges.*/
+{
+  if( !v_valid(v) || edit_pinched(v) ) return false;
+
+  HEid h0 = has_VH() ? _VH[v] : first_he(v);
+  if( h0 < 0 ) return false;
+
+  // the half-edges leaving v, from the boundary one if v is on the boundary
+  HEid h = h0;
+  while( _O[h] >= 0 ) { h = he_next( _O[h] ); if( h == h0 ) break; }
+  h0 = h;
+
+  vector<HEid> out;
+  do { out.push_back( h ); h = _O[ he_prev(h) ]; } while( h >= 0 && h != h0 );
+
+  for(size_t i=0; i<out.size(); ++i)
+    if( collapse_edge( out[i] ) ) return true;
+  return false;
+}
+//------------------------------------------------//
@@ -19,10 +19,13 @@
 #include "Edge.hpp"
 #include "CHE_L1.hpp"
 
+/** \brief Edge id type */
+typedef  int  Eid;
+
 /** \brief Edge iterator */
-typedef  map<HEid, HEid>::iterator Eit;
+typedef  vector<HEid>::iterator Eit;
 /** \brief Edge constant iterator */
-typedef  map<HEid, HEid>::const_iterator Ecit;
+typedef  vector<HEid>::const_iterator Ecit;
 
 /** \brief standart namespace definition*/
 using namespace std;
@@ -34,18 +37,52 @@ using namespace std;
   * the relations between the triangles of the mesh (vector _O),
   * the connected compound of each vertex.(vector _C),
 	* a half-edge for each vertex (vector _VH)
-	* and the edges of the model (map _EH).
+	* and the edges of the model (vectors _EH and _E).
+  * 
+  * An edge is represented by its canonical half-edge h,
+  * the one with O(h) < 0 (boundary) or h < O(h). The edges are 
+  * stored flat: 4 bytes per edge in _EH and 4 bytes per 
+  * half-edge in _E, instead of a tree node per edge.
+  * 
+  * The mesh can be edited in place (collapse_edge, flip_edge,
+  * split_edge, remove_vertex): the tables are updated around the
+  * edited edge, the removed vertices, triangles and edges are left
+  * invalid and their ids are reused by the next insertions through
+  * free lists. The free lists are not stored in the snapshots.
+  * As the stars, the edits see a vertex through its fan: the mesh 
+  * must be manifold around the edited edges.
   * 
   * The class inherits the informations of CHE_L1.*/
 class CHE_L2:public CHE_L1
 {
+  /** \brief The subdivision writes the refined tables directly*/
+  friend class CHE_Subdivide;
+
 protected:
   /** \brief Vertex Half-Edge Table: For each vertex 
-     * we store a half-edge associated*/
-  vector<HEid>    _VH;
+     * we store a half-edge associated (built by the first 
+     * query that needs it, even a const one)*/
+  mutable vector<HEid>    _VH;
+
+  /** \brief Edge Table: For each edge we store its 
+     * canonical half-edge, in increasing order after compute_EH
+     * (INV for a removed edge)*/
+  mutable vector<HEid>    _EH;
 
-  /** \brief Edge Table: Map with the edges of the model */
-  map<HEid,HEid>  _EH;
+  /** \brief Half-Edge Edge Table: For each half-edge 
+     * we store the id of its edge*/
+  mutable vector<Eid>     _E;
+
+  /** \brief Free lists: ids of the removed triangles, vertices 
+     * and edges, reused by the edit operators*/
+  vector<TRid>    _FT;
+  vector<Vid>     _FV;
+  mutable vector<Eid>     _FE;
+
+  /** \brief Pinched Vertex Table: 1 for a vertex whose star has
+    * more than one fan (a bow-tie), which the edit operators
+    * leave alone (built by the first edit)*/
+  mutable vector<char>    _VP;
 
 public:
   /** \brief Default constructor.*/
@@ -54,43 +91,76 @@ public:
   /** \brief First constructor.
     * \param nvert  - Vid  CHE_L0 _nvert.
     * \param ntrig  - TRid CHE_L0 _ntrig.*/
-  CHE_L2(Vid nvert, TRid ntrig): CHE_L1(nvert, ntrig){ _VH.resize( nvert, -1 ); }
+  CHE_L2(Vid nvert, TRid ntrig): CHE_L1(nvert, ntrig){ _VH.resize( nvert, -1 ); _E.resize( 3*ntrig, -1 ); }
 
   /** \brief Copy constructor
     * \param c - const CHE_L2&.*/
-  CHE_L2(const CHE_L2& c): CHE_L1( c ) { _EH= c._EH; _VH=c._VH; }
+  CHE_L2(const CHE_L2& c): CHE_L1( c ) { _EH= c._EH; _E= c._E; _VH=c._VH; _FT= c._FT; _FV= c._FV; _FE= c._FE; _VP= c._VP; }
+
+  /** \brief Promotion constructor: takes the tables of a level 1
+    * structure without copying them (c is left empty). The vertex
+    * and edge tables are computed on demand: _VH by the first VH,
+    * R_00 or R_02, the edges by the first nedge, EH, E, draw_wire
+    * or check (call need_VH/need_EH before parallel traversals).
+    * \param c - CHE_L1&.*/
+  explicit CHE_L2(CHE_L1& c): CHE_L1() { CHE_L1::take( c ); }
 
    /** \brief Destructor.*/
-  virtual ~CHE_L2(){ _V.clear(); _G.clear(); _O.clear(); _C.clear(); _VH.clear(); _EH.clear(); }
+  virtual ~CHE_L2(){ _V.clear(); _G.clear(); _O.clear(); _C.clear(); _VH.clear(); _EH.clear(); _E.clear(); }
 
 public:
+   /** \brief Access to the number of edges of the model*/
+   inline const  Eid nedge() const{ need_EH(); return (Eid)_EH.size(); }
+   /** \brief Tests if the vertex table is computed*/
+   inline const bool has_VH() const { return (Vid)_VH.size() == nvert(); }
+   /** \brief Tests if the edge tables are computed*/
+   inline const bool has_EH() const { return (HEid)_E.size() == 3*ntrig(); }
    /** \brief Access to the edge table of the model*/
-   inline const map<HEid, HEid> &EH() const { return _EH ; }
-   /** \brief Access to an edge of the model  
-     * \param  e - const HEid*/
-   inline Ecit EH( const HEid e ) const{ return _EH.find(e); }
+   inline const vector<HEid> &EH() const { need_EH(); return _EH ; }
+   /** \brief Access to the canonical half-edge of an edge  
+     * \param  e - const Eid*/
+   inline HEid EH( const Eid e ) const{ if( e < 0 || e >= nedge() ) return INV; return _EH[e]; }
+   /** \brief Tests if an edge is valid (not removed by an edit)
+     * \param  e - const Eid*/
+   inline const bool e_valid( const Eid e ) const { return ( e >= 0 && e < nedge() && _EH[e] != INV ); }
+   /** \brief Access to the edge of a half-edge  
+     * \param  h - const HEid*/
+   inline  Eid E( const HEid h ) const{ if( !he_valid(h) ) return INV; need_EH(); return _E[h]; }
+   /** \brief Tests if a half-edge is the canonical half-edge of its edge  
+     * \param  h - const HEid*/
+   inline const bool e_canonical( const HEid h ) const { if( !he_valid(h) ) return false; HEid o = _O[h]; return ( o < 0 || h < o ); }
    /** \brief Access a half-edge of a vertex  
      * \param const Vid v    */
-   inline HEid VH( const Vid v ) const{if( !v_valid(v) ) return INV; return _VH[v]; }
+   inline HEid VH( const Vid v ) const{if( !v_valid(v) ) return INV; need_VH(); return _VH[v]; }
    /** \brief Tests if a vertex is valid
      * \param  v - const Vid */
-   inline const bool v_valid( const  Vid v ) const {return (CHE_L1::v_valid( v ) && _VH[v]!= INV); }
+   inline const bool v_valid( const  Vid v ) const {return (CHE_L1::v_valid( v ) && ( !has_VH() || _VH[v]!= INV )); }
    /** \brief Tests if a vertex is on bound
      * \param v - const Vid  */
-   inline const bool v_bound( const  Vid v ) const {return ( O(VH(v))==-1); }
+   inline const bool v_bound( const  Vid v ) const
+   {
+     if( !v_valid(v) ) return false;
+     if( has_VH() ) return ( O(VH(v))==-1);
+     for( HEid i=0; i<3*ntrig(); ++i ) if( _V[i] == v && _O[i] == -1 ) return true;
+     return false;
+   }
 
 public:
-   /** \brief Sets an edge of the model  
-     * \param e  - const HEid 
-     * \param ed - const HEid */
-   inline void set_EH( const HEid e, const HEid ed ) { _EH[e] = ed; }
+   /** \brief Sets the canonical half-edge of an edge  
+     * \param e - const Eid 
+     * \param h - const HEid */
+   inline void set_EH( const Eid e, const HEid h ) { if( e >= 0 && e < nedge() ) _EH[e] = h; }
+   /** \brief Sets the edge of a half-edge  
+     * \param h - const HEid 
+     * \param e - const Eid */
+   inline void set_E( const HEid h, const Eid e ) { if( h >= 0 && h < 3*ntrig() ) _E[h] = e; }
    /** \brief Sets an half-edge for a vertex  
      * \param v - const Vid
      * \param h - const HEid */
-   inline void set_VH( const Vid v, const HEid h ){ if( v_valid(v) ) _VH[v] = h; return; }
+   inline void set_VH( const Vid v, const HEid h ){ if( v_valid(v) && has_VH() ) _VH[v] = h; return; }
    /** \brief Sets a vertex invalid
      * \param v - const Vid  */
-   inline const void v_invalid( const  Vid v ){ if( v_valid(v) ){CHE_L0::v_invalid(v); _VH[v] = INV;} return; }
+   inline const void v_invalid( const  Vid v ){ if( v_valid(v) ){CHE_L0::v_invalid(v); if( has_VH() ) _VH[v] = INV;} return; }
 
 public:
   /** \brief Computes the vertices in the star of a given vertex 
@@ -100,20 +170,147 @@ public:
 	  * \param v - const Vid  */
   virtual vector<TRid> R_02( const Vid v  );
 
+  /** \brief Visits the vertices in the star of a given vertex, 
+    * starting from VH(v). Allocation free, nothing is printed.
+	  * \param v - const Vid
+	  * \param f - F& functor */
+  template <class F> inline bool visit_R_00( const Vid v, F &f ) const
+  { if( !has_VH() ) return CHE_L1::visit_R_00( v, f ); if( !v_valid(v) || _VH[v] < 0 ) return false; fan_R_00( _VH[v], f ); return true; }
+  /** \brief Visits the triangles in the star of a given vertex, 
+    * starting from VH(v). Allocation free, nothing is printed.
+	  * \param v - const Vid
+	  * \param f - F& functor */
+  template <class F> inline bool visit_R_02( const Vid v, F &f ) const
+  { if( !has_VH() ) return CHE_L1::visit_R_02( v, f ); if( !v_valid(v) || _VH[v] < 0 ) return false; fan_R_02( _VH[v], f ); return true; }
+
 public:
   /** \brief Computes the Edge table*/
-  void compute_EH();
+  void compute_EH() const;
   /** \brief Computes the Half-edge table*/
-  void compute_VH();
+  void compute_VH() const;
+  /** \brief Computes the Half-edge table if it was not computed yet*/
+  inline void need_VH() const { if( !has_VH() ) compute_VH(); }
+  /** \brief Computes the Edge table if it was not computed yet*/
+  inline void need_EH() const { if( !has_EH() ) compute_EH(); }
   /** \brief Checks the mesh*/
   void check();
+  /** \brief Empties the structure*/
+  virtual void clear();
 	/** \brief Draws the surface in wireframe with opengl*/
 	virtual void draw_wire() ;
 
+public:
+  /** \brief Tests if the edge of h can be collapsed without changing
+    * the topology: the common neighbours of its vertices are the
+    * opposite vertices of the edge (link condition), an interior edge
+    * does not join two boundary vertices, none of its vertices is
+    * pinched and no triangle becomes degenerated
+	  * \param h - const HEid */
+  const bool can_collapse( const HEid h ) const;
+  /** \brief Collapses the edge of h: the vertex V(h) is removed and its
+    * half-edges are given to V(next(h)), which keeps its position.
+    * The one or two triangles of the edge are removed.
+    * Returns false (and changes nothing) if can_collapse(h) fails.
+	  * \param h - const HEid */
+  const bool collapse_edge( const HEid h );
+  /** \brief Tests if the interior edge of h can be flipped: the two
+    * other vertices of its triangles are not already joined (and 
+    * are not both pinched)
+	  * \param h - const HEid */
+  const bool can_flip( const HEid h ) const;
+  /** \brief Flips the interior edge of h: the two triangles of the edge
+    * keep their ids and are rebuilt on the other diagonal, h and O(h)
+    * keep their edge. Returns false if can_flip(h) fails.
+	  * \param h - const HEid */
+  const bool flip_edge( const HEid h );
+  /** \brief Splits the edge of h at its midpoint: the new vertex is
+    * returned (INV if h is invalid), and each triangle of the edge is
+    * split in two. h keeps the first half of the edge.
+	  * \param h - const HEid */
+  Vid  split_edge( const HEid h );
+  /** \brief Removes a vertex, collapsing one of its edges onto a
+    * neighbour: the hole is filled by the fan of this neighbour.
+    * Returns false if no edge of v can be collapsed or v is pinched.
+	  * \param v - const Vid */
+  const bool remove_vertex( const Vid v );
+
 public:
 	/** \brief Reads a 3D model in the .ply format
 	  * \param file - const char* */
   void  read_ply( const char* file );
+
+protected:
+  /** \brief Level of the structure, stored in the snapshots*/
+  virtual const int snapshot_level() const { return 2; }
+  /** \brief Adds the tables of the level to a snapshot
+    * \param w - Snapshot_writer& */
+  virtual void write_tables( Snapshot_writer &w ) const;
+  /** \brief Reads the tables of the level from a snapshot
+    * \param r - const Snapshot_reader& */
+  virtual bool read_tables ( const Snapshot_reader &r );
+  /** \brief Applies a permutation of the vertices and of the triangles
+    * to the tables of the level
+    * \param vnew - const vector<Vid>&
+    * \param tnew - const vector<TRid>& */
+  virtual void remap( const vector<Vid> &vnew, const vector<TRid> &tnew );
+  /** \brief Computes the tables built on demand*/
+  virtual void materialize();
+  /** \brief Takes the tables of c, which is left empty
+    * \param c - CHE_L2& */
+  void take( CHE_L2 &c );
+
+protected:
+  /** \brief Triangle for an edit: a free one, or a new one at the end
+    * of the tables. Its half-edges must all be set by the caller.*/
+  TRid edit_new_trig();
+  /** \brief Vertex for an edit: a free one, or a new one at the end
+    * of the tables
+    * \param p - const Vertex&  position
+    * \param c - const Cid  compound*/
+  Vid  edit_new_vertex( const Vertex &p, const Cid c );
+  /** \brief Removes a triangle and puts it in the free list
+    * \param t - const TRid */
+  void edit_free_trig( const TRid t );
+  /** \brief Removes a vertex and puts it in the free list
+    * \param v - const Vid */
+  void edit_free_vertex( const Vid v );
+  /** \brief Removes an edge and puts it in the free list
+    * \param e - const Eid */
+  void edit_free_edge( const Eid e );
+  /** \brief Makes two half-edges opposite, a negative one
+    * leaving the other on the boundary
+    * \param h, o - const HEid */
+  void edit_glue( const HEid h, const HEid o );
+  /** \brief Gives the edge e to h and its opposite, and sets its
+    * canonical half-edge (a new edge if e < 0)
+    * \param h - const HEid
+    * \param e - Eid */
+  void edit_edge( const HEid h, Eid e );
+  /** \brief Sets VH(v) from a half-edge leaving v, rotating to the
+    * boundary half-edge of its fan if there is one
+    * \param v - const Vid
+    * \param h - const HEid */
+  void edit_VH( const Vid v, const HEid h );
+  /** \brief Tests if the vertex of h is on the boundary, rotating around it
+    * \param h - const HEid */
+  const bool edit_bound( const HEid h ) const;
+  /** \brief Tests if the star of a vertex has more than one fan
+    * \param v - const Vid */
+  inline const bool edit_pinched( const Vid v ) const { if( (Vid)_VP.size() != nvert() ) compute_VP(); return v >= 0 && v < nvert() && _VP[v]; }
+  /** \brief Computes the pinched vertex table*/
+  void compute_VP() const;
+
+  /** \brief Boundary half-edges renamed by an edit, all at once
+    * (for the boundary curves of the upper level)
+    * \param from, to - const HEid*
+    * \param n - const int */
+  virtual void edit_rename( const HEid * /*from*/, const HEid * /*to*/, const int /*n*/ ) {}
+  /** \brief Boundary half-edge n inserted after h by a split
+    * \param h, n - const HEid */
+  virtual void edit_insert( const HEid /*h*/, const HEid /*n*/ ) {}
+  /** \brief Boundary half-edge h removed by a collapse
+    * \param h - const HEid */
+  virtual void edit_remove( const HEid /*h*/ ) {}
 };
 #endif
 //-------------------------------------//
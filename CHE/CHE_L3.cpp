@@ -12,46 +12,64 @@
 
 #include <GL/glut.h>
 #include <ctime>
+#include <algorithm>
 
 #include "CHE_L3.hpp"
+#include "../common/Snapshot.hpp"
 
 using namespace std;
 //--------------------------------------------------//
-void CHE_L3::compute_CH()
+void CHE_L3::compute_CH() const
 //--------------------------------------------------//
 /** Computes the vertex Boundary Curves table.*/
 {
   cout << "Pet_CHE::compute_CH...   " ;
-   
-  vector<bool> vst;
-	vst.resize(3*ntrig(), false);
-	
-   _CH.clear();
-   for(HEid he=0; he<3*ntrig(); ++he)
-   {
-	   if(O(he) == -1 && vst[he] == false)
-	   {
-		   HEid he0 = he;
-		   _CH.push_back(he0); // add boundary curve representative
-		   _ncurves++;              // increment number of curves
-		   do                              // walk throght the boundary
-		   {
-			   // _O[he0] = -(ncurves() + 1); // set half--edge component
-			   vst[he0] = true;                     // mark half--edge as visited
-
-         while(O(next(he0)) >= 0) {
-          //get the next half--edge in the boundary
-			    he0 = O( next(he0) );
-         }
-         // real next boundary he.
-         he0 = next(he0);
-			}
-			while(he0 != he);
-      break;
-     }
-   }
-  vst.clear();
-  cout << " done." << endl;
+
+  const HEid nh = 3*ntrig();
+
+  // boundary half-edges, in increasing order
+  vector<HEid> bh;
+  for(HEid h=0; h<nh; ++h)
+    if( he_valid(h) && _O[h] == -1 ) bh.push_back( h );
+  const int nb = (int)bh.size();
+
+  // next boundary half-edge of each one: the fan of the vertex of
+  // its next is rotated until the boundary is reached
+  vector<int> pos( nh, -1 ), link( nb, -1 );
+  #pragma omp parallel for schedule(static)
+  for(int k=0; k<nb; ++k) pos[ bh[k] ] = k;
+
+  #pragma omp parallel for schedule(static)
+  for(int k=0; k<nb; ++k)
+  {
+    HEid n = he_next( bh[k] );
+    for( HEid s=0; _O[n] >= 0 && s < nh; ++s ) n = he_next( _O[n] );
+    if( _O[n] == -1 ) link[k] = pos[n];
+  }
+
+  // each curve is walked once, from its smallest half-edge
+  _CH.clear();
+  _CO.clear();
+  _CB.clear();
+  _CB.reserve( nb );
+  vector<char> vst( nb, 0 );
+  for(int k=0; k<nb; ++k)
+  {
+    if( vst[k] ) continue;
+
+    _CH.push_back( bh[k] );  // add boundary curve representative
+    _CO.push_back( (int)_CB.size() );
+    for( int j=k; j >= 0 && !vst[j]; j = link[j] )
+    {
+      vst[j] = 1;
+      _CB.push_back( bh[j] );
+    }
+  }
+  _CO.push_back( (int)_CB.size() );
+  _ncurves = (Cid)_CH.size();
+  index_CB();
+
+  cout << " " << ncurves() << " curves found." << endl;
 }
 //--------------------------------------------------//
 void CHE_L3::check()
@@ -59,6 +77,7 @@ void CHE_L3::check()
 /** Checks the mesh.*/
 {
   CHE_L2::check();
+  need_CB();
 
   if( ncurves() != static_cast<int>(_CH.size()) ) {
     cout << "ncurves != _CH.size()." << endl; 
@@ -66,23 +85,41 @@ void CHE_L3::check()
   }
 
   for(HEid i=0; i<3*ntrig(); ++i){
+    if( !he_valid(i) ) continue;
     if(O(i) < -(ncurves()+1)) {
       cout << "O(" << i << ") < ncurves()." << endl;
       return;
     }
   }
+
+  if( (Cid)_CO.size() != ncurves()+1 || _CO[ncurves()] != (int)_CB.size() ) {
+    cout << "_CO does not match _CB." << endl; 
+    return;
+  }
+
+  for(Cid b=0; b<ncurves(); ++b){
+    const HEid *c = curve(b);
+    for(int k=0; k<clength(b); ++k){
+      if( O(c[k]) != -1 || V(next(c[k])) != V(c[(k+1)%clength(b)]) ) {
+        cout << "Boundary curve " << b << " broken at " << c[k] << "." << endl;
+        return;
+      }
+    }
+  }
 }
 //--------------------------------------------------//
 void CHE_L3::draw_wire()
 //--------------------------------------------------//
 /** Draws the surface in wireframe with opengl.*/
 {
+  need_EH();
   for(Ecit i= EH().begin(); i!= EH().end(); ++i)
 	{
-		const Vertex &v1 = G(V(   i->first     ));
-		const Vertex &v2 = G(V( next(i->first) ));
+		if( *i < 0 ) continue;
+		const Vertex v1 = vertex(V(   *i     ));
+		const Vertex v2 = vertex(V( next(*i) ));
 
-    if(O(i->first) < 0) glColor3f(1.0,0.2,0.2);
+    if(O(*i) < 0) glColor3f(1.0,0.2,0.2);
     else glColor3f(0.6,0.6,0.6);
 
 		glBegin(GL_LINES);
@@ -112,3 +149,174 @@ void CHE_L3::read_ply( const char* file )
   //cout << "L3 load time:" << static_cast<double>(L3_time-start_time)/static_cast<double>(CLOCKS_PER_SEC) << endl;
 }
 //-------------------------------------------------------------//
+void CHE_L3::write_tables( Snapshot_writer &w ) const
+//-------------------------------------------------------------//
+/** Adds the boundary curve table.*/
+{
+  CHE_L2::write_tables( w );
+  need_CB();
+  w.add( "CH", _CH );
+  w.add( "CO", _CO );
+  w.add( "CB", _CB );
+}
+//-------------------------------------------------------------//
+bool CHE_L3::read_tables( const Snapshot_reader &r )
+//-------------------------------------------------------------//
+/** Reads the boundary curve table.*/
+{
+  if( !CHE_L2::read_tables( r ) || !r.get( "CH", _CH ) || !r.get( "CO", _CO ) || !r.get( "CB", _CB ) ) return false;
+  _ncurves = (Cid)_CH.size();
+  if( (Cid)_CO.size() != ncurves()+1 ) return false;
+  index_CB();
+  return true;
+}
+//-------------------------------------------------------------//
+void CHE_L3::remap( const vector<Vid> &vnew, const vector<TRid> &tnew )
+//-------------------------------------------------------------//
+/** Permutes the boundary curve table. The invalid and empty curves
+  * are squeezed out; if a boundary half-edge is dropped, the curves
+  * are computed again.*/
+{
+  CHE_L2::remap( vnew, tnew );
+  if( !has_CH() ) return;
+  need_CB();
+
+  for(int k=0; k<(int)_CB.size(); ++k)
+  {
+    _CB[k] = remap_he( _CB[k], tnew );
+    if( _CB[k] < 0 ) { compute_CH(); return; }
+  }
+
+  Cid nc = 0;
+  int n  = 0;
+  for(Cid b=0; b<_ncurves; ++b)
+  {
+    const int k0 = _CO[b], k1 = _CO[b+1];
+    if( _CH[b] < 0 || k1 == k0 ) continue;
+    _CO[nc] = n;
+    for(int k=k0; k<k1; ++k) _CB[n++] = _CB[k];
+    _CH[nc] = _CB[ _CO[nc] ];
+    ++nc;
+  }
+  _CO[nc] = n;
+  _CO.resize( nc+1 );
+  _CB.resize( n );
+  _CH.resize( nc );
+  _ncurves = nc;
+  index_CB();
+}
+//-------------------------------------------------------------//
+void CHE_L3::materialize()
+//-------------------------------------------------------------//
+/** Computes the vertex, edge and boundary curve tables of a promoted structure.*/
+{
+  CHE_L2::materialize();
+  need_CH();
+}
+//-------------------------------------------------------------//
+void CHE_L3::clear()
+//-------------------------------------------------------------//
+/** Clears the boundary curve tables.*/
+{
+  CHE_L2::clear();
+  _CH.clear(); _CO.clear(); _CB.clear(); _CK.clear();
+  _ncurves = 0;
+}
+//-------------------------------------------------------------//
+void CHE_L3::index_CB() const
+//-------------------------------------------------------------//
+/** Computes the curve of each boundary half-edge of _CB.*/
+{
+  _CK.assign( 3*ntrig(), -1 );
+  for(Cid b=0; b+1<(Cid)_CO.size(); ++b)
+    for(int k=_CO[b]; k<_CO[b+1] && k<(int)_CB.size(); ++k)
+      if( _CB[k] >= 0 && _CB[k] < 3*ntrig() ) _CK[ _CB[k] ] = b;
+}
+//-------------------------------------------------------------//
+void CHE_L3::pack_CB() const
+//-------------------------------------------------------------//
+/** Lists the half-edges of each curve in _CB, walking the curve
+  * as compute_CH from its representative, or from its smallest 
+  * half-edge if the representative left the curve. A curve left 
+  * empty by the edits gets an INV representative.*/
+{
+  const HEid nh = 3*ntrig();
+  if( (HEid)_CK.size() < nh ) _CK.resize( nh, -1 );
+
+  vector<HEid> first( _ncurves, -1 );
+  _CO.assign( _ncurves+1, 0 );
+  for(HEid h=0; h<nh; ++h)
+  {
+    const Cid b = _CK[h];
+    if( b < 0 || b >= _ncurves ) continue;
+    if( first[b] < 0 ) first[b] = h;
+    ++_CO[b+1];
+  }
+  for(Cid b=0; b<_ncurves; ++b) _CO[b+1] += _CO[b];
+
+  _CB.assign( _CO[_ncurves], -1 );
+  for(Cid b=0; b<_ncurves; ++b)
+  {
+    HEid h0 = _CH[b];
+    if( h0 < 0 || h0 >= nh || _CK[h0] != b ) h0 = first[b];
+    if( _CH[b] != INV ) _CH[b] = ( h0 < 0 ) ? INV : h0;
+    if( h0 < 0 ) continue;
+
+    int  k = _CO[b];
+    HEid h = h0;
+    do
+    {
+      _CB[k++] = h;
+      h = he_next( h );
+      for( HEid s=0; _O[h] >= 0 && s < nh; ++s ) h = he_next( _O[h] );
+    }
+    while( h != h0 && k < _CO[b+1] && _CK[h] == b );
+  }
+}
+//-------------------------------------------------------------//
+void CHE_L3::edit_rename( const HEid *from, const HEid *to, const int n )
+//-------------------------------------------------------------//
+/** Renames half-edges in the boundary curves. The renamings are 
+  * simultaneous: a half-edge can be renamed and be the new name of 
+  * another one.*/
+{
+  if( !has_CH() || n <= 0 ) return;
+  if( (HEid)_CK.size() < 3*ntrig() ) _CK.resize( 3*ntrig(), -1 );
+
+  Cid  b[4];
+  bool r[4];
+  for(int i=0; i<n; ++i) { b[i] = curve_of( from[i] ); r[i] = ( b[i] >= 0 && _CH[ b[i] ] == from[i] ); }
+  for(int i=0; i<n; ++i) if( b[i] >= 0 ) _CK[ from[i] ] = -1;
+  for(int i=0; i<n; ++i)
+  {
+    if( b[i] < 0 ) continue;
+    _CK[ to[i] ] = b[i];
+    if( r[i] ) _CH[ b[i] ] = to[i];
+  }
+  _CO.clear();
+}
+//-------------------------------------------------------------//
+void CHE_L3::edit_insert( const HEid h, const HEid n )
+//-------------------------------------------------------------//
+/** Inserts a half-edge in a boundary curve, after h.*/
+{
+  if( !has_CH() ) return;
+
+  if( (HEid)_CK.size() < 3*ntrig() ) _CK.resize( 3*ntrig(), -1 );
+  const Cid b = curve_of( h );
+  if( b < 0 ) return;
+
+  _CK[n] = b;
+  _CO.clear();
+}
+//-------------------------------------------------------------//
+void CHE_L3::edit_remove( const HEid h )
+//-------------------------------------------------------------//
+/** Removes a half-edge from a boundary curve.*/
+{
+  if( !has_CH() || curve_of( h ) < 0 ) return;
+
+  _CK[h] = -1;
+  _CO.clear();
+}
+//-------------------------------------------------------------//
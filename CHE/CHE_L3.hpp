@@ -29,8 +29,9 @@ using namespace std;
   * the relations between the triangles of the mesh (vector _O),
   * the connected compound of each vertex.(vector _C),
   * a half-edge for each vertex (vector _VH)
-  * the edges of the model (map _EH),
-  * and the boundary curves (vector _CH)
+  * the edges of the model (vectors _EH and _E),
+  * and the boundary curves (vector _CH, and their 
+  * half-edges curve by curve in _CO/_CB)
   * 
   * The class inherits the informations of CHE_L2.*/
 class CHE_L3:public CHE_L2
@@ -38,37 +39,77 @@ class CHE_L3:public CHE_L2
 protected:
   /** \brief Boundary Curves Table: 
     * For each boundary curve we store one 
-    * representative half-edge*/
-  vector<HEid>  _CH;
+    * representative half-edge (built by the first query 
+    * that needs it, even a const one)*/
+  mutable vector<HEid>  _CH;
+
+  /** \brief Boundary Curves Offsets: the half-edges of
+    * curve b are _CB[_CO[b]] to _CB[_CO[b+1]-1] (emptied by 
+    * the edits, and packed again from _CK on demand)*/
+  mutable vector<int>   _CO;
+
+  /** \brief Boundary Curves half-edges, curve by curve,
+    * in the order of the walk along each curve*/
+  mutable vector<HEid>  _CB;
+
+  /** \brief Curve of each half-edge, -1 if it is not on 
+    * the boundary*/
+  mutable vector<Cid>   _CK;
 
   /** \brief Number Boundary curves
     *
     * Protected data that stores the number
     * of boundary curves of the mesh*/
-  Cid   _ncurves;
+  mutable Cid   _ncurves;
 public:
   /** \brief Default constructor.*/
-  CHE_L3(): CHE_L2() {}
+  CHE_L3(): CHE_L2(), _ncurves(0) {}
 
   /** \brief First constructor.
     * \param nvert  - Vid  CHE_L0 _nvert.
     * \param ntrig  - TRid CHE_L0 _ntrig.*/
-  CHE_L3(Vid nvert, TRid ntrig): CHE_L2(nvert, ntrig){ }
+  CHE_L3(Vid nvert, TRid ntrig): CHE_L2(nvert, ntrig), _ncurves(0) { }
 
   /** \brief Copy constructor
     * \param c - const CHE_L3&.*/
-  CHE_L3(const CHE_L3& c): CHE_L2( c ) { _CH= c._CH; }
+  CHE_L3(const CHE_L3& c): CHE_L2( c ), _ncurves( c._ncurves ) { _CH= c._CH; _CO= c._CO; _CB= c._CB; _CK= c._CK; }
+
+  /** \brief Promotion constructor: takes the tables of a level 2
+    * structure without copying them (c is left empty). The boundary
+    * curves are computed by the first ncurves, CH or curves query
+    * (call need_CH before parallel traversals).
+    * \param c - CHE_L2&.*/
+  explicit CHE_L3(CHE_L2& c): CHE_L2(), _ncurves(-1) { CHE_L2::take( c ); }
 
    /** \brief Destructor.*/
-  virtual ~CHE_L3(){ _V.clear(); _G.clear(); _O.clear(); _C.clear(); _VH.clear(); _EH.clear(); _CH.clear(); }
+  virtual ~CHE_L3(){ _V.clear(); _G.clear(); _O.clear(); _C.clear(); _VH.clear(); _EH.clear(); _CH.clear(); _CO.clear(); _CB.clear(); _CK.clear(); }
 
 public:
 	/** \brief Access to the number of boundary curves of the model*/
-	inline const  Cid ncurves() const{ return _ncurves; }
+	inline const  Cid ncurves() const{ need_CH(); return _ncurves; }
+
+  /** \brief Access to the boundary curves: one representative
+    * half-edge per curve*/
+  inline const vector<HEid> &curves() const { need_CH(); return _CH; }
+
+  /** \brief Tests if the boundary curves are computed*/
+  inline const bool has_CH() const { return _ncurves >= 0; }
 
-  /** \brief Access the representative of a boundary compound  
-    * \param const Vid v*/
-   inline HEid CH( const Vid v ) const{if( !v_valid(v) ) return INV; return _VH[v]; }
+  /** \brief Tests if the half-edges of the curves are packed in _CB*/
+  inline const bool has_CB() const { return has_CH() && (Cid)_CO.size() == _ncurves+1; }
+
+  /** \brief Access the representative of a boundary curve  
+    * \param const Cid b*/
+   inline HEid CH( const Cid b ) const{if( !b_valid(b) ) return INV; need_CB(); return _CH[b]; }
+
+  /** \brief Access to the number of half-edges of a boundary curve  
+    * \param const Cid b*/
+   inline int clength( const Cid b ) const{if( !b_valid(b) ) return 0; need_CB(); return _CO[b+1]-_CO[b]; }
+
+  /** \brief Access to the half-edges of a boundary curve, in order
+    * along the curve (clength(b) of them, until the next edit)
+    * \param const Cid b*/
+   inline const HEid *curve( const Cid b ) const{if( clength(b) == 0 ) return NULL; return &_CB[ _CO[b] ]; }
  	
    /** \brief Tests if a boundary is valid
      * \param const Vid v*/
@@ -90,9 +131,16 @@ public:
 
 public:
   /** \brief Computes the Boundary Curves table*/
-  void compute_CH();
+  void compute_CH() const;
+  /** \brief Computes the Boundary Curves table if it was not computed yet*/
+  inline void need_CH() const { if( !has_CH() ) compute_CH(); }
+  /** \brief Packs the half-edges of the curves in _CB if an edit
+    * changed them (before parallel traversals)*/
+  inline void need_CB() const { need_CH(); if( !has_CB() ) pack_CB(); }
   /** \brief Checks the mesh*/
   void check();
+  /** \brief Empties the structure*/
+  virtual void clear();
   /** \brief Draws the surface in wireframe with opengl*/
   virtual void draw_wire() ;
 
@@ -100,6 +148,45 @@ public:
 	/** \brief Reads a 3D model in the .ply format
 	  * \param file - const char* */
   void  read_ply( const char* file );
+
+protected:
+  /** \brief Level of the structure, stored in the snapshots*/
+  virtual const int snapshot_level() const { return 3; }
+  /** \brief Adds the tables of the level to a snapshot
+    * \param w - Snapshot_writer& */
+  virtual void write_tables( Snapshot_writer &w ) const;
+  /** \brief Reads the tables of the level from a snapshot
+    * \param r - const Snapshot_reader& */
+  virtual bool read_tables ( const Snapshot_reader &r );
+  /** \brief Applies a permutation of the vertices and of the triangles
+    * to the tables of the level
+    * \param vnew - const vector<Vid>&
+    * \param tnew - const vector<TRid>& */
+  virtual void remap( const vector<Vid> &vnew, const vector<TRid> &tnew );
+  /** \brief Computes the tables built on demand*/
+  virtual void materialize();
+
+  /** \brief Curve of a half-edge, -1 if it is not on the boundary
+    * \param h - const HEid */
+  inline Cid curve_of( const HEid h ) const { return ( h >= 0 && h < (HEid)_CK.size() ) ? _CK[h] : -1; }
+  /** \brief Computes the curves _CK from _CO/_CB*/
+  void index_CB() const;
+  /** \brief Computes _CO/_CB from the curves _CK, walking each
+    * curve from its representative*/
+  void pack_CB() const;
+  /** \brief Renames boundary half-edges in the curves, after an edit
+    * (at most four, found through _CK)
+    * \param from, to - const HEid*
+    * \param n - const int */
+  virtual void edit_rename( const HEid *from, const HEid *to, const int n );
+  /** \brief Inserts the boundary half-edge n after h in its curve
+    * (only its curve is set, _CB is packed again on demand)
+    * \param h, n - const HEid */
+  virtual void edit_insert( const HEid h, const HEid n );
+  /** \brief Removes the boundary half-edge h from its curve
+    * (only its curve is cleared, _CB is packed again on demand)
+    * \param h - const HEid */
+  virtual void edit_remove( const HEid h );
 };
 #endif
 //-----------------------------------------------------------------------//
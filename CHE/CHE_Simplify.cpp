@@ -0,0 +1,460 @@
+/**
+* @file    CHE_Simplify.cpp
+*
+* @brief  (Quadric error simplification of the Compact Half-Edge Structure - Level 2)
+*/
+
+#include <algorithm>
+
+#include "CHE_Simplify.hpp"
+#include "../common/Parallel.hpp"
+
+using namespace std;
+
+//--------------------------------------------------//
+/** Edge of the heap, with the vertices and their versions at the time
+  * it was pushed: it is obsolete if one of them has changed*/
+struct Qem_edge
+//--------------------------------------------------//
+{
+  double cost;
+  HEid   h;
+  Vid    a, b;
+  int    sa, sb;
+  inline bool operator < ( const Qem_edge &e ) const { return cost > e.cost; }
+};
+//--------------------------------------------------//
+/** Order of the edges in the rounds: by cost, then by half-edge*/
+static inline bool qem_less( const HEid h, const HEid g, const double *cost )
+//--------------------------------------------------//
+{
+  if( g < 0 ) return h >= 0;
+  if( h < 0 ) return false;
+  return cost[h] < cost[g] || ( cost[h] == cost[g] && h < g );
+}
+//--------------------------------------------------//
+/** Order of the edges in the rounds, for sort*/
+struct Qem_order
+//--------------------------------------------------//
+{
+  const double *cost;
+  Qem_order( const double *c ) : cost(c) {}
+  inline bool operator()( const HEid h, const HEid g ) const { return qem_less( h, g, cost ); }
+};
+//--------------------------------------------------//
+/** Smallest edge of the vertices of a ring*/
+struct Qem_min
+//--------------------------------------------------//
+{
+  const HEid   *m;
+  const double *cost;
+  HEid          best;
+  Qem_min( const HEid *m_, const double *c, const HEid b ) : m(m_), cost(c), best(b) {}
+  inline void operator()( const Vid w ) { if( qem_less( m[w], best, cost ) ) best = m[w]; }
+};
+//--------------------------------------------------//
+/** Adds the vertices of a ring to the vertices at distance k of the
+  * moved ones*/
+struct Qem_grow
+//--------------------------------------------------//
+{
+  vector<int> &lvl;
+  vector<Vid> &ring;
+  int          k;
+  Qem_grow( vector<int> &l, vector<Vid> &r, const int k_ ) : lvl(l), ring(r), k(k_) {}
+  inline void operator()( const Vid w ) { if( lvl[w] > k ) { lvl[w] = k; ring.push_back( w ); } }
+};
+//--------------------------------------------------//
+TRid CHE_Simplify::simplify()
+//--------------------------------------------------//
+/** Simplifies the mesh down to the target.*/
+{
+  _m.need_VH();
+
+  TRid nt = 0;
+  #pragma omp parallel for reduction(+:nt)
+  for(TRid t=0; t<_m.ntrig(); ++t) if( _m.tr_valid(t) ) ++nt;
+  const TRid n0 = nt;
+
+  cout << "Pet_CHE::simplify...  " ;
+
+  compute_quadrics();
+  nt = _rounds ? simplify_rounds( nt ) : simplify_heap( nt );
+
+  cout << " " << n0-nt << " triangles removed, " << nt << " left." << endl;
+  return nt;
+}
+//--------------------------------------------------//
+void CHE_Simplify::compute_quadrics()
+//--------------------------------------------------//
+/** Sums the planes of the triangles and of the boundary edges of each vertex.*/
+{
+  const Vid nv = _m.nvert();
+  _Q.assign( nv, Quadric() );
+  _pinched.assign( nv, 0 );
+
+  // number of triangles of each vertex, to find the stars that are not
+  // reached from their half-edge
+  vector<int> deg( nv, 0 );
+  for(HEid h=0; h<3*_m.ntrig(); ++h) if( _m.he_valid(h) ) ++deg[ _m.V(h) ];
+
+  #pragma omp parallel
+  {
+    vector<TRid> ts;
+    Star_collector<TRid> f( ts );
+
+    #pragma omp for schedule(dynamic,1024)
+    for(Vid v=0; v<nv; ++v)
+    {
+      if( !_m.v_valid(v) ) continue;
+      ts.clear();
+      _m.visit_R_02( v, f );
+      _pinched[v] = ( (int)ts.size() != deg[v] );
+
+      for(size_t i=0; i<ts.size(); ++i)
+      {
+        const HEid h0 = 3*ts[i];
+        const Vid  a = _m.V(h0), b = _m.V(h0+1), c = _m.V(h0+2);
+        const double u[3] = { _m.x(b)-_m.x(a), _m.y(b)-_m.y(a), _m.z(b)-_m.z(a) };
+        const double w[3] = { _m.x(c)-_m.x(a), _m.y(c)-_m.y(a), _m.z(c)-_m.z(a) };
+        double n[3] = { u[1]*w[2]-u[2]*w[1], u[2]*w[0]-u[0]*w[2], u[0]*w[1]-u[1]*w[0] };
+        const double l = sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+        if( l == 0 ) continue;
+        n[0] /= l;  n[1] /= l;  n[2] /= l;
+        _Q[v] += Quadric( n[0], n[1], n[2], -( n[0]*_m.x(a) + n[1]*_m.y(a) + n[2]*_m.z(a) ), l/2 );
+
+        // planes through the boundary edges of v, orthogonal to the triangle
+        if( _bweight <= 0 ) continue;
+        for(int j=0; j<3; ++j)
+        {
+          const HEid e = h0+j;
+          const Vid  p = _m.V(e), q = _m.V( _m.next(e) );
+          if( _m.O(e) >= 0 || ( p != v && q != v ) ) continue;
+          const double d[3] = { _m.x(q)-_m.x(p), _m.y(q)-_m.y(p), _m.z(q)-_m.z(p) };
+          double m[3] = { d[1]*n[2]-d[2]*n[1], d[2]*n[0]-d[0]*n[2], d[0]*n[1]-d[1]*n[0] };
+          const double k = sqrt( m[0]*m[0] + m[1]*m[1] + m[2]*m[2] );
+          if( k == 0 ) continue;
+          m[0] /= k;  m[1] /= k;  m[2] /= k;
+          _Q[v] += Quadric( m[0], m[1], m[2], -( m[0]*_m.x(p) + m[1]*_m.y(p) + m[2]*_m.z(p) ), _bweight * ( d[0]*d[0] + d[1]*d[1] + d[2]*d[2] ) );
+        }
+      }
+    }
+  }
+}
+//--------------------------------------------------//
+double CHE_Simplify::edge_cost( const HEid h, double *p ) const
+//--------------------------------------------------//
+/** Minimizes the sum of the quadrics of the vertices of the edge.*/
+{
+  const Vid a = _m.V(h), b = _m.V( _m.next(h) );
+  if( _pinched[a] || _pinched[b] ) return DBL_MAX;
+  Quadric q = _Q[a];
+  q += _Q[b];
+
+  double c;
+  if( q.optimum( p ) ) c = q.eval( p[0], p[1], p[2] );
+  else
+  {
+    // singular quadric (flat or straight neighbourhood): best of the
+    // vertices and of the midpoint
+    const double ca = q.eval( _m.x(a), _m.y(a), _m.z(a) );
+    const double cb = q.eval( _m.x(b), _m.y(b), _m.z(b) );
+    const double mx = ( _m.x(a)+_m.x(b) ) / 2, my = ( _m.y(a)+_m.y(b) ) / 2, mz = ( _m.z(a)+_m.z(b) ) / 2;
+    const double cm = q.eval( mx, my, mz );
+    if( cm <= ca && cm <= cb ) { p[0] = mx; p[1] = my; p[2] = mz; c = cm; }
+    else if( ca <= cb )        { p[0] = _m.x(a); p[1] = _m.y(a); p[2] = _m.z(a); c = ca; }
+    else                       { p[0] = _m.x(b); p[1] = _m.y(b); p[2] = _m.z(b); c = cb; }
+  }
+  if( c < 0 ) c = 0;
+  return ( c > _error ) ? DBL_MAX : c;
+}
+//--------------------------------------------------//
+bool CHE_Simplify::flips( const HEid h, const double *p ) const
+//--------------------------------------------------//
+/** Compares the normals of the remaining triangles before and after the collapse.*/
+{
+  const Vid a = _m.V(h), b = _m.V( _m.next(h) );
+
+  vector<TRid> ts;
+  Star_collector<TRid> f( ts );
+  _m.visit_R_02( a, f );
+  _m.visit_R_02( b, f );
+
+  for(size_t i=0; i<ts.size(); ++i)
+  {
+    const HEid h0 = 3*ts[i];
+    Vid v[3] = { _m.V(h0), _m.V(h0+1), _m.V(h0+2) };
+    double x[3][3], y[3][3];
+    int moved = 0;
+    for(int j=0; j<3; ++j)
+    {
+      x[j][0] = y[j][0] = _m.x(v[j]);
+      x[j][1] = y[j][1] = _m.y(v[j]);
+      x[j][2] = y[j][2] = _m.z(v[j]);
+      if( v[j] == a || v[j] == b ) { y[j][0] = p[0]; y[j][1] = p[1]; y[j][2] = p[2]; ++moved; }
+    }
+    // the triangles of the edge are removed
+    if( moved != 1 ) continue;
+
+    double n[2][3];
+    for(int k=0; k<2; ++k)
+    {
+      const double (*g)[3] = k ? y : x;
+      const double u[3] = { g[1][0]-g[0][0], g[1][1]-g[0][1], g[1][2]-g[0][2] };
+      const double w[3] = { g[2][0]-g[0][0], g[2][1]-g[0][1], g[2][2]-g[0][2] };
+      n[k][0] = u[1]*w[2]-u[2]*w[1];  n[k][1] = u[2]*w[0]-u[0]*w[2];  n[k][2] = u[0]*w[1]-u[1]*w[0];
+    }
+    const double n0 = n[0][0]*n[0][0] + n[0][1]*n[0][1] + n[0][2]*n[0][2];
+    if( n0 == 0 ) continue;
+    if( n[0][0]*n[1][0] + n[0][1]*n[1][1] + n[0][2]*n[1][2] <= 0 ) return true;
+  }
+  return false;
+}
+//--------------------------------------------------//
+int CHE_Simplify::collapse( const HEid h, const double *p )
+//--------------------------------------------------//
+/** Collapses V(h) onto V(next(h)), which is moved to p.*/
+{
+  const Vid  a = _m.V(h), b = _m.V( _m.next(h) );
+  const HEid o = _m.O(h);
+  if( !_m.collapse_edge( h ) ) return 0;
+
+  _m.set_position( b, p[0], p[1], p[2] );
+  _Q[b] += _Q[a];
+  return ( o >= 0 ) ? 2 : 1;
+}
+//--------------------------------------------------//
+TRid CHE_Simplify::simplify_heap( TRid nt )
+//--------------------------------------------------//
+/** Collapses the cheapest edge first.*/
+{
+  const HEid nh = 3*_m.ntrig();
+  _stamp.assign( _m.nvert(), 0 );
+
+  // initial costs, in parallel
+  vector<double> cost( nh, DBL_MAX );
+  #pragma omp parallel for schedule(dynamic,4096)
+  for(HEid h=0; h<nh; ++h)
+  {
+    if( !_m.he_valid(h) || canonical(h) != h ) continue;
+    double p[3];
+    cost[h] = edge_cost( h, p );
+  }
+
+  vector<Qem_edge> heap;
+  for(HEid h=0; h<nh; ++h)
+  {
+    if( cost[h] == DBL_MAX ) continue;
+    Qem_edge e = { cost[h], h, _m.V(h), _m.V( _m.next(h) ), 0, 0 };
+    heap.push_back( e );
+  }
+  vector<double>().swap( cost );
+  make_heap( heap.begin(), heap.end() );
+
+  vector<TRid> ts;
+  Star_collector<TRid> f( ts );
+  while( nt > _target && !heap.empty() )
+  {
+    pop_heap( heap.begin(), heap.end() );
+    const Qem_edge e = heap.back();
+    heap.pop_back();
+
+    // obsolete edge
+    const HEid h = e.h;
+    if( !_m.he_valid(h) || _m.V(h) != e.a || _m.V( _m.next(h) ) != e.b ) continue;
+    if( _stamp[e.a] != e.sa || _stamp[e.b] != e.sb ) continue;
+
+    double p[3];
+    edge_cost( h, p );
+    if( !_m.can_collapse(h) || flips( h, p ) ) continue;
+    nt -= collapse( h, p );
+
+    // the edges of the remaining vertex are pushed again
+    const Vid b = e.b;
+    ++_stamp[b];
+    ts.clear();
+    _m.visit_R_02( b, f );
+    for(size_t i=0; i<ts.size(); ++i)
+      for(int j=0; j<3; ++j)
+      {
+        const HEid g = 3*ts[i]+j;
+        if( canonical(g) != g ) continue;
+        const Vid u = _m.V(g), w = _m.V( _m.next(g) );
+        if( u != b && w != b ) continue;
+        const double c = edge_cost( g, p );
+        if( c == DBL_MAX ) continue;
+        Qem_edge n = { c, g, u, w, _stamp[u], _stamp[w] };
+        heap.push_back( n );
+        push_heap( heap.begin(), heap.end() );
+      }
+  }
+  return nt;
+}
+//--------------------------------------------------//
+TRid CHE_Simplify::simplify_rounds( TRid nt )
+//--------------------------------------------------//
+/** Collapses, round after round, the edges that are the cheapest of
+  * the two-rings of their vertices. After the first round, only the
+  * neighbourhoods of the collapses are evaluated again.*/
+{
+  const Vid  nv  = _m.nvert();
+  const HEid nh  = 3*_m.ntrig();
+  const int  nth = par_nthreads();
+
+  vector<double> cost( nh, DBL_MAX );
+  vector<HEid>   m1( nv, -1 ), m2( nv, -1 ), m3( nv, -1 );
+  vector<int>    lvl( nv, 4 );
+  vector<Vid>    ring[4];
+  vector<HEid>   sel, rej;
+  vector< vector<HEid> > part( nth ), bad( nth );
+
+  // ring[k]: vertices at distance at most k of a moved vertex (lvl),
+  // every vertex for the first round
+  for(Vid v=0; v<nv; ++v) if( _m.v_valid(v) ) { lvl[v] = 0; ring[0].push_back( v ); }
+  ring[1] = ring[2] = ring[3] = ring[0];
+
+  while( nt > _target )
+  {
+    // a team can be smaller than nth: the lists of the missing threads
+    // must not keep the edges of the previous round
+    for(int t=0; t<nth; ++t) { part[t].clear(); bad[t].clear(); }
+
+    #pragma omp parallel num_threads(nth)
+    {
+      vector<TRid> ts;
+      Star_collector<TRid> f( ts );
+
+      // costs of the edges of the moved vertices: each half-edge is
+      // evaluated by one of its vertices only
+      #pragma omp for schedule(dynamic,256)
+      for(int i=0; i<(int)ring[0].size(); ++i)
+      {
+        const Vid v = ring[0][i];
+        if( !_m.v_valid(v) ) continue;
+        ts.clear();
+        _m.visit_R_02( v, f );
+        for(size_t k=0; k<ts.size(); ++k)
+          for(int j=0; j<3; ++j)
+          {
+            const HEid h = 3*ts[k]+j;
+            const Vid  a = _m.V(h), b = _m.V( _m.next(h) );
+            if( a != v && b != v ) continue;
+            if( a != v && lvl[a] == 0 ) continue;
+            double p[3];
+            cost[h] = ( canonical(h) == h ) ? edge_cost( h, p ) : DBL_MAX;
+          }
+      }
+
+      // cheapest edge of each vertex
+      #pragma omp for schedule(dynamic,256)
+      for(int i=0; i<(int)ring[1].size(); ++i)
+      {
+        const Vid v = ring[1][i];
+        m1[v] = -1;
+        if( !_m.v_valid(v) ) continue;
+        ts.clear();
+        _m.visit_R_02( v, f );
+        for(size_t k=0; k<ts.size(); ++k)
+          for(int j=0; j<3; ++j)
+          {
+            const HEid h = 3*ts[k]+j;
+            if( cost[h] == DBL_MAX ) continue;
+            if( _m.V(h) != v && _m.V( _m.next(h) ) != v ) continue;
+            if( qem_less( h, m1[v], &cost[0] ) ) m1[v] = h;
+          }
+      }
+
+      // cheapest edge of the one-ring, then of the two-ring
+      #pragma omp for schedule(dynamic,256)
+      for(int i=0; i<(int)ring[2].size(); ++i)
+      {
+        const Vid v = ring[2][i];
+        Qem_min g( &m1[0], &cost[0], m1[v] );
+        if( _m.v_valid(v) ) _m.visit_R_00( v, g );
+        m2[v] = g.best;
+      }
+      #pragma omp for schedule(dynamic,256)
+      for(int i=0; i<(int)ring[3].size(); ++i)
+      {
+        const Vid v = ring[3][i];
+        Qem_min g( &m2[0], &cost[0], m2[v] );
+        if( _m.v_valid(v) ) _m.visit_R_00( v, g );
+        m3[v] = g.best;
+      }
+
+      // the edges that are the cheapest of the two-rings of both their
+      // vertices are at least three edges apart: their link condition
+      // and triangle flips are checked now
+      const int t = par_thread();
+      #pragma omp for schedule(dynamic,256)
+      for(int i=0; i<(int)ring[3].size(); ++i)
+      {
+        const Vid v = ring[3][i];
+        if( !_m.v_valid(v) || m3[v] < 0 ) continue;
+        const HEid h = m3[v];
+        const Vid  a = _m.V(h), b = _m.V( _m.next(h) );
+        if( v != a && ( v != b || lvl[a] <= 3 ) ) continue;
+        if( m3[a] != h || m3[b] != h ) continue;
+
+        double p[3];
+        edge_cost( h, p );
+        if( _m.can_collapse(h) && !flips( h, p ) ) part[t].push_back( h );
+        else bad[t].push_back( h );
+      }
+    }
+
+    for(int k=0; k<4; ++k)
+    {
+      for(size_t i=0; i<ring[k].size(); ++i) lvl[ ring[k][i] ] = 4;
+      ring[k].clear();
+    }
+
+    sel.clear();
+    rej.clear();
+    for(int t=0; t<nth; ++t)
+    {
+      sel.insert( sel.end(), part[t].begin(), part[t].end() );
+      rej.insert( rej.end(), bad [t].begin(), bad [t].end() );
+    }
+    if( sel.empty() && rej.empty() ) break;
+    sort( sel.begin(), sel.end(), Qem_order( &cost[0] ) );
+
+    // the collapses of a round touch disjoint stars: they are applied
+    // in one sweep, since they share the free lists of the mesh
+    Qem_grow g0( lvl, ring[0], 0 );
+    for(size_t i=0; i<sel.size() && nt > _target; ++i)
+    {
+      const HEid h = sel[i];
+      const Vid  b = _m.V( _m.next(h) );
+      double p[3];
+      edge_cost( h, p );
+      const int r = collapse( h, p );
+      if( r == 0 ) { rej.push_back( h ); continue; }
+      nt -= r;
+      g0( b );
+      _m.visit_R_00( b, g0 );
+    }
+
+    // the rejected edges are left out until their neighbourhood changes:
+    // the smallest edges of their vertices are searched again
+    ring[1] = ring[0];
+    Qem_grow g1( lvl, ring[1], 1 );
+    for(size_t i=0; i<rej.size(); ++i)
+    {
+      const HEid h = rej[i];
+      cost[h] = DBL_MAX;
+      g1( _m.V(h) );
+      g1( _m.V( _m.next(h) ) );
+    }
+
+    // neighbourhoods of the moved vertices
+    for(int k=1; k<4; ++k)
+    {
+      if( k > 1 ) ring[k] = ring[k-1];
+      Qem_grow g( lvl, ring[k], k );
+      for(size_t i=0; i<ring[k-1].size(); ++i)
+        if( lvl[ ring[k-1][i] ] == k-1 ) _m.visit_R_00( ring[k-1][i], g );
+    }
+  }
+  return nt;
+}
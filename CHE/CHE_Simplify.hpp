@@ -0,0 +1,178 @@
+/**
+* @file    CHE_Simplify.hpp
+*
+* @brief  (Quadric error simplification of the Compact Half-Edge Structure - Level 2)
+*
+* CHE_Simplify decimates a CHE_L2 in place by edge collapses (Garland
+* and Heckbert, "Surface simplification using quadric error metrics",
+* 1997):
+*
+* - each vertex carries the quadric of the planes of its triangles,
+*   weighted by their areas, and of planes orthogonal to its boundary
+*   edges, so that the boundary is kept;
+* - the cost of an edge is the error of the sum of the quadrics of its
+*   vertices at the point that minimizes it (or at the best of its
+*   vertices and midpoint if the quadric is singular);
+* - an edge is collapsed by CHE_L2::collapse_edge, which checks the link
+*   condition on the one-rings R_00 of its vertices and updates _O and
+*   _VH (and _EH and the boundary curves, if built) incrementally; the
+*   remaining vertex is moved to the optimal point. The collapses that
+*   would flip a triangle are rejected.
+*
+* The edges of the non-manifold vertices, whose star is split in several
+* fans, are kept.
+*
+* The edges are taken in the order of their costs from a heap, or by
+* rounds: in each round the costs are updated and the edges that have
+* the smallest cost in the two-ring of their vertices are selected and
+* checked in parallel. These edges are far enough apart for their
+* collapses not to interfere; the collapses are then applied in one
+* serial sweep, since they share the free lists of the mesh.
+*
+* The simplification stops when the mesh reaches the target number of
+* triangles or when the next collapse costs more than the maximal error.
+* The removed vertices and triangles are left as tombstones in the
+* tables: CHE_L0::compact squeezes them out.
+*/
+//--------------------------------------------------//
+
+#ifndef _CHE_SIMPLIFY_HPP_
+#define _CHE_SIMPLIFY_HPP_
+
+#include <cmath>
+#include <cfloat>
+#include "CHE_L2.hpp"
+
+//--------------------------------------------------//
+/** Quadric
+  * \brief Symmetric 4x4 matrix of a sum of squared plane distances*/
+struct Quadric
+//--------------------------------------------------//
+{
+  /** \brief Upper triangle of the matrix*/
+  double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+  /** \brief Null quadric*/
+  Quadric() : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0) {}
+  /** \brief Quadric of the plane ax+by+cz+d = 0, with weight w
+    * \param a, b, c, d - const double  unit normal and offset
+    * \param w - const double */
+  Quadric( const double a, const double b, const double c, const double d, const double w ) :
+    a2(w*a*a), ab(w*a*b), ac(w*a*c), ad(w*a*d), b2(w*b*b), bc(w*b*c), bd(w*b*d), c2(w*c*c), cd(w*c*d), d2(w*d*d) {}
+
+  /** \brief Sum of two quadrics
+    * \param q - const Quadric& */
+  inline Quadric &operator += ( const Quadric &q )
+  {
+    a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+    bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+    return *this;
+  }
+
+  /** \brief Error of a point
+    * \param x, y, z - const double */
+  inline double eval( const double x, const double y, const double z ) const
+  {
+    return a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x + b2*y*y + 2*bc*y*z + 2*bd*y + c2*z*z + 2*cd*z + d2;
+  }
+
+  /** \brief Point of minimal error. Returns false if the matrix is singular.
+    * \param p - double*  3 coordinates*/
+  inline bool optimum( double *p ) const
+  {
+    const double m0 = b2*c2 - bc*bc, m1 = ac*bc - ab*c2, m2 = ab*bc - ac*b2;
+    const double det = a2*m0 + ab*m1 + ac*m2;
+    const double s   = fabs(a2) + fabs(b2) + fabs(c2);
+    if( !( fabs(det) > 1e-9 * s*s*s ) ) return false;
+
+    p[0] = -( m0*ad + m1*bd + m2*cd ) / det;
+    p[1] = -( m1*ad + ( a2*c2 - ac*ac )*bd + ( ab*ac - a2*bc )*cd ) / det;
+    p[2] = -( m2*ad + ( ab*ac - a2*bc )*bd + ( a2*b2 - ab*ab )*cd ) / det;
+    return true;
+  }
+};
+
+//--------------------------------------------------//
+/** CHE_Simplify class
+  * \brief Quadric error edge collapse simplification of a CHE_L2*/
+class CHE_Simplify
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Simplified mesh*/
+  CHE_L2         &_m;
+  /** \brief Number of triangles to reach*/
+  TRid            _target;
+  /** \brief Maximal quadric error of a collapse*/
+  double          _error;
+  /** \brief Weight of the boundary planes*/
+  double          _bweight;
+  /** \brief Collapses by rounds of independent edges*/
+  bool            _rounds;
+  /** \brief Quadric of each vertex*/
+  vector<Quadric> _Q;
+  /** \brief Version of each vertex, increased when it moves (heap mode)*/
+  vector<int>     _stamp;
+  /** \brief Non-manifold vertices, whose star is not reached from their
+    * half-edge: their edges are not collapsed*/
+  vector<char>    _pinched;
+
+public:
+  /** \brief Constructor: the whole simplification is done by simplify()
+    * \param m - CHE_L2&  mesh, simplified in place*/
+  CHE_Simplify( CHE_L2 &m ) : _m(m), _target(0), _error(DBL_MAX), _bweight(1.0), _rounds(false) {}
+
+public:
+  /** \brief Sets the number of triangles to reach
+    * \param nt - const TRid */
+  inline void set_target( const TRid nt ) { _target = nt; }
+  /** \brief Sets the maximal quadric error (a squared distance) of a collapse
+    * \param e - const double */
+  inline void set_max_error( const double e ) { _error = e; }
+  /** \brief Sets the weight of the planes that keep the boundary,
+    * relative to the triangle planes
+    * \param w - const double */
+  inline void set_boundary_weight( const double w ) { _bweight = w; }
+  /** \brief Collapses independent edges by rounds instead of taking
+    * them one by one from a heap: the selection of a round runs in
+    * parallel, its collapses in one serial sweep
+    * \param r - const bool */
+  inline void set_rounds( const bool r ) { _rounds = r; }
+
+  /** \brief Simplifies the mesh and returns its number of valid triangles*/
+  TRid simplify();
+
+protected:
+  /** \brief Computes the quadric of each vertex*/
+  void compute_quadrics();
+  /** \brief Cost of the collapse of an edge and position of the remaining
+    * vertex. The cost is DBL_MAX if it is above the maximal error or if
+    * a vertex of the edge is non-manifold.
+    * \param h - const HEid  V(h) is removed
+    * \param p - double*  3 coordinates*/
+  double edge_cost( const HEid h, double *p ) const;
+  /** \brief Tests if moving the vertices of an edge to p flips a
+    * triangle of their stars
+    * \param h - const HEid
+    * \param p - const double* */
+  bool   flips( const HEid h, const double *p ) const;
+  /** \brief Collapses an edge, moves the remaining vertex to p and
+    * returns the number of removed triangles
+    * \param h - const HEid
+    * \param p - const double* */
+  int    collapse( const HEid h, const double *p );
+  /** \brief Canonical half-edge of the edge of h (see CHE_L2::e_canonical)
+    * \param h - const HEid */
+  inline HEid canonical( const HEid h ) const { const HEid o = _m.O(h); return ( o < 0 || h < o ) ? h : o; }
+
+  /** \brief Simplification with a heap of edges
+    * \param nt - TRid  number of valid triangles*/
+  TRid   simplify_heap( TRid nt );
+  /** \brief Simplification by rounds of independent edges, selected
+    * in parallel and collapsed serially
+    * \param nt - TRid  number of valid triangles*/
+  TRid   simplify_rounds( TRid nt );
+};
+
+#endif
+//--------------------------------------------------//
@@ -0,0 +1,581 @@
+/**
+* @file    CHE_Stream.cpp
+*
+* @brief  (Out of core construction of the Compact Half-Edge Structure - Level 1)
+*/
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "CHE_Stream.hpp"
+#include "../common/Ply_mmap.hpp"
+#include "../common/Snapshot.hpp"
+
+using namespace std;
+
+/** \brief Minimal number of keys in the buffer of a run during a merge*/
+#define RUN_BUFFER 4096
+
+/** \brief Orientation marks of a triangle*/
+#define MARK_VISITED 1
+#define MARK_PENDING 2
+
+//--------------------------------------------------//
+/** Key (min,max) of an edge, with its half-edge*/
+struct Edge_key
+//--------------------------------------------------//
+{
+  Vid  a, b;
+  HEid h;
+  inline bool operator < ( const Edge_key &k ) const
+  { return a < k.a || ( a == k.a && ( b < k.b || ( b == k.b && h < k.h ) ) ); }
+};
+//--------------------------------------------------//
+/** Sequential reader of a run file, through a buffer*/
+struct Run_reader
+//--------------------------------------------------//
+{
+  FILE            *fp;
+  vector<Edge_key> buf;
+  size_t           pos, n;
+
+  Run_reader() : fp(NULL), pos(0), n(0) {}
+  ~Run_reader() { if( fp ) fclose( fp ); }
+
+  bool open( const char *file, const size_t cap )
+  {
+    fp = fopen( file, "rb" );
+    buf.resize( cap );
+    return fp != NULL;
+  }
+  inline bool next( Edge_key &k )
+  {
+    if( pos == n )
+    {
+      n = fread( &buf[0], sizeof(Edge_key), buf.size(), fp );
+      pos = 0;
+      if( n == 0 ) return false;
+    }
+    k = buf[pos++];
+    return true;
+  }
+};
+//--------------------------------------------------//
+/** Sequential writer of a run file, through a buffer*/
+struct Run_writer
+//--------------------------------------------------//
+{
+  FILE            *fp;
+  vector<Edge_key> buf;
+  bool             ok;
+
+  Run_writer() : fp(NULL), ok(false) {}
+  ~Run_writer() { close(); }
+
+  bool open( const char *file, const size_t cap )
+  {
+    fp = fopen( file, "wb" );
+    buf.reserve( cap );
+    ok = fp != NULL;
+    return ok;
+  }
+  void flush()
+  {
+    if( !buf.empty() ) ok = ok && fwrite( &buf[0], sizeof(Edge_key), buf.size(), fp ) == buf.size();
+    buf.clear();
+  }
+  inline void operator()( const Edge_key &k )
+  {
+    buf.push_back( k );
+    if( buf.size() == buf.capacity() ) flush();
+  }
+  bool close()
+  {
+    if( fp == NULL ) return ok;
+    flush();
+    ok = ( fclose( fp ) == 0 ) && ok;
+    fp = NULL;
+    return ok;
+  }
+};
+//--------------------------------------------------//
+/** Pairs consecutive half-edges of the sorted sequence with the same
+  * key, as CHE_L1::compute_opposites_radix*/
+struct Match_sink
+//--------------------------------------------------//
+{
+  HEid    *O;
+  Edge_key prev;
+  bool     open;
+
+  Match_sink( HEid *o ) : O(o), open(false) {}
+  inline void operator()( const Edge_key &k )
+  {
+    if( open && prev.a == k.a && prev.b == k.b )
+    {
+      O[prev.h] = k.h;
+      O[k.h]    = prev.h;
+      open = false;
+      return;
+    }
+    prev = k;
+    open = true;
+  }
+};
+//--------------------------------------------------//
+/** Element of the merge heap*/
+struct Merge_item
+//--------------------------------------------------//
+{
+  Edge_key k;
+  int      r;
+  /** \brief Reversed order: the heap gives the smallest key*/
+  inline bool operator < ( const Merge_item &m ) const { return m.k < k; }
+};
+//--------------------------------------------------//
+/** Name of the i-th run file*/
+static string run_name( const string &tmp, const int i )
+//--------------------------------------------------//
+{
+  char s[32];
+  sprintf( s, ".run%d", i );
+  return tmp + s;
+}
+//--------------------------------------------------//
+/** Writes a sorted batch of keys in a run file*/
+static bool write_run( const string &file, const vector<Edge_key> &keys )
+//--------------------------------------------------//
+{
+  FILE *fp = fopen( file.c_str(), "wb" );
+  if( fp == NULL ) return false;
+  bool ok = keys.empty() || fwrite( &keys[0], sizeof(Edge_key), keys.size(), fp ) == keys.size();
+  ok = ( fclose( fp ) == 0 ) && ok;
+  return ok;
+}
+//--------------------------------------------------//
+/** Merges sorted run files, calling sink on each key in order*/
+template <class Sink> static bool merge_runs( const vector<string> &runs, const size_t cap, Sink &sink )
+//--------------------------------------------------//
+{
+  const int nr = (int)runs.size();
+  const size_t bs = ( cap / nr > RUN_BUFFER ) ? cap / nr : RUN_BUFFER;
+
+  vector<Run_reader> in( nr );
+  vector<Merge_item> heap;
+  heap.reserve( nr );
+  for( int r=0; r<nr; ++r )
+  {
+    if( !in[r].open( runs[r].c_str(), bs ) ) return false;
+    Merge_item m;
+    m.r = r;
+    if( in[r].next( m.k ) ) heap.push_back( m );
+  }
+  make_heap( heap.begin(), heap.end() );
+
+  while( !heap.empty() )
+  {
+    pop_heap( heap.begin(), heap.end() );
+    Merge_item &m = heap.back();
+    sink( m.k );
+    if( in[m.r].next( m.k ) ) push_heap( heap.begin(), heap.end() );
+    else                      heap.pop_back();
+  }
+  return true;
+}
+//--------------------------------------------------//
+/** Removes temporary files*/
+static void remove_files( const vector<string> &files )
+//--------------------------------------------------//
+{
+  for( size_t i=0; i<files.size(); ++i ) remove( files[i].c_str() );
+}
+//--------------------------------------------------//
+/** Stores the vertices parsed from an ascii PLY file in the mapped geometry table*/
+struct Stream_to_G
+//--------------------------------------------------//
+{
+  Vertex *G;
+  Stream_to_G( Vertex *g ) : G(g) {}
+  inline void operator()( const int v, const double x, const double y, const double z ) const { G[v] = Vertex( x, y, z ); }
+};
+//--------------------------------------------------//
+/** Root of x, with path halving. The parent of a vertex is smaller than the vertex.*/
+static inline Cid stream_find( Cid *C, Cid x )
+//--------------------------------------------------//
+{
+  while( C[x] != x ) { C[x] = C[ C[x] ]; x = C[x]; }
+  return x;
+}
+//--------------------------------------------------//
+/** Merges the sets of a and b, the smallest root becomes the parent*/
+static inline void stream_union( Cid *C, Cid a, Cid b )
+//--------------------------------------------------//
+{
+  a = stream_find( C, a );
+  b = stream_find( C, b );
+  if( a == b ) return;
+  if( a < b ) C[b] = a;
+  else        C[a] = b;
+}
+//--------------------------------------------------//
+bool CHE_Stream::build( const char *file, const char *snap )
+//--------------------------------------------------//
+/** Builds the level 1 snapshot of a PLY file out of core.*/
+{
+  printf("Pet_CHE::build_stream(%s)...", file) ;
+
+  Ply_mmap ply;
+  if( !ply.open( file ) ) { printf(" not a binary little endian or ascii ply file.\n" ); return false; }
+
+  const Vid  nv = ply.nvert();
+  const TRid nt = ply.nface();
+  printf(" %d vertices and %d triangles found\n", nv, nt ) ;
+
+  const string tmp = _tmp.empty() ? string( snap ) : _tmp;
+
+  // same tables as CHE_L1::write_snapshot, filled in place
+  Snapshot_builder w;
+  w.add( "G", NULL, sizeof(Vertex), nv );
+  w.add_value( "NV", nv );
+  w.add_value( "NT", nt );
+  w.add( "V", NULL, sizeof(Vid), 3*(size_t)nt );
+  w.add_value( "NC", (Cid)0 );
+  w.add( "O", NULL, sizeof(HEid), 3*(size_t)nt );
+  w.add( "C", NULL, sizeof(Cid), nv );
+  if( !w.create( snap, "CHE", 1 ) ) { printf("Pet_CHE::build_stream... cannot create %s.\n", snap ); return false; }
+
+  Vertex *G = (Vertex*) w.table( "G" );
+  Vid    *V = (Vid   *) w.table( "V" );
+  HEid   *O = (HEid  *) w.table( "O" );
+  Cid    *C = (Cid   *) w.table( "C" );
+
+  bool ok = read_mesh( ply, G, V );
+  ply.close();
+
+  ok = ok && compute_opposites( V, O, nv, nt, tmp );
+  ok = ok && orient( V, O, nt, tmp );
+  if( ok )
+  {
+    *(Cid*) w.table( "NC" ) = compute_connected( V, C, nv, nt );
+    compute_normals( V, G, nv, nt );
+  }
+
+  ok = w.close() && ok;
+  if( !ok ) { remove( snap ); printf("Pet_CHE::build_stream... failed.\n" ); return false; }
+
+  printf("Pet_CHE::build_stream... level 1 written in %s\n", snap ) ;
+  return true;
+}
+//--------------------------------------------------//
+bool CHE_Stream::read_mesh( const Ply_mmap &ply, Vertex *G, Vid *V )
+//--------------------------------------------------//
+/** Converts the PLY file into the mapped tables.*/
+{
+  const Vid  nv = ply.nvert();
+  const TRid nt = ply.nface();
+
+  if( ply.ascii() )
+  {
+    if( !ply.read_ascii( Stream_to_G( G ), V, 3 ) ) return false;
+  }
+  else
+  {
+    if( nt > 0 && !ply.read_faces( V, 3 ) ) return false;
+
+    // by blocks of vertices, through a small interleaved buffer
+    const int bs = 1024;
+    const int nb = ( nv + bs-1 ) / bs;
+    #pragma omp parallel for schedule(static)
+    for( int b=0; b<nb; ++b )
+    {
+      Vertex::real_type xyz[3*bs];
+      const Vid v0 = b*bs, v1 = ( v0+bs < nv ) ? v0+bs : nv;
+      ply.read_positions( v0, v1, xyz );
+      for( Vid v=v0; v<v1; ++v )
+        G[v] = Vertex( xyz[3*(v-v0)], xyz[3*(v-v0)+1], xyz[3*(v-v0)+2] );
+    }
+  }
+
+  if( nv == 0 ) return true;
+
+  // bounding box and normalization of CHE_L0::bounding_box and CHE_L0::legalize_model
+  float min[3], max[3];
+  min[0] = max[0] = (float)G[0].x();
+  min[1] = max[1] = (float)G[0].y();
+  min[2] = max[2] = (float)G[0].z();
+  for( Vid v=1; v<nv; ++v )
+  {
+    if( G[v].x() < min[0] ) min[0] = (float)G[v].x();
+    if( G[v].x() > max[0] ) max[0] = (float)G[v].x();
+    if( G[v].y() < min[1] ) min[1] = (float)G[v].y();
+    if( G[v].y() > max[1] ) max[1] = (float)G[v].y();
+    if( G[v].z() < min[2] ) min[2] = (float)G[v].z();
+    if( G[v].z() > max[2] ) max[2] = (float)G[v].z();
+  }
+
+  float c[3], size = 0;
+  for( int i=0; i<3; ++i )
+  {
+    c[i] = (float)(max[i]+min[i])/2;
+    float l = fabs(max[i]-min[i]);
+    if( l > size ) size = l;
+  }
+  size /= 1.5;
+
+  #pragma omp parallel for schedule(static)
+  for( Vid v=0; v<nv; ++v )
+  {
+    float p[3] = { (float)G[v].x(), (float)G[v].y(), (float)G[v].z() };
+    for( int i=0; i<3; ++i )
+    {
+      p[i] -= c[i];
+      if( size != 0 ) p[i] /= size;
+    }
+    G[v].set_x( p[0] );
+    G[v].set_y( p[1] );
+    G[v].set_z( p[2] );
+  }
+  return true;
+}
+//--------------------------------------------------//
+bool CHE_Stream::compute_opposites( const Vid *V, HEid *O, const Vid nv, const TRid nt, const string &tmp )
+//--------------------------------------------------//
+/** Computes the opposites by an external merge sort of the edge keys.*/
+{
+  cout << "Pet_CHE::compute_opposites...  " ;
+
+  const HEid   nhe = 3*nt;
+  const size_t cap = ( _mem / sizeof(Edge_key) > RUN_BUFFER ) ? _mem / sizeof(Edge_key) : RUN_BUFFER;
+
+  #pragma omp parallel for schedule(static)
+  for( HEid c=0; c<nhe; ++c ) O[c] = -1;
+
+  // sorted runs of at most cap keys
+  vector<Edge_key> buf;
+  buf.reserve( (size_t)nhe < cap ? (size_t)nhe : cap );
+  vector<string> runs;
+  for( HEid c=0; c<nhe; ++c )
+  {
+    Vid a = V[c], b = V[3*(c/3) + (c+1)%3];
+    if( a < 0 || b < 0 || a >= nv || b >= nv ) continue;
+
+    Edge_key k;
+    k.a = a < b ? a : b;
+    k.b = a < b ? b : a;
+    k.h = c;
+    buf.push_back( k );
+    if( buf.size() < cap ) continue;
+
+    sort( buf.begin(), buf.end() );
+    runs.push_back( run_name( tmp, (int)runs.size() ) );
+    if( !write_run( runs.back(), buf ) )
+    { remove_files( runs ); cout << " cannot write " << runs.back() << endl; return false; }
+    buf.clear();
+  }
+  sort( buf.begin(), buf.end() );
+
+  Match_sink match( O );
+  if( runs.empty() )
+  {
+    // a single batch: no run file
+    for( size_t i=0; i<buf.size(); ++i ) match( buf[i] );
+    cout << " done." << endl;
+    return true;
+  }
+  if( !buf.empty() )
+  {
+    runs.push_back( run_name( tmp, (int)runs.size() ) );
+    if( !write_run( runs.back(), buf ) )
+    { remove_files( runs ); cout << " cannot write " << runs.back() << endl; return false; }
+  }
+  vector<Edge_key>().swap( buf );
+
+  // merges groups of runs until they can be merged at once
+  const size_t fan = ( cap / RUN_BUFFER > 2 ) ? cap / RUN_BUFFER : 2;
+  int id = (int)runs.size();
+  while( runs.size() > fan )
+  {
+    vector<string> next;
+    for( size_t i=0; i<runs.size(); i+=fan )
+    {
+      vector<string> group( runs.begin()+i, runs.begin() + ( i+fan < runs.size() ? i+fan : runs.size() ) );
+      if( group.size() == 1 ) { next.push_back( group[0] ); continue; }
+
+      next.push_back( run_name( tmp, id++ ) );
+      Run_writer out;
+      bool ok = out.open( next.back().c_str(), cap/2 ) && merge_runs( group, cap/2, out );
+      ok = out.close() && ok;
+      if( !ok )
+      {
+        remove_files( next );
+        remove_files( vector<string>( runs.begin()+i, runs.end() ) );
+        cout << " cannot write " << next.back() << endl;
+        return false;
+      }
+      remove_files( group );
+    }
+    runs.swap( next );
+  }
+
+  const bool ok = merge_runs( runs, cap, match );
+  remove_files( runs );
+  if( !ok ) { cout << " cannot read the runs." << endl; return false; }
+
+  cout << " done." << endl;
+  return true;
+}
+//--------------------------------------------------//
+bool CHE_Stream::orient( Vid *V, HEid *O, const TRid nt, const string &tmp )
+//--------------------------------------------------//
+/** Orients each compound as its first triangle, with a bounded stack.*/
+{
+  if( nt == 0 ) return true;
+
+  cout << "Pet_CHE::orient... " ;
+
+  // a mark per triangle, in a mapped file
+  const string name = tmp + ".mark";
+  Mapped_file marks;
+  if( !marks.create( name.c_str(), (size_t)nt ) ) { cout << " cannot create " << name << endl; return false; }
+  unsigned char *m = (unsigned char*) marks.wdata();
+
+  // when the stack is full, the triangle is marked as pending and its
+  // half-edges are pushed later, by a scan of the marks
+  const size_t cap = ( _mem / sizeof(HEid) > 1024 ) ? _mem / sizeof(HEid) : 1024;
+  vector<HEid> s;
+  s.reserve( cap );
+
+  s.push_back( 0 ); s.push_back( 1 ); s.push_back( 2 );
+  m[0] = MARK_VISITED;
+
+  TRid nflip = 0, r = 0;
+  bool pending = false;
+  for(;;)
+  {
+    while( !s.empty() )
+    {
+      HEid h = s.back();
+      s.pop_back();
+
+      /** Avoid null edges*/
+      HEid o = O[h];
+      if( o < 0 ) continue;
+
+      /** Avoid Loops*/
+      TRid t = o/3;
+      if( m[t] & MARK_VISITED ) continue;
+
+      /** Repairs orientation, as CHE_L1::orient_change*/
+      if( V[h] != V[3*(o/3) + (o+1)%3] || V[3*(h/3) + (h+1)%3] != V[o] )
+      {
+        HEid h1 = 3*t, h2 = 3*t+1, h3 = 3*t+2;
+        Vid v = V[h1];  V[h1] = V[h2];  V[h2] = v;
+
+        HEid o2 = O[h2], o3 = O[h3];
+        O[h2] = o3;  O[h3] = o2;
+        if( o2 >= 0 ) O[o2] = h3;
+        if( o3 >= 0 ) O[o3] = h2;
+        ++nflip;
+      }
+
+      /** Marks as visited*/
+      m[t] |= MARK_VISITED;
+
+      /** Push half-edges of t*/
+      if( s.size() + 3 > cap ) { m[t] |= MARK_PENDING; pending = true; continue; }
+      s.push_back( 3*t ); s.push_back( 3*t+1 ); s.push_back( 3*t+2 );
+    }
+    if( !pending )
+    {
+      /** Next compound, from its first triangle*/
+      while( r < nt && ( m[r] & MARK_VISITED ) ) ++r;
+      if( r == nt ) break;
+
+      m[r] |= MARK_VISITED;
+      s.push_back( 3*r ); s.push_back( 3*r+1 ); s.push_back( 3*r+2 );
+      continue;
+    }
+
+    pending = false;
+    for( TRid t=0; t<nt; ++t )
+    {
+      if( !( m[t] & MARK_PENDING ) ) continue;
+      if( s.size() + 3 > cap ) { pending = true; break; }
+      m[t] &= ~MARK_PENDING;
+      s.push_back( 3*t ); s.push_back( 3*t+1 ); s.push_back( 3*t+2 );
+    }
+  }
+
+  marks.close();
+  remove( name.c_str() );
+
+  cout << nflip << " triangle(s) flipped." << endl;
+  return true;
+}
+//--------------------------------------------------//
+Cid CHE_Stream::compute_connected( const Vid *V, Cid *C, const Vid nv, const TRid nt )
+//--------------------------------------------------//
+/** Computes the compound of each vertex.*/
+{
+  cout << "Pet_CHE::compute_bounds...  " ;
+
+  for( Vid v=0; v<nv; ++v ) C[v] = v;
+
+  for( TRid t=0; t<nt; ++t )
+  {
+    const Vid a = V[3*t], b = V[3*t+1], c = V[3*t+2];
+    if( a < 0 || b < 0 || c < 0 || a >= nv || b >= nv || c >= nv ) continue;
+    stream_union( C, a, b );
+    stream_union( C, a, c );
+  }
+
+  // the roots are the smallest vertices of the compounds, and the
+  // parents are smaller than their children: numbering the roots in
+  // order gives the ids of CHE_L1::compute_connected
+  Cid n = 0;
+  for( Vid v=0; v<nv; ++v )
+    C[v] = ( C[v] == v ) ? n++ : C[ C[v] ];
+
+  cout << " " << n << " connected compound(s) found." << endl;
+  return n;
+}
+//--------------------------------------------------//
+void CHE_Stream::compute_normals( const Vid *V, Vertex *G, const Vid nv, const TRid nt )
+//--------------------------------------------------//
+/** Sums the triangle normals in the vertex normals and normalizes them.*/
+{
+  if( !VertexSoA::attr ) return;
+
+  cout << "Pet_CHE::compute_normals...  " ;
+
+  for( TRid t=0; t<nt; ++t )
+  {
+    const Vid a = V[3*t], b = V[3*t+1], c = V[3*t+2];
+    if( a < 0 || b < 0 || c < 0 || a >= nv || b >= nv || c >= nv ) continue;
+
+    double n[3];
+    Vertex::normal( G[a], G[b], G[c], n );
+    const Vid w[3] = { a, b, c };
+    for( int j=0; j<3; ++j )
+    {
+      Vertex &g = G[ w[j] ];
+      g.set_nx( g.nx() + n[0] );
+      g.set_ny( g.ny() + n[1] );
+      g.set_nz( g.nz() + n[2] );
+    }
+  }
+
+  #pragma omp parallel for schedule(static)
+  for( Vid v=0; v<nv; ++v )
+  {
+    double n[3] = { G[v].nx(), G[v].ny(), G[v].nz() };
+    Vertex::normalize( n );
+    G[v].set_nx( n[0] );
+    G[v].set_ny( n[1] );
+    G[v].set_nz( n[2] );
+  }
+
+  cout << " done." << endl;
+}
+//--------------------------------------------------//
@@ -0,0 +1,119 @@
+/**
+* @file    CHE_Stream.hpp
+*
+* @brief  (Out of core construction of the Compact Half-Edge Structure - Level 1)
+*
+* CHE_L1::read_ply keeps the whole mesh and the construction tables in
+* memory. CHE_Stream builds the same level 1 tables (_G, _V, _O, _C and
+* the number of compounds) for meshes larger than the memory, and
+* writes them in a snapshot file (see Snapshot.hpp):
+*
+* - the snapshot is created with its final size and mapped, and the
+*   PLY file is converted straight into its _G and _V tables;
+* - the half-edges are cut in batches that fit in the memory budget,
+*   each batch is sorted by edge key and written to a run file, and
+*   the runs are merged (in several passes if needed) to pair the
+*   opposite half-edges in the mapped _O table;
+* - the orientation, the connected compounds and the normals are
+*   computed in place, on the mapped tables.
+*
+* The memory budget bounds the buffers of each step; the mapped tables
+* are backed by the snapshot file. The result is the same as read_ply
+* followed by write_snapshot on a CHE_L1, and is loaded with
+* CHE_L1::read_snapshot, or used in place through a Snapshot_reader.
+*/
+//--------------------------------------------------//
+
+#ifndef _CHE_STREAM_HPP_
+#define _CHE_STREAM_HPP_
+
+#include <string>
+#include "CHE_L1.hpp"
+
+class Ply_mmap;
+
+/** \brief Default memory budget of CHE_Stream, in bytes*/
+#define STREAM_MEMORY (256 << 20)
+
+//--------------------------------------------------//
+/** CHE_Stream class
+  * \brief Out of core construction of a CHE_L1 snapshot*/
+class CHE_Stream
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Memory budget of the construction buffers, in bytes*/
+  size_t _mem;
+  /** \brief Prefix of the temporary files, empty for the snapshot name*/
+  string _tmp;
+
+public:
+  /** \brief Default constructor.
+    * \param mem = STREAM_MEMORY - const size_t  memory budget in bytes*/
+  CHE_Stream( const size_t mem = STREAM_MEMORY ) : _mem(mem) {}
+
+public:
+  /** \brief Memory budget of the construction buffers, in bytes*/
+  inline const size_t memory() const { return _mem; }
+  /** \brief Sets the memory budget of the construction buffers
+    * \param mem - const size_t  bytes*/
+  inline void set_memory( const size_t mem ) { _mem = mem; }
+  /** \brief Sets the prefix of the temporary files (run files and
+    * orientation marks), for example a directory on a local disk.
+    * By default, they are created next to the snapshot.
+    * \param tmp - const char* */
+  inline void set_tmp( const char *tmp ) { _tmp = tmp ? tmp : ""; }
+
+  /** \brief Reads a binary little endian or ascii PLY file and writes
+    * the level 1 snapshot of the mesh. Returns false if the file cannot
+    * be read by the memory mapped reader or if the snapshot or the
+    * temporary files cannot be written.
+    * \param ply  - const char*  input PLY file
+    * \param snap - const char*  output snapshot*/
+  bool build( const char *ply, const char *snap );
+
+protected:
+  /** \brief Converts the vertices and the triangles of the PLY file
+    * into the mapped tables, and centers and scales the model as
+    * CHE_L0::legalize_model
+    * \param ply - const Ply_mmap&
+    * \param G   - Vertex*
+    * \param V   - Vid* */
+  bool read_mesh( const Ply_mmap &ply, Vertex *G, Vid *V );
+
+  /** \brief Computes the opposite of each half-edge by an external
+    * merge sort of the edge keys
+    * \param V    - const Vid*
+    * \param O    - HEid*
+    * \param nv   - const Vid
+    * \param nt   - const TRid
+    * \param tmp  - const string&  prefix of the run files*/
+  bool compute_opposites( const Vid *V, HEid *O, const Vid nv, const TRid nt, const string &tmp );
+
+  /** \brief Orients each compound as its first triangle, as CHE_L1::orient,
+    * with a stack bounded by the memory budget
+    * \param V   - Vid*
+    * \param O   - HEid*
+    * \param nt  - const TRid
+    * \param tmp - const string&  prefix of the mark file*/
+  bool orient( Vid *V, HEid *O, const TRid nt, const string &tmp );
+
+  /** \brief Computes the compound of each vertex as CHE_L1::compute_connected
+    * and returns the number of compounds
+    * \param V  - const Vid*
+    * \param C  - Cid*
+    * \param nv - const Vid
+    * \param nt - const TRid */
+  Cid  compute_connected( const Vid *V, Cid *C, const Vid nv, const TRid nt );
+
+  /** \brief Computes the vertex normals as CHE_L0::compute_normals,
+    * summing the triangle normals in the normals of the vertices
+    * \param V  - const Vid*
+    * \param G  - Vertex*
+    * \param nv - const Vid
+    * \param nt - const TRid */
+  void compute_normals( const Vid *V, Vertex *G, const Vid nv, const TRid nt );
+};
+
+#endif
+//--------------------------------------------------//
@@ -0,0 +1,311 @@
+/**
+* @file    CHE_Subdivide.cpp
+*
+* @brief  (Loop and sqrt(3) subdivision of the Compact Half-Edge Structure - Level 2)
+*/
+
+#include <cmath>
+
+#include "CHE_Subdivide.hpp"
+#include "CHE_L3.hpp"
+#include "../common/Parallel.hpp"
+
+using namespace std;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//--------------------------------------------------//
+/** Sum of the positions and fields of a one-ring, with its first and
+  * last vertices (the boundary neighbours, from a boundary half-edge)*/
+struct Subdiv_ring
+//--------------------------------------------------//
+{
+  const CHE_L2 &m;
+  double s[4];
+  int    n;
+  Vid    first, last;
+  Subdiv_ring( const CHE_L2 &m_ ) : m(m_), n(0), first(-1), last(-1) { s[0] = s[1] = s[2] = s[3] = 0; }
+  inline void operator()( const Vid w )
+  {
+    s[0] += m.x(w);  s[1] += m.y(w);  s[2] += m.z(w);  s[3] += m.field(w);
+    if( n++ == 0 ) first = w;
+    last = w;
+  }
+};
+//--------------------------------------------------//
+/** Weighted sum of vertices of a mesh, as a vertex without normal*/
+static inline Vertex subdiv_mix( const CHE_L2 &m, const int n, const Vid *v, const double *w )
+//--------------------------------------------------//
+{
+  double p[4] = { 0, 0, 0, 0 };
+  for(int i=0; i<n; ++i)
+  {
+    p[0] += w[i] * m.x( v[i] );  p[1] += w[i] * m.y( v[i] );
+    p[2] += w[i] * m.z( v[i] );  p[3] += w[i] * m.field( v[i] );
+  }
+  return Vertex( p[0], p[1], p[2], 0, 0, 0, p[3] );
+}
+//--------------------------------------------------//
+void CHE_Subdivide::loop( CHE_L2 &m, const int levels )
+//--------------------------------------------------//
+/** Applies the levels of Loop subdivision.*/
+{
+  const bool soa = m.soa();
+  prepare( m );
+  for(int l=0; l<levels; ++l)
+  {
+    cout << "Pet_CHE::loop...  " ;
+    CHE_L2 f;
+    loop_level( m, f );
+    m.CHE_L2::take( f );
+    cout << " " << m.nvert() << " vertices and " << m.ntrig() << " triangles." << endl;
+  }
+  finish( m, soa );
+}
+//--------------------------------------------------//
+void CHE_Subdivide::sqrt3( CHE_L2 &m, const int levels )
+//--------------------------------------------------//
+/** Applies the levels of sqrt(3) subdivision.*/
+{
+  const bool soa = m.soa();
+  prepare( m );
+  for(int l=0; l<levels; ++l)
+  {
+    cout << "Pet_CHE::sqrt3...  " ;
+    CHE_L2 f;
+    sqrt3_level( m, f );
+    m.CHE_L2::take( f );
+    cout << " " << m.nvert() << " vertices and " << m.ntrig() << " triangles." << endl;
+  }
+  finish( m, soa );
+}
+//--------------------------------------------------//
+void CHE_Subdivide::prepare( CHE_L2 &m )
+//--------------------------------------------------//
+/** Compacts the mesh if an element was removed, and computes _VH and _EH.*/
+{
+  int bad = 0;
+  #pragma omp parallel for schedule(static) reduction(+:bad)
+  for(TRid t=0; t<m.ntrig(); ++t) if( !m.tr_valid(t) ) ++bad;
+  #pragma omp parallel for schedule(static) reduction(+:bad)
+  for(Vid v=0; v<m.nvert(); ++v) if( !m.v_valid(v) ) ++bad;
+
+  if( bad )
+  {
+    vector<Vid>  vnew;
+    vector<TRid> tnew;
+    m.compact( vnew, tnew );
+  }
+  if( m.soa() ) m.set_layout( false );
+  m.need_VH();
+  m.need_EH();
+}
+//--------------------------------------------------//
+void CHE_Subdivide::allocate( CHE_L2 &f, const Vid nv, const TRid nt, const Eid ne, const Cid nc )
+//--------------------------------------------------//
+/** Sizes the tables of the refined mesh: all their entries are written by the level.*/
+{
+  f._nvert = nv;
+  f._ntrig = nt;
+  f._ncomp = nc;
+  f._G .resize( nv );
+  f._C .resize( nv );
+  f._VH.resize( nv );
+  f._V .resize( 3*nt );
+  f._O .resize( 3*nt );
+  f._E .resize( 3*nt );
+  f._EH.resize( ne );
+}
+//--------------------------------------------------//
+void CHE_Subdivide::finish( CHE_L2 &m, const bool soa )
+//--------------------------------------------------//
+/** Restores the layout, computes the normals and resets the boundary curves.*/
+{
+  if( soa ) m.set_layout( true );
+  m.compute_normals();
+
+  // the boundary half-edges have new ids: the curves of a level 3
+  // structure are computed again on demand
+  CHE_L3 *l3 = dynamic_cast<CHE_L3*>( &m );
+  if( l3 ) l3->set_ncurves( -1 );
+}
+//--------------------------------------------------//
+void CHE_Subdivide::loop_level( const CHE_L2 &c, CHE_L2 &f )
+//--------------------------------------------------//
+/** Splits each triangle in four and applies the Loop masks.*/
+{
+  const Vid  nv = c.nvert();
+  const TRid nt = c.ntrig();
+  const Eid  ne = c.nedge();
+  allocate( f, nv+ne, 4*nt, 2*ne+3*nt, c.ncomp() );
+
+  // first and second halves of the coarse half-edge h: the first one
+  // is in the corner of V(h), the second one in the corner of V(next(h))
+  #define FIRST( h )  ( 12*((h)/3) + 3*((h)%3) )
+  #define SECOND( h ) ( 12*((h)/3) + 3*(((h)%3+1)%3) + 2 )
+
+  #pragma omp parallel for schedule(static)
+  for(TRid t=0; t<nt; ++t)
+  {
+    for(int k=0; k<3; ++k)
+    {
+      const HEid h = 3*t+k, p = 3*t+(k+2)%3, o = c._O[h];
+      const Eid  e = c._E[h], ep = c._E[p];
+      const HEid H = 12*t+3*k, M = 12*t+9;
+
+      // corner triangle 4t+k: V(h), middle of h, middle of p
+      f._V[H  ] = c._V[h];
+      f._V[H+1] = nv + e;
+      f._V[H+2] = nv + ep;
+      f._O[H  ] = ( o < 0 ) ? -1 : SECOND( o );
+      f._O[H+1] = M + (k+2)%3;
+      f._O[H+2] = ( c._O[p] < 0 ) ? -1 : FIRST( c._O[p] );
+
+      // middle triangle 4t+3
+      f._V[M+k] = nv + e;
+      f._O[M+k] = 12*t + 3*((k+1)%3) + 1;
+
+      // the halves of e are 2e, from V(EH(e)), and 2e+1
+      const bool ch = ( c._EH[e] == h );
+      f._E[H  ] = 2*e + ( ch ? 0 : 1 );
+      f._E[SECOND( h )] = 2*e + ( ch ? 1 : 0 );
+      f._E[H+1] = f._E[M+(k+2)%3] = 2*ne + 3*t + k;
+      f._EH[ 2*ne + 3*t + k ] = H+1;
+      if( ch )
+      {
+        const HEid a = H, b = SECOND( h );
+        f._EH[2*e  ] = ( o < 0 || a < SECOND( o ) ) ? a : SECOND( o );
+        f._EH[2*e+1] = ( o < 0 || b < FIRST ( o ) ) ? b : FIRST ( o );
+
+        // vertex of the edge
+        const Vid u = c._V[h], w = c._V[ c.he_next(h) ];
+        f._C [nv+e] = c._C[u];
+        f._VH[nv+e] = b;
+        if( o < 0 )
+        {
+          const Vid    v[2] = { u, w };
+          const double wt[2] = { 0.5, 0.5 };
+          f._G[nv+e] = subdiv_mix( c, 2, v, wt );
+        }
+        else
+        {
+          const Vid    v[4] = { u, w, c._V[p], c._V[ c.he_prev(o) ] };
+          const double wt[4] = { 0.375, 0.375, 0.125, 0.125 };
+          f._G[nv+e] = subdiv_mix( c, 4, v, wt );
+        }
+      }
+    }
+  }
+  #undef FIRST
+  #undef SECOND
+
+  // coarse vertices
+  #pragma omp parallel for schedule(dynamic,1024)
+  for(Vid v=0; v<nv; ++v)
+  {
+    const HEid h = c._VH[v];
+    f._C [v] = c._C[v];
+    f._VH[v] = ( h < 0 ) ? -1 : 12*(h/3) + 3*(h%3);
+
+    Subdiv_ring r( c );
+    if( h >= 0 ) c.visit_R_00( v, r );
+    if( r.n < 2 ) { f._G[v] = c.G(v); continue; }
+
+    if( c._O[h] < 0 )
+    {
+      // boundary: the two neighbours along the curve
+      const Vid    u[3] = { v, r.first, r.last };
+      const double w[3] = { 0.75, 0.125, 0.125 };
+      f._G[v] = subdiv_mix( c, 3, u, w );
+    }
+    else
+    {
+      const double a = 0.375 + 0.25 * cos( 2*M_PI / r.n );
+      const double b = ( 0.625 - a*a ) / r.n;
+      const double w = 1 - r.n*b;
+      f._G[v] = Vertex( w*c.x(v) + b*r.s[0], w*c.y(v) + b*r.s[1], w*c.z(v) + b*r.s[2], 0, 0, 0, w*c.field(v) + b*r.s[3] );
+    }
+  }
+}
+//--------------------------------------------------//
+void CHE_Subdivide::sqrt3_level( const CHE_L2 &c, CHE_L2 &f )
+//--------------------------------------------------//
+/** Inserts the centers of the triangles and flips the coarse interior edges.*/
+{
+  const Vid  nv = c.nvert();
+  const TRid nt = c.ntrig();
+  const Eid  ne = c.nedge();
+  allocate( f, nv+nt, 3*nt, ne+3*nt, c.ncomp() );
+
+  #pragma omp parallel for schedule(static)
+  for(TRid t=0; t<nt; ++t)
+  {
+    const HEid h0 = 3*t;
+
+    // center of t
+    const Vid    v[3] = { c._V[h0], c._V[h0+1], c._V[h0+2] };
+    const double w[3] = { 1.0/3, 1.0/3, 1.0/3 };
+    f._G [nv+t] = subdiv_mix( c, 3, v, w );
+    f._C [nv+t] = c._C[ v[0] ];
+    f._VH[nv+t] = 3*h0+2;
+
+    for(int k=0; k<3; ++k)
+    {
+      // triangle h: V(h), center of the opposite triangle, center of t;
+      // on the boundary, V(h), V(next(h)), center of t
+      const HEid h = h0+k, n = c.he_next(h), p = c.he_prev(h), o = c._O[h];
+      const Eid  e = c._E[h];
+      const HEid H = 3*h;
+
+      f._V[H  ] = c._V[h];
+      f._V[H+2] = nv + t;
+      if( o >= 0 )
+      {
+        f._V[H+1] = nv + o/3;
+        f._O[H  ] = 3*c.he_next(o) + 2;
+        f._O[H+1] = 3*o + 1;
+        f._E[H  ] = ne + c.he_next(o);
+        f._E[H+1] = e;
+        if( c._EH[e] == h ) f._EH[e] = ( H+1 < 3*o+1 ) ? H+1 : 3*o+1;
+      }
+      else
+      {
+        f._V[H+1] = c._V[n];
+        f._O[H  ] = -1;
+        f._O[H+1] = 3*n + 2;
+        f._E[H  ] = e;
+        f._E[H+1] = ne + n;
+        f._EH[e]  = H;
+      }
+
+      // spoke from the center of t to V(h)
+      const HEid q = c._O[p];
+      const HEid s = ( q >= 0 ) ? 3*q : 3*p + 1;
+      f._O[H+2] = s;
+      f._E[H+2] = ne + h;
+      f._EH[ne+h] = ( H+2 < s ) ? H+2 : s;
+    }
+  }
+
+  // coarse vertices: the boundary ones do not move
+  #pragma omp parallel for schedule(dynamic,1024)
+  for(Vid v=0; v<nv; ++v)
+  {
+    const HEid h = c._VH[v];
+    f._C [v] = c._C[v];
+    f._VH[v] = ( h < 0 ) ? -1 : 3*h;
+    f._G [v] = c.G(v);
+    if( h < 0 || c._O[h] < 0 ) continue;
+
+    Subdiv_ring r( c );
+    c.visit_R_00( v, r );
+    if( r.n < 2 ) continue;
+
+    const double a = ( 4 - 2*cos( 2*M_PI / r.n ) ) / 9;
+    const double b = a / r.n;
+    f._G[v] = Vertex( (1-a)*c.x(v) + b*r.s[0], (1-a)*c.y(v) + b*r.s[1], (1-a)*c.z(v) + b*r.s[2], 0, 0, 0, (1-a)*c.field(v) + b*r.s[3] );
+  }
+}
+//--------------------------------------------------//
@@ -0,0 +1,82 @@
+/**
+* @file    CHE_Subdivide.hpp
+*
+* @brief  (Loop and sqrt(3) subdivision of the Compact Half-Edge Structure - Level 2)
+*
+* The connectivity of a subdivided mesh is a function of the coarse
+* tables: CHE_Subdivide writes the refined _V, _O, _C, _VH, _E and _EH
+* directly from them, triangle by triangle in parallel, without
+* compute_opposites nor any map of the edges.
+*
+* - Loop (C. Loop, "Smooth subdivision surfaces based on triangles",
+*   1987): each triangle t is split in four, the corner triangles 4t+k
+*   and the middle one 4t+3. The vertex of edge e is nv+e, and the
+*   halves of e are the edges 2e and 2e+1. The inner edges of t are
+*   2ne+3t+k.
+* - sqrt(3) (L. Kobbelt, "sqrt(3)-subdivision", 2000): the vertex of
+*   triangle t is nv+t, and each half-edge h of the coarse mesh gives
+*   the triangle h, so that the interior edges are flipped. Edge e
+*   keeps its id, and the edges from the center of t are ne+3t+k.
+*   The boundary edges are not split and their vertices do not move.
+*
+* The positions follow the masks of the schemes (boundary curves for
+* Loop). The mesh must be manifold for the masks: a vertex sees its
+* neighbours through its fan. The removed elements are squeezed out by
+* CHE_L0::compact first. The edge ids do not follow the increasing
+* order of compute_EH.
+*/
+//--------------------------------------------------//
+
+#ifndef _CHE_SUBDIVIDE_HPP_
+#define _CHE_SUBDIVIDE_HPP_
+
+#include "CHE_L2.hpp"
+
+//--------------------------------------------------//
+/** CHE_Subdivide class
+  * \brief Subdivision of a CHE_L2, writing the refined tables directly*/
+class CHE_Subdivide
+//--------------------------------------------------//
+{
+public:
+  /** \brief Refines the mesh in place by Loop subdivision: each
+    * level multiplies the number of triangles by 4
+    * \param m      - CHE_L2&  mesh, replaced by its refinement
+    * \param levels = 1 - const int */
+  static void loop ( CHE_L2 &m, const int levels = 1 );
+  /** \brief Refines the mesh in place by sqrt(3) subdivision: each
+    * level multiplies the number of triangles by 3
+    * \param m      - CHE_L2&  mesh, replaced by its refinement
+    * \param levels = 1 - const int */
+  static void sqrt3( CHE_L2 &m, const int levels = 1 );
+
+protected:
+  /** \brief Squeezes out the removed elements and computes the vertex
+    * and edge tables of the coarse mesh
+    * \param m - CHE_L2& */
+  static void prepare( CHE_L2 &m );
+  /** \brief Allocates the tables of the refined mesh
+    * \param f  - CHE_L2&
+    * \param nv - const Vid
+    * \param nt - const TRid
+    * \param ne - const Eid
+    * \param nc - const Cid  number of compounds*/
+  static void allocate( CHE_L2 &f, const Vid nv, const TRid nt, const Eid ne, const Cid nc );
+  /** \brief Restores the layout of the refined mesh and computes
+    * its normals
+    * \param m   - CHE_L2&
+    * \param soa - const bool  layout of the coarse mesh*/
+  static void finish( CHE_L2 &m, const bool soa );
+
+  /** \brief One level of Loop subdivision
+    * \param c - const CHE_L2&  coarse mesh
+    * \param f - CHE_L2&  refined mesh*/
+  static void loop_level ( const CHE_L2 &c, CHE_L2 &f );
+  /** \brief One level of sqrt(3) subdivision
+    * \param c - const CHE_L2&  coarse mesh
+    * \param f - CHE_L2&  refined mesh*/
+  static void sqrt3_level( const CHE_L2 &c, CHE_L2 &f );
+};
+
+#endif
+//--------------------------------------------------//
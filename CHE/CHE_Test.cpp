@@ -23,6 +23,8 @@
 
 #include "CHE_L3.hpp"
 
+#include "../common/Bvh.hpp"
+
 
 
 using namespace std;
@@ -89,12 +91,18 @@ CHE_L2 ch2;
 
 CHE_L3 ch3;
 
+//------Picking---------//
+
+Bvh bvh;
+
 char file[1024]= ".ply";
 
 vector<int> star; 
 
 int smooth=true, wire=true, points=false, vstar=true, level = 0, vid = 0, dim = 0, nverts = 0;
 
+void read_key(int key);
+
 //----------------------------------------------------------------//
 
 vector<int> test_vstar(int vid, int dim)
@@ -459,6 +467,88 @@ void Reshape  (int w, int h)
 
 //----------------------------------------------------------------//
 
+void build_bvh()
+
+//----------------------------------------------------------------//
+
+{
+
+    if(level == 0) bvh.build( Bvh_CHE<CHE_L0>(ch0) );
+
+    if(level == 1) bvh.build( Bvh_CHE<CHE_L1>(ch1) );
+
+    if(level == 2) bvh.build( Bvh_CHE<CHE_L2>(ch2) );
+
+    if(level == 3) bvh.build( Bvh_CHE<CHE_L3>(ch3) );
+
+}
+
+//----------------------------------------------------------------//
+
+void mouse(int button, int state, int x, int y)
+
+//----------------------------------------------------------------//
+
+{
+
+	if( button != GLUT_LEFT_BUTTON || state != GLUT_DOWN || bvh.empty() ) return;
+
+
+
+	start_config();
+
+	GLdouble model[16], proj[16], o[3], e[3], d[3];
+
+	GLint    vport[4];
+
+	glGetDoublev ( GL_MODELVIEW_MATRIX , model );
+
+	glGetDoublev ( GL_PROJECTION_MATRIX, proj  );
+
+	glGetIntegerv( GL_VIEWPORT, vport );
+
+	gluUnProject( x, vport[3]-1-y, 0.0, model, proj, vport, &o[0], &o[1], &o[2] );
+
+	gluUnProject( x, vport[3]-1-y, 1.0, model, proj, vport, &e[0], &e[1], &e[2] );
+
+	d[0] = e[0]-o[0];  d[1] = e[1]-o[1];  d[2] = e[2]-o[2];
+
+
+
+	Bvh_hit h;
+
+	if( !bvh.ray( o, d, h ) ) return;
+
+
+
+	// corner of the hit triangle closest to the hit point
+
+	int k = 0;
+
+	if( h.u > 1-h.u-h.v && h.u >= h.v ) k = 1;
+
+	else if( h.v > 1-h.u-h.v ) k = 2;
+
+	if(level == 0) vid = ch0.V( 3*h.t+k );
+
+	if(level == 1) vid = ch1.V( 3*h.t+k );
+
+	if(level == 2) vid = ch2.V( 3*h.t+k );
+
+	if(level == 3) vid = ch3.V( 3*h.t+k );
+
+
+
+	simplexid->set_int_val(vid);
+
+	read_key(5);
+
+	glutPostRedisplay();
+
+}
+
+//----------------------------------------------------------------//
+
 void read_key(int key)
 
 //----------------------------------------------------------------//
@@ -511,6 +601,8 @@ void read_key(int key)
 
     }
 
+    build_bvh();
+
     simplexid->set_int_limits(0, nverts);
 
     read_key(5);
@@ -535,6 +627,10 @@ void read_key(int key)
 
 	case 3:
 
+    // the picking tree follows the mesh of the new level
+
+    build_bvh();
+
 	break;
 
 
@@ -601,6 +697,8 @@ int main(int argc, char **argv)
 
 	GLUI_Master.set_glutReshapeFunc ( Reshape );
 
+	GLUI_Master.set_glutMouseFunc   ( mouse );
+
     GLUI_Master.set_glutIdleFunc( myGlutIdle );
 
 
@@ -0,0 +1,213 @@
+/**
+* @file    Geometry.hpp
+*
+* @brief  (Structure of arrays geometry table)
+*
+* The vertex table of CHE_L0 is a vector of Vertex (seven reals
+* per vertex). VertexSoA stores the same seven values in separate
+* aligned arrays, so that the coordinate only passes (bounding box,
+* normalization, drawing) only read the x, y and z arrays. The
+* arrays use the precision of Vertex, and the normal and field
+* arrays are left empty when Vertex does not store them.
+*/
+//--------------------------------------------------//
+
+#ifndef _GEOMETRY_HPP_
+#define _GEOMETRY_HPP_
+
+#include <cstdlib>
+#include <cstring>
+#include "Vertex.hpp"
+
+/** \brief Alignment of the geometry arrays, in bytes*/
+#define GEOM_ALIGN 64
+
+//--------------------------------------------------//
+/** Aligned array of reals
+  * \brief Aligned array of reals*/
+template <class T> class Aligned_array
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Data, aligned on GEOM_ALIGN bytes*/
+  T *_p;
+  /** \brief Number of elements*/
+  int     _n;
+  /** \brief Number of allocated elements*/
+  int     _cap;
+
+public:
+  /** \brief Default constructor.*/
+  Aligned_array() : _p(NULL), _n(0), _cap(0) {}
+  /** \brief Copy constructor
+    * \param a - const Aligned_array& */
+  Aligned_array( const Aligned_array &a ) : _p(NULL), _n(0), _cap(0) { *this = a; }
+  /** \brief Destructor.*/
+  ~Aligned_array() { clear(); }
+
+  /** \brief Copy operator
+    * \param a - const Aligned_array& */
+  Aligned_array &operator = ( const Aligned_array &a )
+  {
+    if( this == &a ) return *this;
+    resize( a._n );
+    if( _n ) memcpy( _p, a._p, _n*sizeof(T) );
+    return *this;
+  }
+
+public:
+  /** \brief Number of elements*/
+  inline int size() const { return _n; }
+  /** \brief Access to the data*/
+  inline       T *data()       { return _p; }
+  /** \brief Access to the data*/
+  inline const T *data() const { return _p; }
+  /** \brief Access to an element
+    * \param i - const int */
+  inline       T &operator[]( const int i )       { return _p[i]; }
+  /** \brief Access to an element
+    * \param i - const int */
+  inline const T &operator[]( const int i ) const { return _p[i]; }
+
+  /** \brief Allocates room for c elements, keeping the current ones
+    * \param c - const int */
+  void reserve( const int c )
+  {
+    if( c <= _cap ) return;
+    size_t bytes = ( (c*sizeof(T) + GEOM_ALIGN-1) / GEOM_ALIGN ) * GEOM_ALIGN;
+    T *q = NULL;
+#if defined(_MSC_VER)
+    q = (T*)_aligned_malloc( bytes, GEOM_ALIGN );
+#else
+    if( posix_memalign( (void**)&q, GEOM_ALIGN, bytes ) != 0 ) q = NULL;
+#endif
+    if( q == NULL ) { cout << "Aligned_array::reserve ERROR: out of memory" << endl; exit(1); }
+    if( _n ) memcpy( q, _p, _n*sizeof(T) );
+    release();
+    _p   = q;
+    _cap = c;
+  }
+  /** \brief Resizes the array, keeping its first elements and 
+    * setting the new ones to zero
+    * \param n - const int */
+  void resize( const int n )
+  {
+    reserve( n );
+    for( int i=_n; i<n; ++i ) _p[i] = 0;
+    _n = n;
+  }
+  /** \brief Appends an element, doubling the allocation when full
+    * \param a - const T */
+  inline void push_back( const T a )
+  {
+    if( _n == _cap ) reserve( _cap ? 2*_cap : 16 );
+    _p[_n++] = a;
+  }
+  /** \brief Exchanges the data with another array, without copy
+    * \param a - Aligned_array& */
+  inline void swap( Aligned_array &a )
+  {
+    T *p = _p;  _p = a._p;  a._p = p;
+    int n = _n;  _n = a._n;  a._n = n;
+    int c = _cap;  _cap = a._cap;  a._cap = c;
+  }
+  /** \brief Frees the array*/
+  void clear() { release(); _p = NULL; _n = 0; _cap = 0; }
+
+protected:
+  /** \brief Frees the data*/
+  void release()
+  {
+#if defined(_MSC_VER)
+    if( _p ) _aligned_free( _p );
+#else
+    if( _p ) free( _p );
+#endif
+  }
+};
+
+//--------------------------------------------------//
+/** Structure of arrays vertex table
+  * \brief Vertex table with one array per coordinate*/
+class VertexSoA
+//--------------------------------------------------//
+{
+public:
+  /** \brief Precision of the arrays*/
+  typedef Vertex::real_type real_type;
+  /** \brief Aligned array of the vertex precision*/
+  typedef Aligned_array<real_type> array_type;
+  /** \brief True if the normals and the field are stored*/
+  static const bool attr = (CHE_VERTEX_ATTR != 0);
+
+public:
+  /** \brief Coordinates of the vertices*/
+  array_type  x,  y,  z;
+  /** \brief Normals of the vertices*/
+  array_type nx, ny, nz;
+  /** \brief Scalar field of the vertices*/
+  array_type field;
+
+public:
+  /** \brief Number of vertices*/
+  inline int size() const { return x.size(); }
+
+  /** \brief Resizes the table
+    * \param n - const int */
+  void resize( const int n )
+  {
+    x.resize(n); y.resize(n); z.resize(n);
+    if( attr ) { nx.resize(n); ny.resize(n); nz.resize(n); field.resize(n); }
+  }
+
+  /** \brief Appends a vertex, with a geometric growth of the arrays
+    * \param p - const Vertex& */
+  inline void push_back( const Vertex &p )
+  {
+    x.push_back( (real_type)p.x() ); y.push_back( (real_type)p.y() ); z.push_back( (real_type)p.z() );
+    if( !attr ) return;
+    nx.push_back( (real_type)p.nx() ); ny.push_back( (real_type)p.ny() ); nz.push_back( (real_type)p.nz() );
+    field.push_back( (real_type)p.field() );
+  }
+  /** \brief Exchanges the arrays with another table, without copy
+    * \param s - VertexSoA& */
+  inline void swap( VertexSoA &s )
+  {
+    x.swap( s.x ); y.swap( s.y ); z.swap( s.z );
+    nx.swap( s.nx ); ny.swap( s.ny ); nz.swap( s.nz ); field.swap( s.field );
+  }
+  /** \brief Frees the table*/
+  void clear()
+  { x.clear(); y.clear(); z.clear(); nx.clear(); ny.clear(); nz.clear(); field.clear(); }
+
+  /** \brief Gets a vertex
+    * \param v - const Vid */
+  inline Vertex get( const Vid v ) const
+  {
+    if( !attr ) return Vertex( x[v], y[v], z[v] );
+    return Vertex( x[v], y[v], z[v], nx[v], ny[v], nz[v], field[v] );
+  }
+
+  /** \brief Sets a vertex
+    * \param v - const Vid
+    * \param p - const Vertex& */
+  inline void set( const Vid v, const Vertex &p )
+  {
+    x [v] = p.x (); y [v] = p.y (); z [v] = p.z ();
+    if( !attr ) return;
+    nx[v] = p.nx(); ny[v] = p.ny(); nz[v] = p.nz();
+    field[v] = p.field();
+  }
+
+  /** \brief Tests if a vertex equals a given one
+    * \param v - const Vid
+    * \param p - const Vertex& */
+  inline bool equals( const Vid v, const Vertex &p ) const
+  {
+    if( x[v] != p.x() || y[v] != p.y() || z[v] != p.z() ) return false;
+    return !attr || ( nx[v] == p.nx() && ny[v] == p.ny() && nz[v] == p.nz() && field[v] == p.field() );
+  }
+};
+
+#endif
+//--------------------------------------------------//
@@ -21,8 +21,16 @@
 #include "fparser.h"    /**< Parses scalar Field*/  
 #include "colorramp.h"  /**< Gl color maps*/
 #include "CHF_L0.hpp"   /**< Level 0 inheritance*/
+#include "../common/Parallel.hpp"  /**< OpenMP helpers*/
+#include "../common/Ply_mmap.hpp" /**< Binary PLY fast path*/
+#include "../common/Snapshot.hpp" /**< Binary snapshots*/
+#include "../common/Space_curve.hpp" /**< Locality reordering*/
 
 using namespace std;
+/** \brief Tests if the tetrahedron of a half-face has a vertex
+  * \param T - const Vid*  the 4 vertices of the tetrahedron
+  * \param x - const Vid */
+static inline bool te_has( const Vid *T, const Vid x ) { return T[0] == x || T[1] == x || T[2] == x || T[3] == x; }
 //--------------------------------------------------//
 vector<Vid> CHF_L0::R_00(const Vid v)
 //--------------------------------------------------//
@@ -34,6 +42,17 @@ vector<Vid> CHF_L0::R_00(const Vid v)
   HFid  h1 = 0,  h2 = 0,  h3 = 0;
   if( !v_valid(v) ) { star.push_back(INV); return star; }
 
+  if( has_index() )
+  {
+    for( int k = index_lower(v); k < (int)_HI.size() && _V[_HI[k]] == v; ++k )
+    {
+      neighbors( _HI[k], h1, h2, h3 );
+      sstar.insert( V(h1) );   
+      sstar.insert( V(h2) );   
+      sstar.insert( V(h3) );
+    }
+  }
+  else
   for(HFid i=0; i<ntetra()<<2; ++i){   
 	if( V(i) == v )
 	{
@@ -58,6 +77,13 @@ vector<TEid> CHF_L0::R_03(const Vid v)
   vector<Vid> star;
   if( !v_valid(v) ) { star.push_back(INV); return star; }
 
+  if( has_index() )
+  {
+    for( int k = index_lower(v); k < (int)_HI.size() && _V[_HI[k]] == v; ++k )
+      star.push_back( tetra(_HI[k]) );
+    return star;
+  }
+
   for(HFid i=0; i<ntetra()<<2; ++i)
   { 
     if( V(i) == v ) 
@@ -76,6 +102,17 @@ vector<Vid> CHF_L0::R_10(const Vid a, const Vid b)
   HFid  h1 = 0,  h2 = 0,  h3 = 0;
   if( !v_valid(a) || !v_valid(b) || a ==b) { star.push_back(INV); return star; }
 
+  if( has_index() )
+  {
+    // the tetrahedra of the edge are in the star of a
+    for( int k = index_lower(a); k < (int)_HI.size() && _V[_HI[k]] == a; ++k )
+    {
+      const Vid *T = &_V[ _HI[k] & ~3 ];
+      if( !te_has( T, b ) ) continue;
+      for( int j=0; j<4; ++j ) if( T[j] != a && T[j] != b ) sstar.insert( T[j] );
+    }
+  }
+  else
   for(HFid i=0; i<ntetra()<<2; ++i){ 
     if( (V(i) == a) && (  (V(nexthf(i)) == b) ||  (V(midhf(i)) == b)  || (V(prevhf(i)) == b) )  ){
 	  neighbors(i, h1, h2, h3);
@@ -102,6 +139,12 @@ vector<TEid> CHF_L0::R_13(const Vid a, const Vid b)
  
   if( !v_valid(a) || !v_valid(b) || a ==b ) { star.push_back(INV); return star; }
 
+  if( has_index() )
+  {
+    for( int k = index_lower(a); k < (int)_HI.size() && _V[_HI[k]] == a; ++k )
+      if( te_has( &_V[ _HI[k] & ~3 ], b ) ) sstar.insert( tetra(_HI[k]) );
+  }
+  else
   for(HFid i=0; i<ntetra()<<2; ++i)
   {
     if( (V(i) == a) && ( (V(nexthf(i)) == b) ||  (V(midhf(i)) == b)  || (V(prevhf(i)) == b) )  )
@@ -129,6 +172,22 @@ vector<TEid> CHF_L0::R_33(const TEid t)
  
   if( !te_valid(t) ) { star.push_back(INV); return star; }
   
+  if( has_index() )
+  {
+    // faces abc, acd and abd in the star of a, face bcd in the star of b
+    for( int k = index_lower(a); k < (int)_HI.size() && _V[_HI[k]] == a; ++k )
+    {
+      const Vid *T = &_V[ _HI[k] & ~3 ];
+      const bool hb = te_has( T, b ), hc = te_has( T, c ), hd = te_has( T, d );
+      if( ( hb && hc ) || ( hc && hd ) || ( hb && hd ) ) sstar.insert( tetra(_HI[k]) );
+    }
+    for( int k = index_lower(b); k < (int)_HI.size() && _V[_HI[k]] == b; ++k )
+    {
+      const Vid *T = &_V[ _HI[k] & ~3 ];
+      if( te_has( T, c ) && te_has( T, d ) ) sstar.insert( tetra(_HI[k]) );
+    }
+  }
+  else
   for(HFid i=0; i<ntetra()<<2; ++i)
   {
     if( (V(i) == a) && ( (V(nexthf(i)) == b) ||  (V(midhf(i)) == b)  || (V(prevhf(i)) == b) ) && ( (V(nexthf(i)) == c) ||  (V(midhf(i)) == c)  || (V(prevhf(i)) == c) )  )
@@ -155,6 +214,33 @@ vector<TEid> CHF_L0::R_33(const TEid t)
   return star;
 }
 //--------------------------------------------------//
+void CHF_L0::build_index()
+//--------------------------------------------------//
+/** Sorts the valid half-faces by vertex (counting sort, stable in the half-faces).*/
+{
+  const Vid nv = nvert();
+  vector<int> off( nv+1, 0 );
+  for( HFid h=0; h<ntetra()<<2; ++h )
+    if( _V[h] >= 0 && _V[h] < nv ) ++off[ _V[h]+1 ];
+  for( Vid v=0; v<nv; ++v ) off[v+1] += off[v];
+
+  _HI.resize( off[nv] );
+  for( HFid h=0; h<ntetra()<<2; ++h )
+    if( _V[h] >= 0 && _V[h] < nv ) _HI[ off[_V[h]]++ ] = h;
+}
+//--------------------------------------------------//
+const int CHF_L0::index_lower( const Vid v ) const
+//--------------------------------------------------//
+{
+  int lo = 0, hi = (int)_HI.size();
+  while( lo < hi )
+  {
+    const int m = lo + ( hi-lo ) / 2;
+    if( _V[_HI[m]] < v ) lo = m+1; else hi = m;
+  }
+  return lo;
+}
+//--------------------------------------------------//
 void CHF_L0::bounding_box( float *min, float *max )
 //--------------------------------------------------//
 {
@@ -431,6 +517,7 @@ void CHF_L0::read_ply( const char* fn )
 {
 	_G.clear();
 	_V.clear();
+	_HI.clear();
   float xmin= 0, xmax= 0, ymin= 0, ymax=0, zmin=0, zmax= 0;
 
   // Stores Start && L1 && L2 time;
@@ -441,6 +528,15 @@ void CHF_L0::read_ply( const char* fn )
 
   printf("CHF_L0::read_ply(%s)...", fn) ;
 
+  if( read_ply_mmap( fn ) )
+  {
+    float min[3], max[3];
+    bounding_box( min, max );
+    legalize_model( min, max);
+    printf(" %d vertices and %d tetrahedrons found\n", nvert(), ntetra() ) ;
+    return;
+  }
+
   /*** the Ply object ***/
   PlyFile  *in_ply;
   PlyFace     face;
@@ -542,6 +638,78 @@ void CHF_L0::read_ply( const char* fn )
   //cout << "L0 load time:" << static_cast<double>(L0_time-start_time)/static_cast<double>(CLOCKS_PER_SEC) << endl;
 }
 //--------------------------------------------------//
+/** Stores the vertices parsed from an ascii PLY file in _G*/
+struct Ply_to_CHF
+//--------------------------------------------------//
+{
+  Vertex *G;
+  Ply_to_CHF( Vertex *g ) : G(g) {}
+  inline void operator()( const int v, const double x, const double y, const double z ) const
+  {
+    Vertex p;
+    p.set_x ( (Vertex::real_type)x ) ;
+    p.set_y ( (Vertex::real_type)y ) ;
+    p.set_z ( (Vertex::real_type)z ) ;
+    p.set_nx( 0 ) ;
+    p.set_ny( 0 ) ;
+    p.set_nz( 0 ) ;
+    G[v] = p;
+  }
+};
+//--------------------------------------------------//
+bool CHF_L0::read_ply_mmap( const char* fn )
+//--------------------------------------------------//
+/** Reads a binary little endian or ascii PLY file through a memory map.*/
+{
+  Ply_mmap ply;
+  if( !ply.open( fn ) ) return false;
+
+  const Vid  nv   = ply.nvert();
+  const TEid ntet = ply.nface();
+
+  _HI.clear();
+  _V.resize( ntet<<2 );
+
+  if( ply.ascii() )
+  {
+    // parallel parse, straight into the final tables
+    _G.resize( nv );
+    if( !ply.read_ascii( Ply_to_CHF( nv ? &_G[0] : NULL ), ntet ? &_V[0] : NULL, 4 ) ) { _V.clear(); _G.clear(); return false; }
+
+    set_nvert (nv);
+    set_ntetra(ntet);
+    return true;
+  }
+  if( ntet > 0 && !ply.read_faces( &_V[0], 4 ) ) { _V.clear(); return false; }
+
+  set_nvert (nv);
+  set_ntetra(ntet);
+
+  // by blocks of vertices, through a small interleaved buffer
+  const int bs = 1024;
+  const int nb = ( nv + bs-1 ) / bs;
+  _G.resize( nv );
+  #pragma omp parallel for schedule(static)
+  for( int b=0; b<nb; ++b )
+  {
+    Vertex::real_type xyz[3*bs];
+    const Vid v0 = b*bs, v1 = ( v0+bs < nv ) ? v0+bs : nv;
+    ply.read_positions( v0, v1, xyz );
+    for( Vid v=v0; v<v1; ++v )
+    {
+      Vertex p;
+      p.set_x ( xyz[3*(v-v0)  ] ) ;
+      p.set_y ( xyz[3*(v-v0)+1] ) ;
+      p.set_z ( xyz[3*(v-v0)+2] ) ;
+      p.set_nx( 0 ) ;
+      p.set_ny( 0 ) ;
+      p.set_nz( 0 ) ;
+      _G[v] = p;
+    }
+  }
+  return true;
+}
+//--------------------------------------------------//
 void CHF_L0::write_ply( const char* file, bool bin )
 //--------------------------------------------------//
 /** Writes a 3D triangulated model in the PLY file format.*/
@@ -603,3 +771,364 @@ void CHF_L0::write_ply( const char* file, bool bin )
   printf(" %d vertices and %d triangles written\n", nvert(), ntetra() ) ;
 }
 //--------------------------------------------------------------//
+bool CHF_L0::write_snapshot( const char* fn )
+//--------------------------------------------------------------//
+{
+  printf("CHF_L0::write_snapshot(%s)...", fn) ;
+
+  materialize();
+  Snapshot_writer w;
+  write_tables( w );
+
+  if( !w.write( fn, "CHF", snapshot_level() ) ) { printf(" cannot write the file.\n" ); return false; }
+
+  printf(" level %d written\n", snapshot_level() ) ;
+  return true;
+}
+//--------------------------------------------------------------//
+bool CHF_L0::read_snapshot( const char* fn )
+//--------------------------------------------------------------//
+{
+  printf("CHF_L0::read_snapshot(%s)...", fn) ;
+
+  clear();
+
+  Snapshot_reader r;
+  bool ok = r.open( fn, "CHF" ) && r.level() >= snapshot_level() && read_tables( r );
+  ok = ok && (Vid)_G.size() == nvert() && (HFid)_V.size() == 4*ntetra();
+
+  if( !ok )
+  {
+    printf(" not a valid snapshot of this level.\n" );
+    clear();
+    return false;
+  }
+
+  printf(" %d vertices and %d tetrahedra found\n", nvert(), ntetra() ) ;
+  return true;
+}
+//--------------------------------------------------------------//
+void CHF_L0::write_tables( Snapshot_writer &w ) const
+//--------------------------------------------------------------//
+{
+  w.add_value( "NV", _nvert );
+  w.add_value( "NT", _ntetra );
+  w.add( "V", _V );
+  w.add( "G", _G );
+}
+//--------------------------------------------------------------//
+bool CHF_L0::read_tables( const Snapshot_reader &r )
+//--------------------------------------------------------------//
+{
+  return r.get_value( "NV", _nvert ) && r.get_value( "NT", _ntetra ) && r.get( "V", _V ) && r.get( "G", _G );
+}
+//--------------------------------------------------------------//
+/** Vertex graph of a tetrahedral mesh in rows: the neighbours of v are
+  * adj[ off[v] .. off[v+1]-1 ], sorted*/
+static void vertex_graph( const vector<Vid> &V, const TEid nt, const Vid nv, vector<int> &off, vector<Vid> &adj )
+//--------------------------------------------------------------//
+{
+  static const char comb1[6] = { 0,0,0,1,1,2 } ;
+  static const char comb2[6] = { 1,2,3,2,3,3 } ;
+
+  vector<int> pos( nv+1, 0 );
+  for( TEid t=0; t<nt; ++t )
+    for( int i=0; i<6; ++i )
+    {
+      const Vid a = V[4*t+comb1[i]], b = V[4*t+comb2[i]];
+      if( a < 0 || b < 0 || a >= nv || b >= nv || a == b ) continue;
+      ++pos[a+1]; ++pos[b+1];
+    }
+  for( Vid v=0; v<nv; ++v ) pos[v+1] += pos[v];
+
+  vector<Vid> occ( pos[nv] );
+  {
+    vector<int> fill( pos.begin(), pos.end()-1 );
+    for( TEid t=0; t<nt; ++t )
+      for( int i=0; i<6; ++i )
+      {
+        const Vid a = V[4*t+comb1[i]], b = V[4*t+comb2[i]];
+        if( a < 0 || b < 0 || a >= nv || b >= nv || a == b ) continue;
+        occ[ fill[a]++ ] = b;
+        occ[ fill[b]++ ] = a;
+      }
+  }
+
+  // sorted rows without repetition
+  off.assign( nv+1, 0 );
+  adj.clear();
+  adj.reserve( occ.size() / 2 );
+  for( Vid v=0; v<nv; ++v )
+  {
+    sort( occ.begin()+pos[v], occ.begin()+pos[v+1] );
+    for( int k=pos[v]; k<pos[v+1]; ++k )
+      if( k == pos[v] || occ[k] != occ[k-1] ) adj.push_back( occ[k] );
+    off[v+1] = (int)adj.size();
+  }
+}
+//--------------------------------------------------------------//
+/** Breadth first search from r: appends the visited vertices to order
+  * (in Cuthill-McKee order when sorted = true, each vertex visiting its
+  * neighbours by increasing degree), sets last to the position of the
+  * last level in order and returns the number of levels*/
+static int vertex_bfs( const vector<int> &off, const vector<Vid> &adj, const Vid r, vector<unsigned int> &mark, const unsigned int gen, vector<Vid> &order, size_t &last, const bool sorted )
+//--------------------------------------------------------------//
+{
+  order.push_back( r );
+  mark[r] = gen;
+
+  int    nlevel = 0;
+  size_t level  = order.size()-1, next;
+  while( level < order.size() )
+  {
+    last = level;
+    next = order.size();
+    for( size_t i=level; i<next; ++i )
+    {
+      const Vid    u = order[i];
+      const size_t n = order.size();
+      for( int k=off[u]; k<off[u+1]; ++k )
+      {
+        const Vid w = adj[k];
+        if( mark[w] == gen ) continue;
+        mark[w] = gen;
+        order.push_back( w );
+      }
+      if( !sorted ) continue;
+      // neighbours by increasing degree, then by id
+      for( size_t a=n+1; a<order.size(); ++a )
+        for( size_t b=a; b>n; --b )
+        {
+          const Vid x = order[b-1], y = order[b];
+          const int dx = off[x+1]-off[x], dy = off[y+1]-off[y];
+          if( dx < dy || ( dx == dy && x < y ) ) break;
+          order[b-1] = y; order[b] = x;
+        }
+    }
+    level = next;
+    ++nlevel;
+  }
+  return nlevel;
+}
+//--------------------------------------------------------------//
+void CHF_L0::reorder( vector<Vid> &vorder, vector<TEid> &torder, const bool rcm )
+//--------------------------------------------------------------//
+{
+  const Vid  nv = nvert();
+  const TEid nt = ntetra();
+
+  vorder.clear();
+  torder.clear();
+  if( nv == 0 ) return;
+
+  vector<Vid>  vnew( nv );
+  vector<TEid> tnew( nt );
+  vector< pair<uint64_t,int> > key;
+
+  if( rcm )
+  {
+    // Reverse Cuthill-McKee, from a pseudo-peripheral vertex of each compound
+    vector<int> off;
+    vector<Vid> adj;
+    vertex_graph( _V, nt, nv, off, adj );
+
+    vector<unsigned int> mark( nv, 0 ), seen( nv, 0 );
+    unsigned int gen = 0;
+    vector<Vid> level;
+    vorder.reserve( nv );
+    for( Vid s=0; s<nv; ++s )
+    {
+      if( seen[s] ) continue;
+
+      // pseudo-peripheral vertex: restarts from a vertex of smallest
+      // degree in the last level while the number of levels grows
+      Vid    r = s;
+      int    depth = 0;
+      size_t last;
+      for( int it=0; it<8; ++it )
+      {
+        level.clear();
+        const int d = vertex_bfs( off, adj, r, mark, ++gen, level, last, false );
+        if( d <= depth ) break;
+        depth = d;
+
+        Vid best = level[last];
+        for( size_t i=last+1; i<level.size(); ++i )
+          if( off[level[i]+1]-off[level[i]] < off[best+1]-off[best] ) best = level[i];
+        r = best;
+      }
+
+      vertex_bfs( off, adj, r, seen, 1, vorder, last, true );
+    }
+    reverse( vorder.begin(), vorder.end() );
+    for( Vid i=0; i<nv; ++i ) vnew[ vorder[i] ] = i;
+
+    // tetrahedra by their smallest new vertex, the invalid ones at the end
+    key.resize( nt );
+    for( TEid t=0; t<nt; ++t )
+    {
+      if( !te_valid(t) ) { key[t] = make_pair( ~(uint64_t)0, t ); continue; }
+      Vid m = vnew[ _V[4*t] ];
+      for( int j=1; j<4; ++j ) if( vnew[ _V[4*t+j] ] < m ) m = vnew[ _V[4*t+j] ];
+      key[t] = make_pair( (uint64_t)m, t );
+    }
+  }
+  else
+  {
+    // box of the valid vertices
+    double min[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for( Vid v=0; v<nv; ++v )
+    {
+      if( !v_valid(v) ) continue;
+      const double p[3] = { _G[v].x(), _G[v].y(), _G[v].z() };
+      for( int i=0; i<3; ++i ) { if( p[i] < min[i] ) min[i] = p[i]; if( p[i] > max[i] ) max[i] = p[i]; }
+    }
+    const Space_curve curve( min, max, true );
+
+    key.resize( nv );
+    #pragma omp parallel for schedule(static)
+    for( Vid v=0; v<nv; ++v )
+      key[v] = make_pair( v_valid(v) ? curve.key( _G[v].x(), _G[v].y(), _G[v].z() ) : ~(uint64_t)0, v );
+    sort( key.begin(), key.end() );
+    vorder.resize( nv );
+    for( Vid i=0; i<nv; ++i ) { vorder[i] = key[i].second; vnew[ vorder[i] ] = i; }
+
+    // tetrahedra by the key of their centroid, the invalid ones at the end
+    key.resize( nt );
+    #pragma omp parallel for schedule(static)
+    for( TEid t=0; t<nt; ++t )
+    {
+      if( !te_valid(t) ) { key[t] = make_pair( ~(uint64_t)0, t ); continue; }
+      const Vertex &a = _G[_V[4*t]], &b = _G[_V[4*t+1]], &c = _G[_V[4*t+2]], &d = _G[_V[4*t+3]];
+      key[t] = make_pair( curve.key( ( (double)a.x()+b.x()+c.x()+d.x() ) / 4, ( (double)a.y()+b.y()+c.y()+d.y() ) / 4, ( (double)a.z()+b.z()+c.z()+d.z() ) / 4 ), t );
+    }
+  }
+
+  sort( key.begin(), key.end() );
+  torder.resize( nt );
+  for( TEid i=0; i<nt; ++i ) { torder[i] = key[i].second; tnew[ torder[i] ] = i; }
+
+  remap( vnew, tnew );
+
+  cout << "CHF_L0::reorder: " << ( rcm ? "reverse Cuthill-McKee" : "Hilbert" ) << " order of " << nv << " vertices and " << nt << " tetrahedra." << endl;
+}
+//--------------------------------------------------------------//
+/** Numbers the kept entries of a table by a parallel prefix sum: id[i]
+  * is 1 to keep the entry i and 0 to drop it, and becomes its new id,
+  * or -1. Returns the number of kept entries.*/
+static int compact_ids( vector<int> &id )
+//--------------------------------------------------------------//
+{
+  const int n   = (int)id.size();
+  int nth = 1;
+  vector<int> sum;
+
+  #pragma omp parallel num_threads( par_nthreads() )
+  {
+    // the chunks follow the threads granted, not the ones requested
+    #pragma omp single
+    {
+      nth = par_team_size();
+      sum.assign( nth+1, 0 );
+    }
+
+    const int t  = par_thread();
+    const int c0 = (int)( (long long)n* t   /nth );
+    const int c1 = (int)( (long long)n*(t+1)/nth );
+
+    int c = 0;
+    for( int i = c0 ; i < c1 ; ++i ) c += id[i];
+    sum[t+1] = c;
+
+    #pragma omp barrier
+    #pragma omp single
+    for( int k = 0 ; k < nth ; ++k ) sum[k+1] += sum[k];
+
+    c = sum[t];
+    for( int i = c0 ; i < c1 ; ++i ) id[i] = id[i] ? c++ : -1;
+  }
+  return sum[nth];
+}
+//--------------------------------------------------------------//
+void CHF_L0::compact( vector<Vid> &vnew, vector<TEid> &tnew )
+//--------------------------------------------------------------//
+{
+  const Vid  nv = nvert();
+  const TEid nt = ntetra();
+
+  vnew.resize( nv );
+  tnew.resize( nt );
+  #pragma omp parallel for schedule(static)
+  for( Vid v=0; v<nv; ++v ) vnew[v] = CHF_L0::v_valid( v ) ? 1 : 0;
+  #pragma omp parallel for schedule(static)
+  for( TEid t=0; t<nt; ++t )
+  {
+    tnew[t] = 1;
+    for( int j=0; j<4; ++j )
+      if( _V[4*t+j] == INV || !CHF_L0::v_valid( _V[4*t+j] ) ) tnew[t] = 0;
+  }
+  const Vid  mv = compact_ids( vnew );
+  const TEid mt = compact_ids( tnew );
+
+  if( mv < nv || mt < nt ) remap( vnew, tnew );
+
+  cout << "CHF_L0::compact: " << nv-mv << " vertices and " << nt-mt << " tetrahedra removed." << endl;
+}
+//--------------------------------------------------------------//
+void CHF_L0::remap( const vector<Vid> &vnew, const vector<TEid> &tnew )
+//--------------------------------------------------------------//
+{
+  const Vid  nv = (Vid) vnew.size();
+  const TEid nt = (TEid)tnew.size();
+
+  // number of kept elements: all of them for a permutation
+  Vid  mv = 0;
+  TEid mt = 0;
+  #pragma omp parallel for reduction(+:mv)
+  for( Vid  v=0; v<nv; ++v ) if( vnew[v] >= 0 ) ++mv;
+  #pragma omp parallel for reduction(+:mt)
+  for( TEid t=0; t<nt; ++t ) if( tnew[t] >= 0 ) ++mt;
+
+  vector<Vertex> G( mv );
+  #pragma omp parallel for schedule(static)
+  for( Vid v=0; v<nv; ++v ) if( vnew[v] >= 0 ) G[ vnew[v] ] = _G[v];
+  _G.swap( G );
+
+  vector<Vid> V( 4*mt );
+  #pragma omp parallel for schedule(static)
+  for( TEid t=0; t<nt; ++t )
+  {
+    if( tnew[t] < 0 ) continue;
+    for( int j=0; j<4; ++j )
+    {
+      const Vid v = _V[4*t+j];
+      V[ 4*tnew[t]+j ] = ( v >= 0 && v < nv ) ? vnew[v] : v;
+    }
+  }
+  _V.swap( V );
+
+  _nvert  = mv;
+  _ntetra = mt;
+  _HI.clear();
+}
+//--------------------------------------------------------------//
+void CHF_L0::take( CHF_L0 &c )
+//--------------------------------------------------------------//
+{
+  _nvert  = c._nvert;   c._nvert  = 0;
+  _ntetra = c._ntetra;  c._ntetra = 0;
+  _V .swap( c._V  );  c._V .clear();
+  _G .swap( c._G  );  c._G .clear();
+  _HI.swap( c._HI );  c._HI.clear();
+}
+//--------------------------------------------------------------//
+void CHF_L0::clear()
+//--------------------------------------------------------------//
+{
+  _nvert  = 0;
+  _ntetra = 0;
+  _V .clear();
+  _G .clear();
+  _HI.clear();
+}
+//--------------------------------------------------------------//
@@ -18,6 +18,9 @@
 #include <vector>
 #include "Vertex.hpp"
 
+class Snapshot_writer;
+class Snapshot_reader;
+
 /** \brief Invalid integer index */
 #define INV -2
 
@@ -55,6 +58,10 @@ protected:
   /** \brief Geometry Table */
   vector<Vertex> _G;
 
+  /** \brief Half-face index: the valid half-faces sorted by vertex
+    * (empty if not built, see build_index) */
+  vector<HFid>   _HI;
+
 public:
   /** \brief Default constructor.*/
   CHF_L0(): _nvert(0), _ntetra(0) {};
@@ -110,7 +117,7 @@ protected:
   /** \brief Sets the vertex of a half-edge
     * \param v - const HEid  
     * \param v - const  Vid */
-  inline const void set_V( const HFid h, const Vid v ) {  if( h>=0 && h<4*ntetra()) _V[h]=v ; }
+  inline const void set_V( const HFid h, const Vid v ) {  if( h>=0 && h<4*ntetra()) { _V[h]=v ; _HI.clear(); } }
 
   /** \breaf Sets the geometry of a vertex in the model 
     * \param v - const Vid  
@@ -127,7 +134,7 @@ protected:
 	
   /** \brief Sets a half-face as invalid
     * \param h - const HFid */
-  inline const void hf_invalid( const  HFid h ) { if ( hf_valid(h) ) _V[h] = INV; return; }
+  inline const void hf_invalid( const  HFid h ) { if ( hf_valid(h) ) { _V[h] = INV; _HI.clear(); } return; }
 
 public:
   /** \brief Accesses the tetrahedron of a half-face 
@@ -203,6 +210,17 @@ public:
   /** \brief Computes the tetrahedrons in the star of a tetrahedron 
     * \param r - const TEid */
   virtual vector<TEid> R_33( const TEid t );
+
+  /** \brief Builds the half-face index: the queries above then search
+    * the half-faces of a vertex in O(log n) instead of scanning the
+    * mesh, for 4 bytes per half-face (the opposite table of level 1
+    * costs as much, and is much longer to build). The index is dropped
+    * when the vertex table changes. */
+  void build_index ();
+  /** \brief Frees the half-face index */
+  inline void clear_index () { vector<HFid>().swap( _HI ); }
+  /** \brief Tests if the half-face index is built */
+  inline const bool has_index () const { return !_HI.empty(); }
  
   /** \brief Gets the model bouding_box
     * \param min - float*.
@@ -219,6 +237,29 @@ public:
   /** \brief Checks mesh validation */
   void check ();
 
+  /** \brief Empties the structure: the tables of every level are cleared */
+  virtual void clear ();
+
+  /** \brief Reorders the vertices and the tetrahedra for locality: along
+    * the Hilbert curve of the vertices and of the tetrahedron centroids,
+    * or by Reverse Cuthill-McKee on the vertex graph (smallest bandwidth,
+    * for linear solvers), the tetrahedra then following their smallest
+    * vertex. The tables of all the levels are remapped; the half-faces
+    * of a tetrahedron keep their order.
+    * \param vorder - vector<Vid>&   inverse map: old id of each new vertex
+    * \param torder - vector<TEid>&  inverse map: old id of each new tetrahedron
+    * \param rcm = false - const bool  Reverse Cuthill-McKee instead of Hilbert*/
+  void reorder ( vector<Vid> &vorder, vector<TEid> &torder, const bool rcm = false );
+
+  /** \brief Squeezes out the invalid vertices and tetrahedra (left by
+    * v_invalid and te_invalid): the others keep their relative order and
+    * the tables of all the levels are renumbered. The opposites of the
+    * removed half-faces must have been updated, otherwise their mates
+    * become boundary.
+    * \param vnew - vector<Vid>&   new id of each old vertex, -1 if removed
+    * \param tnew - vector<TEid>&  new id of each old tetrahedron, -1 if removed*/
+  void compact ( vector<Vid> &vnew, vector<TEid> &tnew );
+
   /** \brief Draws the mesh in wireframe 
     * \param in= true - const bool*/
   virtual void draw_wire ( const int t=4 );
@@ -234,6 +275,57 @@ public:
     * \param fn - const char* 
     * \param bin = false - bool*/ 
   void  write_ply ( const char* fn, bool bin= false );
+
+  /** \brief Writes the tables of the structure in a binary snapshot,
+    * that read_snapshot loads without rebuilding anything
+    * \param fn - const char* */
+  bool  write_snapshot ( const char* fn );
+
+  /** \brief Reads a snapshot written by write_snapshot at this level
+    * or at a higher one. Returns false if the file is not a valid
+    * snapshot; the mesh is then left empty.
+    * \param fn - const char* */
+  bool  read_snapshot ( const char* fn );
+
+protected:
+  /** \brief Fast path of read_ply for binary little endian and ascii
+    * files: maps the file and converts the blocks in bulk, or parses
+    * the ascii body by chunks in parallel. Returns false
+    * if the file has to be read by the generic ply reader.
+    * \param fn - const char*. */
+  bool  read_ply_mmap ( const char* fn );
+
+  /** \brief Level of the structure, stored in the snapshots*/
+  virtual const int snapshot_level() const { return 0; }
+  /** \brief Adds the tables of the level to a snapshot
+    * \param w - Snapshot_writer& */
+  virtual void write_tables ( Snapshot_writer &w ) const;
+  /** \brief Reads the tables of the level from a snapshot
+    * \param r - const Snapshot_reader& */
+  virtual bool read_tables ( const Snapshot_reader &r );
+
+  /** \brief Applies a permutation of the vertices and of the tetrahedra
+    * to the tables of the level; the elements of new id -1 are dropped
+    * \param vnew - const vector<Vid>&   new id of each vertex
+    * \param tnew - const vector<TEid>&  new id of each tetrahedron*/
+  virtual void remap ( const vector<Vid> &vnew, const vector<TEid> &tnew );
+
+  /** \brief Takes the tables of c, which is left empty: used by the
+    * promotion constructors of the upper levels instead of a copy
+    * \param c - CHF_L0& */
+  void take ( CHF_L0 &c );
+  /** \brief Computes the tables that a promoted level builds on demand
+    * (called before writing a snapshot) */
+  virtual void materialize () {}
+
+  /** \brief First position of the half-faces of a vertex in the index
+    * \param v - const Vid */
+  const int index_lower ( const Vid v ) const;
+  /** \brief New id of a half-face after a tetrahedron permutation, -1
+    * if its tetrahedron is dropped
+    * \param h    - const HFid
+    * \param tnew - const vector<TEid>& */
+  static inline HFid remap_hf( const HFid h, const vector<TEid> &tnew ) { return h < 0 ? h : ( tnew[h>>2] < 0 ? -1 : ( tnew[h>>2] << 2 | (h & 3) ) ); }
 };
 #endif
 //--------------------------------------------------------------//
@@ -18,6 +18,8 @@
 
 #include "colorramp.h"  /**< Gl color maps*/
 #include "CHF_L1.hpp"  /**< Level 1 inheritance*/
+#include "../common/Parallel.hpp" /**< OpenMP helpers*/
+#include "../common/Snapshot.hpp" /**< Binary snapshots*/
 											
 using namespace std;	
 //--------------------------------------------------//
@@ -25,61 +27,13 @@ vector<Vid> CHF_L1::R_00(const Vid v)
 //--------------------------------------------------//
 /** Computes the vertices in the star of a vertex.*/
 {
-  TEid t  = 0;
-  HFid h = 0,  h1 = 0,  h2 = 0,  h3 = 0;
+  vector<Vid> star;
+  Star_collector<Vid> f( star );
 
-  stack<TEid> s;
-	
-  // vertex star.
-  set<Vid> sstar;
-  vector<Vid>  star;
- 	
-  // visited tetrahedra.
-  set<TEid> tet;
-
-  // Tests if the vertex v is valid.
-  if( !v_valid(v) ) {	star.push_back(INV); return star; }
-
-  // Finds the first tetrahedron that contains v.
-  for(HFid i=0; i<ntetra()<<2; ++i)
-    if( V(i) == v ) {
-	  // includes the tetrahedron in the stack.
-	  t = tetra(i);	s.push(t);
-	  break;
-	}
-	
-  // while the stack isn't empty:
-  while( !s.empty() )
-  {
-    // picks the top tetrahedron.
-    t = s.top();	s.pop();
-			
-	// If tetra was already visited, continue.
-	pair<set<int>::iterator,bool> status = tet.insert(t);
-	if( !status.second ) continue;
-			
-	for( int i = t<<2; i<(t+1)<<2; ++i )
-	  if( V(i) ==  v )
-	  {
-	    neighbors( i, h1, h2, h3 );
-			
-	    // insert the vertex in the star
-	    sstar.insert( V(h1) );
-		sstar.insert( V(h2) );
-		sstar.insert( V(h3) );
-		
-		//includes the neighboors tetrahedra in the stack 
-		h = O(h1) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		h = O(h2) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		h = O(h3) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		break;
-	  }
-  }
+  if( !visit_R_00( v, f ) ) { star.push_back(INV); return star; }
 
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
-    star.push_back( *iter );
- 	
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
   return star;
 }
 //--------------------------------------------------//
@@ -87,53 +41,13 @@ vector<TEid> CHF_L1::R_03(const Vid v)
 //--------------------------------------------------//
 /** Computes the tetrahedrons in the star of a vertex.*/
 {
-  TEid  t = 0;
-  HFid h = 0,  h1 = 0,  h2 = 0,  h3 = 0;
-
-  stack<TEid> s;
-  
-  // Vertex star
-  set<TEid> sstar;
-  vector<TEid>  star;
- 
-  //Tests if the vertex v is valid.
-  if( !v_valid(v) ) {	star.push_back(INV); return star;	}
-
-  //Finds the first tetrahedron that contains v.
-  for(HFid i=0; i<ntetra()<<2; ++i)
-    if( V(i) == v ) {
-	  //includes the tetrahedron in the stack.
-	  t = tetra(i);	s.push(t);
-	  break;
-	}
+  vector<TEid> star;
+  Star_collector<TEid> f( star );
 
-  //while the stack isn't empty:
-  while( !s.empty() )
-  {
-    //picks the top tetrahedron.
-   	t = s.top();	s.pop();
-		
-	// If tetra was already visited, continue.
-	pair<set<int>::iterator,bool> status = sstar.insert(t);
-	if( !status.second ) continue;
-		
-    for( int i = t<<2; i<(t+1)<<2; ++i )
-	  if( V(i) ==  v )
-	  {
-	    neighbors( i, h1, h2, h3 );
+  if( !visit_R_03( v, f ) ) { star.push_back(INV); return star; }
 
- 	    //includes the neighboors tetrahedra in the stack 
- 	    h = O(h1) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-	    h = O(h2) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		h = O(h3) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		break;
-	  }
-  }
-	  
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
-   star.push_back( *iter );
-	  
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
   return star;
 }
 //--------------------------------------------------//
@@ -141,121 +55,27 @@ vector<Vid> CHF_L1::R_10(const Vid a, const Vid b)
 //--------------------------------------------------//
 /** Computes the vertices in the star of a given edge.*/
 {
-  set<Vid>   sstar;
   vector<Vid> star;
-	
-  pair<HFid, HFid>  start = make_pair(INV, INV), runcw = make_pair(INV, INV), runcc = make_pair(INV, INV);
-	
-  if( !v_valid(a) || !v_valid(b) || a == b) { star.push_back(INV); return star; }
-	
-  //Search the first edge
-  for(HFid i=0; i<4*ntetra(); ++i)
-  {
-    if((V(i) == a) && ( (V(nexthf(i)) == b) || (V(midhf(i)) == b) || (V(prevhf(i)) == b) ))
-	{
-	  HFid lives = 0;
-			
-	  if(V(nexthf(i)) != b &&  V(nexthe(nexthf(i), i).second) == b) lives = nexthf(i);
-	  else if(V(midhf(i))  != b &&  V(nexthe(midhf(i),  i).second) == b) lives = midhf(i); 
-	  else if(V(prevhf(i)) != b &&  V(nexthe(prevhf(i), i).second) == b) lives = prevhf(i); 
-				
-	  start  = runcw = make_pair(lives, i);
-	  runcc = matehe( start.first, start.second );
-	  break;
-	}
-  }
-
-  if(start == make_pair(INV, INV)) { star.push_back(INV);  return star; }
-
-  //Walk arround the edge --"Clockwise"
-  do
-  {
-    sstar.insert( V(runcw.first) );
-	runcw = matehe(runcw.first, runcw.second);
-	runcw = radialhe(runcw.first, runcw.second);
-  }
-  while((runcw.first != -1) && (runcw.first != start.first));
-
-  //if not 360
-  if(runcw.first == -1)
-  {
-    start  = runcc;
+  Star_collector<Vid> f( star );
 
-    //Walk arround the edge --"CounterClockwise"
-    do
-    {
-      sstar.insert( V(runcc.first) );
-	  runcc = matehe(runcc.first, runcc.second);
-	  runcc = radialhe( runcc.first, runcc.second);
-	}
-	while( runcc.first != -1 );
-  }
-	
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
-    star.push_back( *iter );
+  if( !visit_R_10( a, b, f ) ) { star.push_back(INV); return star; }
 
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
   return star;
 }
 //--------------------------------------------------//
 vector<TEid> CHF_L1::R_13(const Vid a, const Vid b)
 //--------------------------------------------------//
-/** Computes the vertices in the star of a given edge.*/
+/** Computes the tetrahedrons in the star of a given edge.*/
 {
-  set<TEid> sstar;
-  vector<TEid>   star;
-	
-  pair<HFid, HFid>  start, runcw, runcc;
-
-  if( !v_valid(a) || !v_valid(b) || a ==b) { star.push_back(INV); return star; }
-	
-  //Search the first edge
-  for(HFid i=0; i<4*ntetra(); ++i)
-  {
-    if((V(i) == a) && ( (V(nexthf(i)) == b) || (V(midhf(i)) == b) || (V(prevhf(i)) == b) ))
-	{		
-	  HFid lives = 0;
-	
-	  if(V(nexthf(i)) != b &&  V(nexthe(nexthf(i), i).second) == b) lives = nexthf(i);
-	  else if(V(midhf(i))  != b &&  V(nexthe(midhf(i),  i).second) == b) lives = midhf(i); 
-	  else if(V(prevhf(i)) != b &&  V(nexthe(prevhf(i), i).second) == b) lives = prevhf(i); 
-					
-	  start  = runcw = make_pair(lives, i);
-	  runcc = matehe( start.first, start.second );
-	  break;
-	}
-  }
-
-  if(start == make_pair(INV, INV)) { star.push_back(INV); return star; }
-	
-  //Walk arround the edge --"Clockwise"
-  do
-  {
-    sstar.insert( tetra(runcw.first) );
-	runcw = matehe(runcw.first, runcw.second);
-	runcw = radialhe(runcw.first, runcw.second);
-  }
-  while((runcw.first != -1) && (runcw.first != start.first));
-	
-  //if not 360
-  if(runcw.first == -1)
-  {
-    start  = runcc;
+  vector<TEid> star;
+  Star_collector<TEid> f( star );
 
-    //Walk arround the edge --"CounterClockwise"
-	do
-	{
-	  sstar.insert( tetra(runcc.first) );
-	  runcc = matehe(runcc.first, runcc.second);
-	  runcc = radialhe( runcc.first, runcc.second);
-	}
-	while( runcc.first != -1 );		
-  }
-	
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
-    star.push_back( *iter );
+  if( !visit_R_13( a, b, f ) ) { star.push_back(INV); return star; }
 
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
   return star;
 }
 //--------------------------------------------------//
@@ -277,9 +97,138 @@ vector<TEid> CHF_L1::R_33(const TEid t)
   return star;
 }
 //--------------------------------------------------//
+/** Face of a half-face: sorted vertices packed in a 64 or 96 bits key*/
+struct FaceKey
+//--------------------------------------------------//
+{
+  /** \brief a, b and c if the ids fit in 21 bits, otherwise a and b*/
+  unsigned long long k;
+  /** \brief c if the ids need more than 21 bits, otherwise 0*/
+  unsigned int       c;
+  /** \brief half-face of the face*/
+  HFid               h;
+
+  /** \brief Tests if two keys refer to the same face*/
+  inline bool operator == ( const FaceKey &f ) const { return k == f.k && c == f.c; }
+  /** \brief Hash of the face: the high bits give the partition, the low bits the slot*/
+  inline unsigned long long hash() const 
+  { 
+    unsigned long long x = (k ^ ((unsigned long long)c << 11)) * 0x9E3779B97F4A7C15ULL;
+    return x ^ (x >> 29);
+  }
+};
+//--------------------------------------------------//
 void CHF_L1::create_O()
 //--------------------------------------------------//
-/** Create adjacency relations between the tetrahedrons of the mesh*/
+/** Create adjacency relations between the tetrahedrons of the mesh.
+  * The half-faces are split in hash partitions so that both halves 
+  * of a face are in the same partition, and each thread matches its
+  * partitions with an open addressing table, in linear time.*/
+{
+  const HFid nhf = ntetra()<<2;
+  const bool pk  = nvert() <= (1<<21);
+  int        nth = 1;   /** threads of the team*/
+  int        np  = 8;
+
+  _O.clear();
+  _O.resize( nhf, -1 );
+
+  /** cnt[p*nth+t]: position of the half-faces of partition p in the chunk of thread t*/
+  vector<HFid>    cnt;
+  vector<FaceKey> buf;
+
+  #pragma omp parallel num_threads( par_nthreads() )
+  {
+    /** The chunks follow the threads granted, not the ones requested*/
+    #pragma omp single
+    {
+      nth = par_team_size();
+      np  = 8*nth;
+      cnt.assign( np*nth+1, 0 );
+    }
+
+    const int  t  = par_thread();
+    const HFid c0 = (HFid)( (long long)nhf* t   /nth );
+    const HFid c1 = (HFid)( (long long)nhf*(t+1)/nth );
+
+    FaceKey f;
+    Vid     a[3], tmp;
+
+    /** Counts and then scatters the keys of the chunk*/
+    for( int pass = 0 ; pass < 2 ; ++pass )
+    {
+      for( HFid h = c0 ; h < c1 ; ++h )
+      {
+        if( _V[h] == INV ) continue;
+
+        a[0] = _V[ (h&(~3)) | ((h+1)&3) ];
+        a[1] = _V[ (h&(~3)) | ((h+2)&3) ];
+        a[2] = _V[ (h&(~3)) | ((h+3)&3) ];
+        if( a[0] < 0 || a[1] < 0 || a[2] < 0 ) continue;
+
+        if( a[1] < a[0] ) { tmp = a[0]; a[0] = a[1]; a[1] = tmp; }
+        if( a[2] < a[1] ) { tmp = a[1]; a[1] = a[2]; a[2] = tmp; }
+        if( a[1] < a[0] ) { tmp = a[0]; a[0] = a[1]; a[1] = tmp; }
+
+        if( pk ) { f.k = ((unsigned long long)a[0] << 42) | ((unsigned long long)a[1] << 21) | (unsigned long long)a[2]; f.c = 0; }
+        else     { f.k = ((unsigned long long)a[0] << 32) | (unsigned long long)(unsigned int)a[1]; f.c = (unsigned int)a[2]; }
+        f.h = h;
+
+        int p = (int)( (f.hash() >> 40) % (unsigned long long)np );
+        if( pass == 0 ) ++cnt[ p*nth + t + 1 ];
+        else            buf[ cnt[ p*nth + t ]++ ] = f;
+      }
+
+      if( pass == 1 ) break;
+
+      #pragma omp barrier
+      #pragma omp single
+      {
+        for( int i = 0 ; i < np*nth ; ++i ) cnt[i+1] += cnt[i];
+        buf.resize( cnt[np*nth] );
+      }
+    }
+
+    #pragma omp barrier
+
+    /** Open addressing table of the thread: -1 empty, -2 matched*/
+    vector<HFid> table;
+
+    /** Matches each partition in the order of the half-faces, as the map does*/
+    #pragma omp for schedule(dynamic)
+    for( int p = 0 ; p < np ; ++p )
+    {
+      HFid b0 = (p == 0) ? 0 : cnt[p*nth-1];
+      HFid b1 = cnt[p*nth+nth-1];
+
+      unsigned int size = 16;
+      while( size < 2*(unsigned int)(b1-b0) ) size <<= 1;
+      if( table.size() < size ) table.resize( size );
+      fill( table.begin(), table.begin()+size, -1 );
+
+      for( HFid i = b0 ; i < b1 ; ++i )
+      {
+        unsigned int s = (unsigned int)buf[i].hash() & (size-1);
+        for( ;; s = (s+1) & (size-1) )
+        {
+          HFid e = table[s];
+          if( e == -1 ) { table[s] = i; break; }
+          if( e >= 0 && buf[e] == buf[i] )
+          {
+            _O[ buf[i].h ] = buf[e].h;
+            _O[ buf[e].h ] = buf[i].h;
+            table[s] = -2;
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+//--------------------------------------------------//
+void CHF_L1::create_O_map()
+//--------------------------------------------------//
+/** Create adjacency relations between the tetrahedrons of the mesh using a map*/
 {
   TEid t;
   HFid n, a[3];
@@ -390,54 +339,233 @@ const bool CHF_L1::orient_check(const HFid c,const HFid t)
     &&    V(prevhe(c, hc).second) == V(nexthe(t, ht).second);
 }
 //--------------------------------------------------//
+const bool CHF_L1::orient_negative(const TEid t)
+//--------------------------------------------------//
+/** Checks if a tetrahedron has a negative volume*/
+{
+  const Vertex &v0 = G( V(t<<2   ) );  const Vertex &v1 = G( V(t<<2 | 1) );
+  const Vertex &v2 = G( V(t<<2 | 2) );  const Vertex &v3 = G( V(t<<2 | 3) );
+
+  return Vertex::signed_tetra_volume(v0, v1, v2, v3) < 0 ;
+}
+//--------------------------------------------------//
 void CHF_L1::orient()
 //--------------------------------------------------//
-/** Orients the mesh coherently*/
+/** Orients each compound of the mesh coherently, from its first tetrahedron*/
 {
   if( ntetra() < 1 ) return ;
 
+  if( par_nthreads() > 1 ) { orient_parallel() ; return ; }
+
   /** Stack of half-faces to check*/
   stack<HFid> st ; 
   /** Vector of visited tetras*/
   vector<bool> visited ;  visited.resize( ntetra(), false ) ;
 
-  /** orient tetra 0*/
-  const Vertex &v0 = G( V(0) );  const Vertex &v1 = G( V(1) );
-  const Vertex &v2 = G( V(2) );  const Vertex &v3 = G( V(3) );
-
-  float test = Vertex::signed_tetra_volume(v0, v1, v2, v3);
+  TEid nflip = 0 ;
+  for( TEid r = 0 ; r < ntetra() ; ++r )
+  {
+    if( visited[r] ) continue ;
 
-  if( test < 0 ) change_orientation( 0 ) ;
+    /** orient the first tetra of the compound*/
+    if( orient_negative( r ) ) { change_orientation( r ) ; ++nflip ; }
 
-  /** push half faces of 0*/
-  st.push( 0 ) ;  st.push( 1 ) ;
-  st.push( 2 ) ;  st.push( 3 ) ;
-  visited[0] = true ;
+    /** push half faces of r*/
+    st.push( r<<2     ) ;  st.push( r<<2 | 1 ) ;
+    st.push( r<<2 | 2 ) ;  st.push( r<<2 | 3 ) ;
+    visited[r] = true ;
   
-  while( !st.empty() )
+    while( !st.empty() )
+    {
+      HFid hf = st.top() ;
+      st.pop() ;
+
+      /** avoid null face*/
+      HFid mf = O(hf) ;
+      if( mf < 0 )   continue ;
+
+      /** avoid loops*/
+      TEid t = tetra(mf) ;
+      if( visited[t] ) continue ;
+
+      /** repairs*/
+      if( !orient_check( hf,mf ) ) { change_orientation( t ) ; ++nflip ; }
+
+      /** marks as visited*/
+      visited[t] = true ;
+
+      /** push half faces of t*/
+      t <<= 2 ;
+      st.push(   t   ) ;  st.push( t | 1 ) ;
+      st.push( t | 2 ) ;  st.push( t | 3 ) ;
+    }
+  }
+  cout << "CHF_L1::orient: " << nflip << " tetrahedron(s) flipped." << endl;
+}
+//--------------------------------------------------//
+/** Root of the search a in the forest up, with the parity of a relative
+  * to its root in p. The path is compressed.*/
+static TEid orient_find( TEid *up, char *par, TEid a, char &p )
+//--------------------------------------------------//
+{
+  TEid r = a ;
+  p = 0 ;
+  while( up[r] != r ) { p ^= par[r] ; r = up[r] ; }
+
+  char q = p ;
+  while( up[a] != a )
+  {
+    TEid n = up[a] ;
+    char o = par[a] ;
+    up[a] = r ;  par[a] = q ;
+    q ^= o ;  a = n ;
+  }
+  return r ;
+}
+//--------------------------------------------------//
+void CHF_L1::orient_parallel()
+//--------------------------------------------------//
+/** Orients each compound of the mesh coherently, in parallel.
+  * Each tetrahedron not yet reached starts a breadth first search that
+  * claims its frontier by compare and swap and only records the parity
+  * of the tetrahedra; the searches that met are joined by a union-find
+  * with parity, and the flips are applied in one pass.*/
+{
+  const TEid nt = ntetra() ;
+  if( nt < 1 ) return ;
+
+  /** First tetrahedron of the search that reached each tetrahedron*/
+  vector<TEid> seed( nt, -1 ) ;
+  /** Parity of each tetrahedron relative to its seed, then its flip*/
+  vector<char> flip( nt, 0 ) ;
+  /** Smallest tetrahedron reached by each search (indexed by its seed)*/
+  vector<TEid> low ( nt, -1 ) ;
+  /** Half-faces shared by two searches, per thread*/
+  vector< vector<HFid> > cross( par_nthreads() ) ;
+
+  TEid *s = &seed[0] ;
+  char *f = &flip[0] ;
+
+  #pragma omp parallel
+  {
+    vector<TEid>  q ;
+    vector<HFid> &x = cross[ par_thread() ] ;
+
+    #pragma omp for schedule(dynamic,1024)
+    for( TEid r = 0 ; r < nt ; ++r )
+    {
+      if( !par_cas( s+r, -1, r ) ) continue ;
+
+      TEid m = r ;
+      q.clear() ;
+      q.push_back( r ) ;
+      for( size_t i = 0 ; i < q.size() ; ++i )
+      {
+        const TEid t = q[i] ;
+        if( t < m ) m = t ;
+
+        for( HFid h = t<<2 ; h < (t+1)<<2 ; ++h )
+        {
+          const HFid o = _O[h] ;
+          if( o < 0 ) continue ;
+
+          const TEid u = o>>2 ;
+          if( par_cas( s+u, -1, r ) )
+          {
+            f[u] = f[t] ^ !orient_check( h, o ) ;
+            q.push_back( u ) ;
+          }
+          else if( s[u] != r )
+            x.push_back( h ) ;
+        }
+      }
+      low[r] = m ;
+    }
+  }
+
+  /** joins the searches that met, with the parity of their seeds*/
+  vector<TEid> up ( nt, -1 ) ;
+  vector<char> par( nt, 0 ) ;
+  for( TEid r = 0 ; r < nt ; ++r )
+    if( s[r] == r ) up[r] = r ;
+
+  for( size_t k = 0 ; k < cross.size() ; ++k )
+    for( size_t i = 0 ; i < cross[k].size() ; ++i )
+    {
+      const HFid h = cross[k][i] ;
+      const HFid o = _O[h] ;
+
+      char pa, pb ;
+      TEid a = orient_find( &up[0], &par[0], s[h>>2], pa ) ;
+      TEid b = orient_find( &up[0], &par[0], s[o>>2], pb ) ;
+      if( a == b ) continue ;
+
+      const char p = pa ^ pb ^ f[h>>2] ^ f[o>>2] ^ !orient_check( h, o ) ;
+      if( a < b ) { up[b] = a ;  par[b] = p ; }
+      else        { up[a] = b ;  par[a] = p ; }
+    }
+  cross.clear() ;
+
+  /** the smallest tetrahedron of each compound gets a positive volume:
+    * each root keeps it in low and the parity of its seed in par*/
+  for( TEid r = 0 ; r < nt ; ++r )
   {
-    HFid hf = st.top() ;
-    st.pop() ;
+    if( s[r] != r ) continue ;
 
-    /** avoid null face*/
-    HFid mf = O(hf) ;
-    if( mf == -1 )   continue ;
+    char p ;
+    TEid a = orient_find( &up[0], &par[0], r, p ) ;
+    if( a == r ) continue ;
 
-    /** avoid loops*/
-    TEid t = tetra(mf) ;
-    if( visited[t] ) continue ;
+    if( low[r] < low[a] ) { low[a] = low[r] ;  par[a] = p ; }
+  }
+  for( TEid r = 0 ; r < nt ; ++r )
+    if( s[r] == r && up[r] == r ) par[r] ^= f[ low[r] ] ^ orient_negative( low[r] ) ;
 
-    /** repairs*/
-    if( !orient_check( hf,mf ) ) change_orientation( t ) ;
+  /** flip of each seed*/
+  for( TEid r = 0 ; r < nt ; ++r )
+  {
+    if( s[r] != r || up[r] == r ) continue ;
+    char p ;
+    TEid a = orient_find( &up[0], &par[0], r, p ) ;
+    low[r] = p ^ par[a] ;
+  }
+  for( TEid r = 0 ; r < nt ; ++r )
+    if( s[r] == r && up[r] == r ) low[r] = par[r] ;
+
+  TEid nflip = 0 ;
+  #pragma omp parallel for reduction(+:nflip)
+  for( TEid t = 0 ; t < nt ; ++t )
+  {
+    f[t] ^= (char)low[ s[t] ] ;
+    nflip += f[t] ;
+  }
+  up.clear() ;  par.clear() ;  low.clear() ;
 
-    /** marks as visited*/
-    visited[t] = true ;
+  /** applies the flips: the vertices 1 and 2 of a flipped tetrahedron
+    * are exchanged, and so are its half-faces 1 and 2*/
+  if( nflip > 0 )
+  {
+    #pragma omp parallel for
+    for( TEid t = 0 ; t < nt ; ++t )
+    {
+      HFid o[4] ;
+      for( int j = 0 ; j < 4 ; ++j )
+      {
+        const HFid h = _O[t<<2 | j] ;
+        o[j] = ( h >= 0 && f[h>>2] && ( h&3 ) && ( h&3 ) < 3 ) ? h ^ 3 : h ;
+      }
 
-    /** push half faces of t*/
-    t <<= 2 ;
-    st.push(   t   ) ;  st.push( t | 1 ) ;
-    st.push( t | 2 ) ;  st.push( t | 3 ) ;
+      if( f[t] )
+      {
+        Vid v = _V[t<<2 | 1] ;  _V[t<<2 | 1] = _V[t<<2 | 2] ;  _V[t<<2 | 2] = v ;
+        HFid m = o[1] ;  o[1] = o[2] ;  o[2] = m ;
+      }
+      for( int j = 0 ; j < 4 ; ++j ) _O[t<<2 | j] = o[j] ;
+    }
+    _HI.clear() ;
   }
+
+  cout << "CHF_L1::orient: " << nflip << " tetrahedron(s) flipped." << endl;
 }
 //--------------------------------------------------//
 void CHF_L1::check()
@@ -580,3 +708,46 @@ void CHF_L1::draw_smooth(const int t)
   glEnd();
 }
 //--------------------------------------------------------------//
+void CHF_L1::write_tables( Snapshot_writer &w ) const
+//--------------------------------------------------------------//
+{
+  CHF_L0::write_tables( w );
+  w.add( "O", _O );
+}
+//--------------------------------------------------------------//
+bool CHF_L1::read_tables( const Snapshot_reader &r )
+//--------------------------------------------------------------//
+{
+  return CHF_L0::read_tables( r ) && r.get( "O", _O ) && (HFid)_O.size() == 4*ntetra();
+}
+//--------------------------------------------------------------//
+void CHF_L1::remap( const vector<Vid> &vnew, const vector<TEid> &tnew )
+//--------------------------------------------------------------//
+{
+  CHF_L0::remap( vnew, tnew );
+
+  // the opposites of the dropped half-faces become boundary
+  vector<HFid> O( 4*ntetra() );
+  #pragma omp parallel for schedule(static)
+  for( HFid h=0; h<(HFid)_O.size(); ++h )
+  {
+    const HFid n = remap_hf( h, tnew );
+    if( n >= 0 ) O[n] = remap_hf( _O[h], tnew );
+  }
+  _O.swap( O );
+}
+//--------------------------------------------------------------//
+void CHF_L1::take( CHF_L1 &c )
+//--------------------------------------------------------------//
+{
+  CHF_L0::take( c );
+  _O.swap( c._O );  c._O.clear();
+}
+//--------------------------------------------------------------//
+void CHF_L1::clear()
+//--------------------------------------------------------------//
+{
+  CHF_L0::clear();
+  _O.clear();
+}
+//--------------------------------------------------------------//
@@ -18,10 +18,128 @@
 #include <ctime>
 #include <algorithm>
 #include "CHF_L0.hpp"
+#include "../common/Parallel.hpp"
 
 /** \brief standart namespace definiton*/
 using namespace std;
 //--------------------------------------------------//
+/** Scratch memory of the star traversals
+  * \brief Visited marks are stamped with a generation number, 
+  * so starting a new query costs nothing: the marks are 
+  * cleared only when the generation wraps around. The stack 
+  * keeps its capacity between queries.*/
+struct Star_scratch
+//--------------------------------------------------//
+{
+  /** \brief Generation of each tetrahedron*/
+  vector<unsigned int> tmark;
+  /** \brief Generation of each vertex*/
+  vector<unsigned int> vmark;
+  /** \brief Tetrahedra still to visit*/
+  vector<TEid>         stack;
+  /** \brief Current generation*/
+  unsigned int         gen;
+
+  /** \brief Default constructor.*/
+  Star_scratch() : gen(0) {}
+
+  /** \brief Starts a new query on a mesh
+    * \param nt - const int number of tetrahedra
+    * \param nv - const int number of vertices */
+  inline void begin( const int nt, const int nv )
+  {
+    if( (int)tmark.size() < nt ) tmark.resize( nt, 0 );
+    if( (int)vmark.size() < nv ) vmark.resize( nv, 0 );
+    if( ++gen == 0 ) 
+    { 
+      fill( tmark.begin(), tmark.end(), 0u ); 
+      fill( vmark.begin(), vmark.end(), 0u ); 
+      gen = 1; 
+    }
+    stack.clear();
+  }
+  /** \brief Marks a tetrahedron, false if it was already marked
+    * \param t - const TEid */
+  inline bool mark_t( const TEid t ) { if( tmark[t] == gen ) return false; tmark[t] = gen; return true; }
+  /** \brief Marks a vertex, false if it was already marked
+    * \param v - const Vid */
+  inline bool mark_v( const Vid  v ) { if( vmark[v] == gen ) return false; vmark[v] = gen; return true; }
+};
+//--------------------------------------------------//
+/** Scratch of the star traversals of a mesh, one per thread
+  * \brief The table of the scratches is sized for all the threads 
+  * of a region on the first query, and read without locking: only 
+  * the creation of a scratch takes the lock. A table that grows is 
+  * replaced, not resized in place, and kept until the pool is 
+  * destroyed, so a thread reading the previous one still finds its 
+  * scratch there. Copies of the pool start empty.*/
+struct Star_scratch_pool
+//--------------------------------------------------//
+{
+  /** \brief Scratch of each thread id*/
+  vector<Star_scratch*> *pool;
+  /** \brief Tables replaced by a growth*/
+  vector< vector<Star_scratch*>* > old;
+
+  /** \brief Default constructor.*/
+  Star_scratch_pool() : pool(0) {}
+  /** \brief Copy constructor: the scratch is not shared.*/
+  Star_scratch_pool( const Star_scratch_pool & ) : pool(0) {}
+  /** \brief Assignment: the scratch is not shared.*/
+  Star_scratch_pool &operator=( const Star_scratch_pool & ) { return *this; }
+  /** \brief Destructor.*/
+  ~Star_scratch_pool()
+  {
+    if( pool ) for( int i=0; i<(int)pool->size(); ++i ) delete (*pool)[i];
+    delete pool;
+    for( int i=0; i<(int)old.size(); ++i ) delete old[i];
+  }
+
+  /** \brief Scratch of a thread id, created if needed
+    * \param i - const int  par_thread_id() of the caller*/
+  inline Star_scratch &get( const int i )
+  {
+    const vector<Star_scratch*> *p = pool;
+    if( p && i < (int)p->size() && (*p)[i] ) return *(*p)[i];
+    return create( i );
+  }
+
+  /** \brief Creates the scratch of a thread id, under the lock
+    * \param i - const int  par_thread_id() of the caller*/
+  Star_scratch &create( const int i )
+  {
+    Star_scratch *s;
+    #pragma omp critical(star_scratch_pool)
+    {
+      if( !pool || i >= (int)pool->size() )
+      {
+        const int n = max( i+1, max( par_nthreads(), pool ? 2*(int)pool->size() : 0 ) );
+        vector<Star_scratch*> *p = new vector<Star_scratch*>( n, (Star_scratch*)0 );
+        if( pool ) { copy( pool->begin(), pool->end(), p->begin() ); old.push_back( pool ); }
+        pool = p;
+      }
+      if( !(*pool)[i] ) (*pool)[i] = new Star_scratch;
+      s = (*pool)[i];
+    }
+    return *s;
+  }
+};
+//--------------------------------------------------//
+/** Star visitor that appends the visited ids to a vector
+  * \brief Used by the vector R_* queries*/
+template <class T> struct Star_collector
+//--------------------------------------------------//
+{
+  /** \brief Output vector*/
+  vector<T> &star;
+  /** \brief Constructor 
+    * \param s - vector<T>& */
+  Star_collector( vector<T> &s ) : star(s) {}
+  /** \brief Visits an element 
+    * \param x - const T */
+  inline void operator()( const T x ) { star.push_back(x); }
+};
+//--------------------------------------------------//
 /** CHF data-structure for tetrahedral meshes
   * \brief CHF: Level 1*/
 class CHF_L1:public CHF_L0 
@@ -32,6 +150,9 @@ protected:
   /** \brief Opposite container */
   vector<HFid> _O;
 
+  /** \brief Star traversal scratch, one per thread */
+  mutable Star_scratch_pool _scr;
+
 public:
   /** \brief Default constructor.*/
   CHF_L1():CHF_L0() {}
@@ -45,6 +166,12 @@ public:
     * \param h  -  const CHF_L1 object.*/
   CHF_L1(const CHF_L1& h): CHF_L0(h) { _O=h._O; }
 
+  /** \brief Promotion constructor: takes the tables of a level 0
+    * structure without copying them (h is left empty) and computes
+    * the opposites and the normals, as read_ply does after loading.
+    * \param h  -  CHF_L0 object.*/
+  explicit CHF_L1(CHF_L0& h): CHF_L0() { CHF_L0::take( h ); create_O(); CHF_L1::compute_normals(); }
+
   /** \brief Destructor.*/
   ~CHF_L1() { _O.clear(); }
 
@@ -107,8 +234,165 @@ public:
     * \param r - const TEid */
   virtual vector<TEid> R_33( const TEid t );
 
+public:
+  /** \brief Visits the vertices in the star of a vertex, each once
+    * (allocation free once the scratch is warm). False if v is invalid.
+    * \param v - const Vid  
+    * \param f - F& functor called with each Vid */
+  template <class F> inline bool visit_R_00( const Vid v, F &f ) const { return flood_R_0( v, first_tetra(v), f, true ); }
+  /** \brief Visits the tetrahedra in the star of a vertex 
+    * \param v - const Vid  
+    * \param f - F& functor called with each TEid */
+  template <class F> inline bool visit_R_03( const Vid v, F &f ) const { return flood_R_0( v, first_tetra(v), f, false ); }
+  /** \brief Visits the vertices in the star of an edge 
+    * \param a - const Vid  
+    * \param b - const Vid  
+    * \param f - F& functor called with each Vid */
+  template <class F> inline bool visit_R_10( const Vid a, const Vid b, F &f ) const { return radial_R_1( a, b, first_face(a,b), f, true ); }
+  /** \brief Visits the tetrahedra in the star of an edge 
+    * \param a - const Vid  
+    * \param b - const Vid  
+    * \param f - F& functor called with each TEid */
+  template <class F> inline bool visit_R_13( const Vid a, const Vid b, F &f ) const { return radial_R_1( a, b, first_face(a,b), f, false ); }
+
+protected:
+  /** \brief Scratch of the calling thread, or local when the
+    * thread has no unique id (nested parallel regions)
+    * \param local - Star_scratch&  scratch of the caller's frame*/
+  inline Star_scratch &scratch( Star_scratch &local ) const 
+  { 
+    const int i = par_thread_id(); 
+    return i < 0 ? local : _scr.get( i ); 
+  }
+
+  /** \brief First tetrahedron containing a vertex (linear search at this level)
+    * \param v - const Vid */
+  inline TEid first_tetra( const Vid v ) const
+  {
+    if( !v_valid(v) ) return INV;
+    for( HFid i=0; i<ntetra()<<2; ++i ) if( _V[i] == v && _O[i] != INV ) return i>>2;
+    return INV;
+  }
+  /** \brief First half-face containing the edge (a,b) and turning from a to b
+    * (linear search at this level)
+    * \param a - const Vid  
+    * \param b - const Vid */
+  inline HFid first_face( const Vid a, const Vid b ) const
+  {
+    if( !v_valid(a) || !v_valid(b) || a == b ) return INV;
+    for( HFid i=0; i<4*ntetra(); ++i )
+    {
+      if( V(i) != a || ( V(nexthf(i)) != b && V(midhf(i)) != b && V(prevhf(i)) != b ) ) continue;
+      if( V(nexthf(i)) != b && V(nexthe(nexthf(i), i).second) == b ) return nexthf(i);
+      if( V(midhf(i))  != b && V(nexthe(midhf(i),  i).second) == b ) return midhf(i);
+      if( V(prevhf(i)) != b && V(nexthe(prevhf(i), i).second) == b ) return prevhf(i);
+      return INV;
+    }
+    return INV;
+  }
+
+  /** \brief Flood fill of the tetrahedra around v, starting from t0
+    * \param v  - const Vid   
+    * \param t0 - const TEid  
+    * \param f  - F& functor
+    * \param vert - const bool visits the vertices if true, the tetrahedra otherwise */
+  template <class F> bool flood_R_0( const Vid v, const TEid t0, F &f, const bool vert ) const
+  {
+    if( t0 < 0 ) return false;
+
+    Star_scratch local, &s = scratch( local );
+    s.begin( ntetra(), nvert() );
+    s.mark_v( v );
+    s.stack.push_back( t0 );
+
+    HFid h1 = 0, h2 = 0, h3 = 0;
+    while( !s.stack.empty() )
+    {
+      const TEid t = s.stack.back(); s.stack.pop_back();
+      if( !s.mark_t(t) ) continue;
+      if( !vert ) f( t );
+
+      for( HFid i = t<<2; i<(t+1)<<2; ++i )
+      {
+        if( _V[i] != v ) continue;
+        neighbors( i, h1, h2, h3 );
+        if( vert )
+        {
+          if( s.mark_v( _V[h1] ) ) f( _V[h1] );
+          if( s.mark_v( _V[h2] ) ) f( _V[h2] );
+          if( s.mark_v( _V[h3] ) ) f( _V[h3] );
+        }
+        HFid h = _O[h1]; if( h >= 0 && s.tmark[h>>2] != s.gen ) s.stack.push_back( h>>2 );
+             h = _O[h2]; if( h >= 0 && s.tmark[h>>2] != s.gen ) s.stack.push_back( h>>2 );
+             h = _O[h3]; if( h >= 0 && s.tmark[h>>2] != s.gen ) s.stack.push_back( h>>2 );
+        break;
+      }
+    }
+    return true;
+  }
+
+  /** \brief Radial walk around the edge (a,b), from the half-face 
+    * lives containing it: clockwise until it closes, 
+    * counterclockwise if it hits the boundary
+    * \param a     - const Vid   
+    * \param b     - const Vid   
+    * \param lives - const HFid half-face containing (a,b)
+    * \param f     - F& functor
+    * \param vert  - const bool visits the vertices if true, the tetrahedra otherwise */
+  template <class F> bool radial_R_1( const Vid a, const Vid b, const HFid lives, F &f, const bool vert ) const
+  {
+    if( lives < 0 ) return false;
+
+    HFid hf0 = 0, hf1 = 0, hf2 = 0;
+    neighbors( lives, hf0, hf1, hf2 );
+
+    // the half-edge (lives, he) goes from V(he) to V(nexthe(lives,he)): 
+    // starts from a->b, or from b->a when lives turns the other way
+    pair<HFid, HFid> start = make_pair(INV, INV), run;
+    const HFid hs[3] = { hf0, hf1, hf2 };
+    for( int k=0; k<3 && start.first == INV; ++k )
+    {
+      const Vid u = V(hs[k]);
+      if( (u == a && V(nexthe(lives, hs[k]).second) == b) || 
+          (u == b && V(nexthe(lives, hs[k]).second) == a) ) start = make_pair(lives, hs[k]);
+    }
+    if( start.first == INV ) return false;
+
+    Star_scratch local, &s = scratch( local );
+    s.begin( ntetra(), nvert() );
+
+    //Walk arround the edge --"Clockwise"
+    run = start;
+    do
+    {
+      if( vert ) { if( s.mark_v( V(run.first) ) ) f( V(run.first) ); }
+      else       { if( s.mark_t( run.first>>2 ) ) f( run.first>>2 ); }
+      run = matehe(run.first, run.second);
+      run = radialhe(run.first, run.second);
+    }
+    while( (run.first >= 0) && (run.first != start.first) );
+
+    if( run.first >= 0 ) return true;
+
+    //Walk arround the edge --"CounterClockwise"
+    run = matehe( start.first, start.second );
+    do
+    {
+      if( vert ) { if( s.mark_v( V(run.first) ) ) f( V(run.first) ); }
+      else       { if( s.mark_t( run.first>>2 ) ) f( run.first>>2 ); }
+      run = matehe(run.first, run.second);
+      run = radialhe(run.first, run.second);
+    }
+    while( run.first >= 0 );
+
+    return true;
+  }
+
+public:
   /** \brief creates the O table. */
   void create_O();
+  /** \brief creates the O table with a map of the unmatched faces (reference implementation). */
+  void create_O_map();
 
   /** \brief Computes bound faces' normal.*/  
   virtual void compute_normals();
@@ -118,18 +402,32 @@ protected:
     * \param t - TEid */
   void change_orientation(TEid t) ;
 
+  /** \brief Checks if a tetrahedron has a negative volume
+    * \param t - const TEid */
+  const bool orient_negative(const TEid t) ;
+
 public:
   /** \brief Checks the orientation beetwen two tetrahedrons. 
     * \param c - HFid 
     * \param t - HFid  */
   const bool orient_check(const HFid c, const HFid t) ;
 
-  /** \brief Orients the mesh.*/  
+  /** \brief Orients each compound of the mesh, with a positive volume
+    * for its first tetrahedron.*/  
   void  orient();
 
+  /** \brief Orients each compound of the mesh in parallel: breadth first
+    * searches from several tetrahedra of a compound record the parity of
+    * each tetrahedron, are joined by a union-find with parity, and the
+    * flips are applied in one pass.*/  
+  void  orient_parallel();
+
   /** \brief Checks mesh validation*/
   void   check(); 
 
+  /** \brief Empties the structure*/
+  virtual void clear();
+
 public:
   /** \brief Draws the bound surface of the mesh. 
     * \param t= 0 - const int*/
@@ -155,5 +453,24 @@ public:
 
     // cout << "L1 load time:" << static_cast<double>(L1_time-start_time)/static_cast<double>(CLOCKS_PER_SEC) << endl;
   }
+
+protected:
+  /** \brief Level of the structure, stored in the snapshots*/
+  virtual const int snapshot_level() const { return 1; }
+  /** \brief Adds the tables of the level to a snapshot
+    * \param w - Snapshot_writer& */
+  virtual void write_tables ( Snapshot_writer &w ) const;
+  /** \brief Reads the tables of the level from a snapshot
+    * \param r - const Snapshot_reader& */
+  virtual bool read_tables ( const Snapshot_reader &r );
+
+  /** \brief Applies a permutation of the vertices and of the tetrahedra
+    * to the tables of the level
+    * \param vnew - const vector<Vid>&
+    * \param tnew - const vector<TEid>& */
+  virtual void remap ( const vector<Vid> &vnew, const vector<TEid> &tnew );
+  /** \brief Takes the tables of c, which is left empty
+    * \param c - CHF_L1& */
+  void take ( CHF_L1 &c );
 };
 #endif
@@ -17,6 +17,7 @@
 #include <GL/glut.h>
 
 #include "CHF_L2.hpp"    /**< Level 1 inheritance*/
+#include "../common/Snapshot.hpp" /**< Binary snapshots*/
 #include "colorramp.h"	 /**< Gl color maps*/
 												 
 using namespace std;
@@ -25,105 +26,29 @@ vector<Vid> CHF_L2::R_00(const Vid v)
 //--------------------------------------------------//
 /** Computes the vertices in the star of a vertex.*/
 {
-  TEid t  = 0;
-  HFid h = 0,  h1 = 0,  h2 = 0,  h3 = 0;
-
-  stack<TEid> s;
-	
-  // vertex star.
-  set<Vid> sstar;
-  vector<Vid>  star;
- 	
-  // visited tetrahedra.
-  set<TEid> tet;
-
-  // Tests if the vertex v is valid.
-  if( !v_valid(v) ) {	star.push_back(INV); return star; }
-
-  // Finds the first tetrahedron that contains v.
-  t = tetra( VH(v) );	s.push(t);
-	
-  // while the stack isn't empty:
-  while( !s.empty() )
-  {
-    // picks the top tetrahedron.
-    t = s.top();	s.pop();
-			
-	// If tetra was already visited, continue.
-	pair<set<int>::iterator,bool> status = tet.insert(t);
-	if( !status.second ) continue;
-			
-	for( int i = t<<2; i<(t+1)<<2; ++i )
-	  if( V(i) ==  v )
-	  {
-	 	neighbors( i, h1, h2, h3 );
-				
-	  	// insert the vertex in the star
-		sstar.insert( V(h1) );
-		sstar.insert( V(h2) );
-		sstar.insert( V(h3) );
-		
-		//includes the neighboors tetrahedra in the stack 
-		h = O(h1) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		h = O(h2) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		h = O(h3) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		break;
-	  }
-  }
-	
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
-    star.push_back( *iter );
- 	
-  return star; 
+  vector<Vid> star;
+  Star_collector<Vid> f( star );
+
+  need_VH();
+  if( !visit_R_00( v, f ) ) { star.push_back(INV); return star; }
+
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
+  return star;
 }
 //--------------------------------------------------//
 vector<TEid> CHF_L2::R_03(const Vid v)
 //--------------------------------------------------//
 /** Computes the tetrahedrons in the star of a vertex.*/
 {
-  TEid  t = 0;
-  HFid h = 0,  h1 = 0,  h2 = 0,  h3 = 0;
-
-  stack<TEid> s;
-  
-  // Vertex star
-  set<TEid> sstar;
-  vector<TEid>  star;
- 
-  //Tests if the vertex v is valid.
-  if( !v_valid(v) ) {	star.push_back(INV); return star;	}
-
-  // Finds the first tetrahedron that contains v.
-  t = tetra( VH(v) );	s.push(t);
-
-  //while the stack isn't empty:
-  while( !s.empty() )
-  {
-	//picks the top tetrahedron.
-    t = s.top();	s.pop();
-		
-	// If tetra was already visited, continue.
-	pair<set<int>::iterator,bool> status = sstar.insert(t);
-	if( !status.second ) continue;
-		
-   	for( int i = t<<2; i<(t+1)<<2; ++i )
-   	  if( V(i) ==  v )
-	  {
-	    neighbors( i, h1, h2, h3 );
+  vector<TEid> star;
+  Star_collector<TEid> f( star );
 
- 		//includes the neighboors tetrahedra in the stack 
- 		h = O(h1) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		h = O(h2) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		h = O(h3) ; if( hf_valid(h) ) s.push( tetra(h) ) ;
-		break;
-	  }
-  }
-	  
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
-	 star.push_back( *iter );
+  need_VH();
+  if( !visit_R_03( v, f ) ) { star.push_back(INV); return star; }
 
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
   return star;
 }
 //--------------------------------------------------//
@@ -131,95 +56,33 @@ vector<Vid> CHF_L2::R_10(const Vid a, const Vid b)
 //--------------------------------------------------//
 /** Computes the vertices in the star of a given edge.*/
 {
-  Eit pos;
-  set<Vid> sstar;
-  vector<Vid>   star;
-	
-  pair<HFid, HFid>  start, runcw;
-	
-  if( !v_valid(a) || !v_valid(b) || a ==b) { star.push_back(INV); return star; }
-	
-  //Gets the first edge
-  Vid A = a, B =b;
-  if(b<a) { Vid tmp= A; A=B; B=tmp; }
-  pos = _EH.find(make_pair(A,B));
-	
-  if(pos == _EH.end()) {
-    star.push_back(INV);
-    return star;
-  }
-	
-  HFid lives = pos->second, hf0 = 0, hf1 = 0, hf2 = 0;
-  neighbors(lives, hf0, hf1, hf2);
-	
-  if      (V(hf0) == a) start  = runcw = make_pair(lives, hf0);
-  else if (V(hf1) == a) start  = runcw = make_pair(lives, hf1);
-  else if (V(hf2) == a)	start  = runcw = make_pair(lives, hf2);
-	
-  //Walk arround the edge --"Clockwise"
-  do
-  {
-    sstar.insert( V(runcw.first) );
-	runcw = matehe(runcw.first, runcw.second);
-	runcw = radialhe(runcw.first, runcw.second);
-  }
-  while((runcw.first != -1) && (runcw.first != start.first));
+  vector<Vid> star;
+  Star_collector<Vid> f( star );
 
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
- 	 star.push_back( *iter );
+  need_EH();
+  if( !visit_R_10( a, b, f ) ) { star.push_back(INV); return star; }
 
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
   return star;
 }
 //--------------------------------------------------//
 vector<TEid> CHF_L2::R_13(const Vid a, const Vid b)
 //--------------------------------------------------//
-/** Computes the vertices in the star of a given edge.*/
+/** Computes the tetrahedrons in the star of a given edge.*/
 {
-  Eit pos;
-
-  set<TEid> sstar;
-  vector<TEid>   star;
-	
-  pair<HFid, HFid>  start, runcw;
-	
-  if( !v_valid(a) || !v_valid(b) || a ==b) { star.push_back(INV); return star; }
-	
-  //Gets the first edge
-  Vid A = a, B =b;
-  if(b<a) { Vid tmp= A; A=B; B=tmp; }
-    pos = _EH.find(make_pair(A,B));
-	
-  if(pos == _EH.end()) 
-  {
-	star.push_back(INV);
-	return star;
-  }
-	
-  HFid lives = pos->second, hf0 = 0, hf1 = 0, hf2 = 0;
-  neighbors(lives, hf0, hf1, hf2);
-	
-  if      (V(hf0) == a) start  = runcw = make_pair(lives, hf0);
-  else if (V(hf1) == a) start  = runcw = make_pair(lives, hf1);
-  else if (V(hf2) == a)	start  = runcw = make_pair(lives, hf2);
-	
-  //Walk arround the edge --"Clockwise"
-  do
-  {
-    sstar.insert( tetra(runcw.first) );
-	runcw = matehe(runcw.first, runcw.second);
-	runcw = radialhe(runcw.first, runcw.second);
-  }
-  while((runcw.first != -1) && (runcw.first != start.first));
+  vector<TEid> star;
+  Star_collector<TEid> f( star );
 
-  // Copies in star
-  for(set<Vid>::const_iterator iter = sstar.begin(); iter != sstar.end(); ++iter )
-    star.push_back( *iter );
+  need_EH();
+  if( !visit_R_13( a, b, f ) ) { star.push_back(INV); return star; }
 
+  // sorted, as the former set based version
+  sort( star.begin(), star.end() );
   return star;
 }
 //--------------------------------------------------//
-void CHF_L2::create_VH()
+void CHF_L2::create_VH() const
 //--------------------------------------------------//
 /** Creates the "half-face of a vertex" container */
 {
@@ -230,102 +93,132 @@ void CHF_L2::create_VH()
   {
 	HFid hf1 = 0,  hf2 = 0,  hf3 = 0;
 	neighbors(i, hf1, hf2, hf3);
-	if( O(i) == -1 )
-	{
-   	  set_VH( V(hf1), i );
-	  set_VH( V(hf2), i );
-	  set_VH( V(hf3), i );
-	 }
-	else
+	const Vid v[3] = { V(hf1), V(hf2), V(hf3) };
+	for( int k=0; k< 3; ++k )
 	{
-      if( VH( V(hf1) ) == -1 ) set_VH( V(hf1), i );
-      if( VH( V(hf2) ) == -1 ) set_VH( V(hf2), i );
-      if( VH( V(hf3) ) == -1 ) set_VH( V(hf3), i );
+	  if( !v_valid( v[k] ) ) continue;
+	  if( O(i) == -1 || _VH[ v[k] ] == -1 ) _VH[ v[k] ] = i;
 	}
   }
   cout << "CHF_L3::create_VH: " << (unsigned)_VH.size() << " vertices found." << endl;
 }
 //--------------------------------------------------//
-void CHF_L2::create_EH()
+void CHF_L2::create_EH() const
 //--------------------------------------------------//
-/** Creates the "half-face of a edge" map */
+/** Creates the edge rows: every tetrahedron lists its 6 edges 
+  * in the row of their smallest vertex, each row is sorted and 
+  * the repeated edges are merged. The half-face of an edge is 
+  * chosen as before: a boundary half-face turning from a to b 
+  * when there is one, the first one found otherwise. */
 {
-  Eit pos;
-  Vid   a, b;
-  HFid ha, hb;
-
   static const char comb1[6] = { 0,0,0,1,1,2 } ;
   static const char comb2[6] = { 1,2,3,2,3,3 } ;
 
-  _EH.clear();
+  _EO.clear();
+  _EB.clear();
+  _EF.clear();
+  _EO.resize( nvert()+1, 0 );
 
+  // counts the edge occurrences of each row
+  vector<int> pos( nvert()+1, 0 );
   for( TEid t=0; t< ntetra(); ++t)
   {
     if( !te_valid(t) ) continue;
-		
-	TEid te = t << 2; 
-	for( Vid i=0; i< 6; ++i )
+
+	HFid te = t << 2;
+	for( int i=0; i< 6; ++i )
 	{
-	  ha = te | comb1[i] ;
-	  hb = te | comb2[i] ;
-			
-	  a= V( ha ) ;
-	  b= V( hb ) ;
-			
-	  if(b<a)
-	  { 
-	    Vid     tmp= a; a=b; b=tmp; 
-	    HFid  htmp= ha; ha=hb; hb = htmp;
+	  Vid a = V( te | comb1[i] ), b = V( te | comb2[i] );
+	  ++pos[ (a<b ? a : b) + 1 ];
+	}
+  }
+  for( Vid v=0; v< nvert(); ++v ) pos[v+1] += pos[v];
+
+  // scatters the occurrences (other vertex, 6*tetrahedron + edge) in tetrahedron order
+  vector< pair<Vid,int> > occ( pos[nvert()] );
+  {
+    vector<int> fill( pos.begin(), pos.end()-1 );
+    for( TEid t=0; t< ntetra(); ++t)
+    {
+      if( !te_valid(t) ) continue;
+
+	  HFid te = t << 2;
+	  for( int i=0; i< 6; ++i )
+	  {
+	    Vid a = V( te | comb1[i] ), b = V( te | comb2[i] );
+	    if( b < a ) { Vid tmp = a; a = b; b = tmp; }
+	    occ[ fill[a]++ ] = make_pair( b, 6*t+i );
 	  }
+    }
+  }
 
-      pos = _EH.find( Eid(a,b) );
-			
-	  if( pos == _EH.end() )
+  // sorts each row and counts its edges
+  const int nv = nvert();
+#pragma omp parallel for schedule(dynamic,256)
+  for( int a=0; a< nv; ++a )
+  {
+    sort( occ.begin()+pos[a], occ.begin()+pos[a+1] );
+    int n = 0;
+    for( int k=pos[a]; k< pos[a+1]; ++k ) if( k == pos[a] || occ[k].first != occ[k-1].first ) ++n;
+    _EO[a+1] = n;
+  }
+  for( Vid v=0; v< nvert(); ++v ) _EO[v+1] += _EO[v];
+
+  _EB.resize( _EO[nvert()] );
+  _EF.resize( _EO[nvert()] );
+
+  // merges the repeated edges of each row
+#pragma omp parallel for schedule(dynamic,256)
+  for( int a=0; a< nv; ++a )
+  {
+    int e = _EO[a] - 1;
+    for( int k=pos[a]; k< pos[a+1]; ++k )
+	{
+	  const Vid  b  = occ[k].first;
+	  const HFid te = (occ[k].second / 6) << 2;
+	  const int  i  = occ[k].second % 6;
+
+	  HFid ha = te | comb1[i];
+	  if( V(ha) != a ) ha = te | comb2[i];
+
+	  if( k == pos[a] || b != occ[k-1].first )
 	  {
-      	HFid hf = te | comb1[5-i];
+	    ++e;
+		HFid hf = te | comb1[5-i];
 		if( O(hf) != -1 ) 
 		{
 		  HFid hftmp = te | comb2[5-i];
 		  if(O(hftmp) == -1 && V(nexthe(hftmp, ha).second) == b)
 		  hf =hftmp;
 		}
-
-		_EH.insert( make_pair( Eid(a,b), hf ) );
+	    _EB[e] = b;
+		_EF[e] = hf;
 	  }
-	  else if ( O(pos->second) != -1)
+	  else if ( O(_EF[e]) != -1)
 	  {
 	    HFid hf = te | comb1[5-i] ;
-		if( O( hf ) == -1 && V(nexthe(hf, ha).second) == b) pos->second = hf ;
+		if( O( hf ) == -1 && V(nexthe(hf, ha).second) == b) _EF[e] = hf ;
 		else
 		{
 		  hf = te | comb2[5-i] ;
-		  if( O( hf ) == -1 && V(nexthe(hf, ha).second) == b) pos->second = hf;
+		  if( O( hf ) == -1 && V(nexthe(hf, ha).second) == b) _EF[e] = hf;
 		}
 	  }
 	}
   }
-  cout << "CHF_L3::create_EH: " << (unsigned)_EH.size() << " edges found." << endl;
+  cout << "CHF_L3::create_EH: " << (unsigned)nedge() << " edges found." << endl;
 }
 //--------------------------------------------------//
 void CHF_L2::create_FH()
 //--------------------------------------------------//
+/** Counts the faces: they are implicit in the opposite table */
 {
-  _FH.clear();
+  _nface = 0;
 
   for(HFid i=0; i<4*ntetra(); ++i)
-  {
-	HFid hf0 = i;
-    HFid hf1 = O(i);
+    if( f_valid(i) ) ++_nface;
 
-    if( hf1 == -1 ) _FH.insert(make_pair(hf0, hf1));
-    else
-    {
-      if(hf1 < hf0) { HFid tmp = hf0; hf0 = hf1; hf1 = tmp; }
-      if(_FH.find(hf0) == _FH.end())
-        _FH.insert(make_pair(hf0, hf1));
-    }
-  }
-  cout << "CHF_L3::create_FH: " << (unsigned)_FH.size() << " faces found." << endl;
+  cout << "CHF_L3::create_FH: " << (unsigned)_nface << " faces found." << endl;
 }
 //--------------------------------------------------//
 void CHF_L2::check()
@@ -333,6 +226,8 @@ void CHF_L2::check()
 /** Checks Level 2 structure */
 { 
   CHF_L1::check();
+  need_VH();
+  need_EH();
 
   for(Vid i=0; i< nvert(); ++i)
   {
@@ -343,18 +238,18 @@ void CHF_L2::check()
     }
   }
 
-  for( Ecit i= EH().begin() ; i != EH().end(); ++i)
+  for( Vid a=0; a< nvert(); ++a)
+  for( int k=_EO[a]; k< _EO[a+1]; ++k)
   {
-    if(i->second == -1) 
+    if(_EF[k] == -1) 
     {
-      cout << "CHF_L2::Check ERRO: EH[i]" << "->second == -1" << endl;
+      cout << "CHF_L2::Check ERRO: EH[" << k << "] == -1" << endl;
       return;
     }
 
-	if(i->first.first >= nvert() || i->first.second>= nvert()) 
+	if(_EB[k] >= nvert() || _EB[k] < a || (k > _EO[a] && _EB[k] <= _EB[k-1])) 
     {
-   	  cout << "CHF_L2::Check ERRO :i->first.first  " << i->first.first << " >= nvert() " << endl;
-      cout << "                    i->firsf.second " << i->first.second<< " >= nvert() " << endl;
+   	  cout << "CHF_L2::Check ERRO : edge (" << a << "," << _EB[k] << ") out of order " << endl;
       return;
     }
   }
@@ -366,13 +261,15 @@ void CHF_L2::draw_wire(const int t)
 /** Draws the mesh in wireframe */
 {
   ColorRamp c;
+  need_EH();
 
   if( t == 5 ) //Draws the edges
   {
-    for( Ecit i= EH().begin() ; i != EH().end(); ++i)
+    for( Vid a=0; a< nvert(); ++a)
+    for( int k=_EO[a]; k< _EO[a+1]; ++k)
     {
-	  const Vertex &v0 = G(i->first.first);
-	  const Vertex &v1 = G(i->first.second);
+	  const Vertex &v0 = G(a);
+	  const Vertex &v1 = G(_EB[k]);
 
 	  c.set_GLcolor( 0.512, 1, COLOR_GRAYSCALE, 1 );
 
@@ -386,12 +283,13 @@ void CHF_L2::draw_wire(const int t)
   }
   if( t == 6 ) //Draws the edges with boundary classification
   {
-    for( Ecit i= EH().begin() ; i != EH().end(); ++i)
+    for( Vid a=0; a< nvert(); ++a)
+    for( int k=_EO[a]; k< _EO[a+1]; ++k)
     {
-	  const Vertex &v0 = G(i->first.first);
-	  const Vertex &v1 = G(i->first.second);
+	  const Vertex &v0 = G(a);
+	  const Vertex &v1 = G(_EB[k]);
 
-	  if( O(i->second) == -1 )c.set_GLcolor( 0.512, 1, COLOR_GRAYSCALE, 1 );
+	  if( O(_EF[k]) == -1 )c.set_GLcolor( 0.512, 1, COLOR_GRAYSCALE, 1 );
 	  else c.set_GLcolor( 0.012, 1, COLOR_AUTUMN, 1 );
 			
       glBegin( GL_LINES );
@@ -405,12 +303,13 @@ void CHF_L2::draw_wire(const int t)
 
   if( t == 7 ) //Draws the boundary edges
   {
-    for( Ecit i= EH().begin() ; i != EH().end(); ++i)
+    for( Vid a=0; a< nvert(); ++a)
+    for( int k=_EO[a]; k< _EO[a+1]; ++k)
     {
-	  const Vertex &v0 = G(i->first.first);
-	  const Vertex &v1 = G(i->first.second);
+	  const Vertex &v0 = G(a);
+	  const Vertex &v1 = G(_EB[k]);
 
-	  if( O(i->second) == -1 )c.set_GLcolor( 0.512, 1, COLOR_GRAYSCALE, 1 );
+	  if( O(_EF[k]) == -1 )c.set_GLcolor( 0.512, 1, COLOR_GRAYSCALE, 1 );
 	  else continue;
 			
       glBegin( GL_LINES );
@@ -430,6 +329,7 @@ void CHF_L2::draw_vert(const int t, const int p)
 /** Draws the vertices of the mesh */
 {
   ColorRamp c;
+  need_VH();
 
   if( t == 1 ) // Draw Verts
   {
@@ -541,4 +441,77 @@ void CHF_L2::draw_vert(const int t, const int p)
   if( t != 1 && t != 2 && t != 3 && t != 4)
     cout << "CHF_L2::draw_vert ERRO." << endl;
 }
-//--------------------------------------------------------------//
\ No newline at end of file
+//--------------------------------------------------------------//
+void CHF_L2::write_tables( Snapshot_writer &w ) const
+//--------------------------------------------------------------//
+{
+  CHF_L1::write_tables( w );
+  w.add_value( "NF", _nface );
+  w.add( "VH", _VH );
+  w.add( "EO", _EO );
+  w.add( "EB", _EB );
+  w.add( "EF", _EF );
+}
+//--------------------------------------------------------------//
+bool CHF_L2::read_tables( const Snapshot_reader &r )
+//--------------------------------------------------------------//
+{
+  return CHF_L1::read_tables( r ) && r.get_value( "NF", _nface )
+      && r.get( "VH", _VH ) && r.get( "EO", _EO ) && r.get( "EB", _EB ) && r.get( "EF", _EF )
+      && (Vid)_VH.size() == nvert() && (Vid)_EO.size() == nvert()+1;
+}
+//--------------------------------------------------------------//
+void CHF_L2::remap( const vector<Vid> &vnew, const vector<TEid> &tnew )
+//--------------------------------------------------------------//
+{
+  const bool rows = ( _EO.size() == vnew.size()+1 );
+  CHF_L1::remap( vnew, tnew );
+
+  if( _VH.size() == vnew.size() )
+  {
+    // a kept vertex whose half-face is dropped gets a new one from create_VH
+    int lost = 0;
+    vector<HFid> VH( nvert() );
+    #pragma omp parallel for schedule(static) reduction(+:lost)
+    for( Vid v=0; v<(Vid)vnew.size(); ++v )
+    {
+      if( vnew[v] < 0 ) continue;
+      VH[ vnew[v] ] = remap_hf( _VH[v], tnew );
+      if( _VH[v] >= 0 && VH[ vnew[v] ] < 0 ) ++lost;
+    }
+    _VH.swap( VH );
+    if( lost ) create_VH();
+  }
+
+  // the edge rows are indexed by the smallest vertex of each edge:
+  // they are built again (the faces are implicit in _O)
+  if( rows ) create_EH();
+}
+//--------------------------------------------------------------//
+void CHF_L2::materialize()
+//--------------------------------------------------------------//
+{
+  CHF_L1::materialize();
+  need_VH();
+  need_EH();
+}
+//--------------------------------------------------------------//
+void CHF_L2::take( CHF_L2 &c )
+//--------------------------------------------------------------//
+{
+  CHF_L1::take( c );
+  _nface = c._nface;  c._nface = 0;
+  _VH.swap( c._VH );  c._VH.clear();
+  _EO.swap( c._EO );  c._EO.clear();
+  _EB.swap( c._EB );  c._EB.clear();
+  _EF.swap( c._EF );  c._EF.clear();
+}
+//--------------------------------------------------------------//
+void CHF_L2::clear()
+//--------------------------------------------------------------//
+{
+  CHF_L1::clear();
+  _nface = 0;
+  _VH.clear(); _EO.clear(); _EB.clear(); _EF.clear();
+}
+//--------------------------------------------------------------//
@@ -16,6 +16,7 @@
 
 #include <map>
 #include <ctime>
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include "CHF_L1.hpp"
@@ -24,86 +25,133 @@ using namespace std;
 
 /** \brief Edge id type */
 typedef pair<Vid,Vid> Eid;
-
-/** \brief Edge iterator*/
-typedef map<Eid, HFid>::iterator Eit;
-/** \brief Edge const iterator*/
-typedef map<Eid, HFid>::const_iterator Ecit;
-
-/** \brief Face Map iterator*/
-typedef map<HFid, HFid>::iterator Fit;
-/** \brief Face Map const iterator*/
-typedef map<HFid, HFid>::const_iterator Fcit;
 //--------------------------------------------------//
 /** CHF data-structure for tetrahedral meshes
-  * \brief CHF: Level 2*/
+  * \brief CHF: Level 2
+  *
+  * The edges are stored in compressed rows keyed by their 
+  * smallest vertex: the edges (a,b), a<b, are the entries 
+  * _EO[a].._EO[a+1]-1 of _EB (the b's, sorted) and _EF (the 
+  * half-faces). Finding an edge is a binary search in the 
+  * row of a. The faces are implicit: a half-face h stands 
+  * for its face when O(h) == -1 or h < O(h).
+  *
+  * Memory per tetrahedron (about 1.2 edges and 2 faces 
+  * per tetrahedron): the maps used ~57 bytes for the edges 
+  * and ~80 bytes for the faces, the rows use ~10 bytes for 
+  * the edges and nothing for the faces.*/
 class CHF_L2:public CHF_L1
 //--------------------------------------------------//
 {
 //-- CHF_L2 protected data.--//        
 protected:
-  /** \brief Half-Face of vertices*/
-  vector<HFid>       _VH ;
-  /** \brief Map of edges*/
-  map<  Eid, HFid >  _EH ;
-  /** \brief Map of faces*/
-  map< HFid, HFid >  _FH ;
+  /** \brief Half-Face of vertices (created by the first query 
+    * that needs it, even a const one)*/
+  mutable vector<HFid>       _VH ;
+  /** \brief Edge rows: first edge of each vertex (nvert+1)*/
+  mutable vector<int>        _EO ;
+  /** \brief Edge rows: largest vertex of each edge*/
+  mutable vector<Vid>        _EB ;
+  /** \brief Edge rows: half-face of each edge*/
+  mutable vector<HFid>       _EF ;
+  /** \brief Number of faces*/
+  int                _nface ;
 
 public:
   /** \brief Default constructor.*/
-  CHF_L2():CHF_L1() {}
+  CHF_L2():CHF_L1(), _nface(0) {}
 
   /** \brief First constructor.
     * \param nv   -  const Vid.
     * \param ntet -  const TEid. */
-  CHF_L2(const Vid nv, const TEid ntet): CHF_L1(nv,ntet) { _VH.resize( nvert(), -1 ); }
+  CHF_L2(const Vid nv, const TEid ntet): CHF_L1(nv,ntet), _nface(0) { _VH.resize( nvert(), -1 ); }
 
   /** \brief Copy constructor
     * \param h  -  const CHF_L2 object.*/
-  CHF_L2(const CHF_L2& h): CHF_L1(h) { _EH=h._EH; _VH=h._VH; _FH=h._FH; }
+  CHF_L2(const CHF_L2& h): CHF_L1(h) { _EO=h._EO; _EB=h._EB; _EF=h._EF; _VH=h._VH; _nface=h._nface; }
+
+  /** \brief Promotion constructor: takes the tables of a level 1
+    * structure without copying them (h is left empty) and counts the
+    * faces. The vertex and edge tables are computed on demand: _VH by
+    * the first VH or R_00/R_03, the edges by the first nedge, e_find
+    * or R_10/R_13 (call need_VH/need_EH before parallel traversals).
+    * \param h  -  CHF_L1 object.*/
+  explicit CHF_L2(CHF_L1& h): CHF_L1(), _nface(0) { CHF_L1::take( h ); create_FH(); }
 
   /** \brief Destructor.*/
-  ~CHF_L2() { _FH.clear(); _EH.clear(); _VH.clear(); }
+  ~CHF_L2() { _EO.clear(); _EB.clear(); _EF.clear(); _VH.clear(); }
 
 public:
   /** \brief Access to the half-face of a vertex. 
     * \param v - const Vid  */  
-  inline const HFid  VH( const Vid v ) const { if( !v_valid(v) )  return INV;  return _VH[v] ; }
+  inline const HFid  VH( const Vid v ) const { if( !v_valid(v) )  return INV;  need_VH();  return _VH[v] ; }
+
+  /** \brief Tests if the vertex table is computed */
+  inline const bool has_VH() const { return (Vid)_VH.size() == nvert(); }
+
+  /** \brief Tests if the edge rows are computed */
+  inline const bool has_EH() const { return (Vid)_EO.size() == nvert()+1; }
+
+  /** \brief Access to the number of edges */
+  inline const  int  nedge() const { need_EH(); return (int)_EB.size(); }
+
+  /** \brief Access to the number of faces */
+  inline const  int  nface() const { return _nface; }
+
+  /** \brief Finds the row entry of an edge, INV if not found. 
+    * \param a - const Vid  
+    * \param b - const Vid  */  
+  inline const  int  e_find( Vid a, Vid b ) const 
+  { 
+    if( a > b ) { Vid tmp = a; a = b; b = tmp; }
+    if( a < 0 || b >= nvert() ) return INV;
+    need_EH();
+    const vector<Vid>::const_iterator s = _EB.begin() + _EO[a], e = _EB.begin() + _EO[a+1];
+    const vector<Vid>::const_iterator r = lower_bound( s, e, b );
+    if( r == e || *r != b ) return INV;
+    return (int)( r - _EB.begin() );
+  }
+
+  /** \brief Access to the edge of a row entry. 
+    * \param k - const int  */  
+  inline const  Eid  edge( const int k ) const 
+  { 
+    if( k < 0 || k >= nedge() ) return Eid(INV,INV);
+    return Eid( (Vid)( upper_bound( _EO.begin(), _EO.end(), k ) - _EO.begin() ) - 1, _EB[k] );
+  }
+
+  /** \brief Access to the half-face of a row entry. 
+    * \param k - const int  */  
+  inline const HFid  EF( const int k ) const { if( k < 0 || k >= nedge() ) return INV; return _EF[k]; }
 
   /** \brief Access to the half-face of an edge. 
     * \param e - const Eid  */  
-  inline const HFid *EH( const Eid e ) const { Ecit i = _EH.find( e ) ; if( i == _EH.end() ) return NULL ; return &i->second ; }
-
-  /** \brief Access to the edge map.*/
-  inline const map<Eid, HFid> &EH() const { return _EH; }
+  inline const HFid *EH( const Eid e ) const { int k = e_find( e.first, e.second ); if( k == INV ) return NULL ; return &_EF[k] ; }
 
-  /** \brief Access to one face of the map. 
+  /** \brief Access to the opposite of a face, given by its canonical half-face. 
     * \param h - const HFid  */  
-  inline const HFid *FH( const HFid h ) const { Fcit i = _FH.find( h ) ; if( i == _FH.end() ) return NULL ; return &i->second ; }
-
-  /** \brief Access to the face map.*/
-  inline const map<HFid, HFid> &FH() const { return _FH; }
+  inline const HFid *FH( const HFid h ) const { if( !f_valid(h) ) return NULL ; return &_O[h] ; }
 
   /** \brief Tests if a vertex is valid
     * \param v - const Vid */
-  inline const bool v_valid( const  Vid v ) const { return ( CHF_L1::v_valid(v) && _VH[v] != INV); }
+  inline const bool v_valid( const  Vid v ) const { return ( CHF_L1::v_valid(v) && ( !has_VH() || _VH[v] != INV ) ); }
 
   /** \brief Tests if an edge is valid
     * \param e - const Eid */
-  inline const bool e_valid( const  Eid e ) const { Ecit i = _EH.find( e ) ;   return i != _EH.end() ; }
+  inline const bool e_valid( const  Eid e ) const { return e_find( e.first, e.second ) != INV ; }
 
   /** \brief Tests if an face is valid
     * \param h - const HFid */
-  inline const bool f_valid( const HFid f ) const { Fcit i = _FH.find( f ) ;   return i != _FH.end() ; }
+  inline const bool f_valid( const HFid f ) const { if( !hf_valid(f) ) return false; HFid o = _O[f]; return ( o == -1 || f < o ) ; }
 
 public:
   /** \breaf Sets the half-face of a vertex. 
     * \param v - const Vid  
     * \param h - const HFid*/
-  inline const void  set_VH( const Vid v, const HFid h ) { if( v_valid(v) ) _VH[v]=h; return ;}
+  inline const void  set_VH( const Vid v, const HFid h ) { if( v_valid(v) && has_VH() ) _VH[v]=h; return ;}
   /** \brief Sets a vertex as invalid
     * \param v - const Vid */
-  inline const void  v_invalid( const  Vid v ) { CHF_L1::v_invalid(v); _VH[v]=INV; }
+  inline const void  v_invalid( const  Vid v ) { CHF_L1::v_invalid(v); if( has_VH() ) _VH[v]=INV; }
 
 public:
   /** \brief Computes the vertices in the star of a vertex 
@@ -121,17 +169,51 @@ public:
     * \param b - const Vid */
   virtual vector<TEid> R_13( const Vid a, const Vid b  );
 
+public:
+  /** \brief Visits the vertices in the star of a vertex, from VH(v)
+    * \param v - const Vid  
+    * \param f - F& functor called with each Vid */
+  template <class F> inline bool visit_R_00( const Vid v, F &f ) const { if( !has_VH() ) return CHF_L1::visit_R_00( v, f ); return flood_R_0( v, v_valid(v) ? (_VH[v]>>2) : INV, f, true ); }
+  /** \brief Visits the tetrahedra in the star of a vertex, from VH(v)
+    * \param v - const Vid  
+    * \param f - F& functor called with each TEid */
+  template <class F> inline bool visit_R_03( const Vid v, F &f ) const { if( !has_VH() ) return CHF_L1::visit_R_03( v, f ); return flood_R_0( v, v_valid(v) ? (_VH[v]>>2) : INV, f, false ); }
+  /** \brief Visits the vertices in the star of an edge, from EH(a,b)
+    * \param a - const Vid  
+    * \param b - const Vid  
+    * \param f - F& functor called with each Vid */
+  template <class F> inline bool visit_R_10( const Vid a, const Vid b, F &f ) const { if( !has_EH() ) return CHF_L1::visit_R_10( a, b, f ); return radial_R_1( a, b, edge_face(a,b), f, true ); }
+  /** \brief Visits the tetrahedra in the star of an edge, from EH(a,b)
+    * \param a - const Vid  
+    * \param b - const Vid  
+    * \param f - F& functor called with each TEid */
+  template <class F> inline bool visit_R_13( const Vid a, const Vid b, F &f ) const { if( !has_EH() ) return CHF_L1::visit_R_13( a, b, f ); return radial_R_1( a, b, edge_face(a,b), f, false ); }
+
+protected:
+  /** \brief Half-face of the edge (a,b), INV if there is none
+    * \param a - const Vid  
+    * \param b - const Vid */
+  inline HFid edge_face( const Vid a, const Vid b ) const
+  { if( !v_valid(a) || !v_valid(b) || a == b ) return INV; int k = e_find(a,b); return k == INV ? INV : _EF[k]; }
+
 public:
   /** \brief creates the VH table. */
-  void create_VH ();
-  /** \brief creates the EH map. */
-  void create_EH ();
-  /** \brief creates the FH map. */
+  void create_VH () const;
+  /** \brief creates the edge rows. */
+  void create_EH () const;
+  /** \brief counts the faces. */
   void create_FH ();
+  /** \brief Creates the "half-face of a vertex" container if it was not created yet */
+  inline void need_VH () const { if( !has_VH() ) create_VH(); }
+  /** \brief Creates the edge rows if they were not created yet */
+  inline void need_EH () const { if( !has_EH() ) create_EH(); }
 
   /** \brief Checks mesh validation*/
   void check ();
 
+  /** \brief Empties the structure*/
+  virtual void clear ();
+
 public:
   /** \brief Draws the vertices of the mesh. 
     * \param t= 0 - const int*/
@@ -161,5 +243,26 @@ public:
 
     //cout << "L2 load time:" << static_cast<double>(L2_time-start_time)/static_cast<double>(CLOCKS_PER_SEC) << endl;
   }
+
+protected:
+  /** \brief Level of the structure, stored in the snapshots*/
+  virtual const int snapshot_level() const { return 2; }
+  /** \brief Adds the tables of the level to a snapshot
+    * \param w - Snapshot_writer& */
+  virtual void write_tables ( Snapshot_writer &w ) const;
+  /** \brief Reads the tables of the level from a snapshot
+    * \param r - const Snapshot_reader& */
+  virtual bool read_tables ( const Snapshot_reader &r );
+
+  /** \brief Applies a permutation of the vertices and of the tetrahedra
+    * to the tables of the level
+    * \param vnew - const vector<Vid>&
+    * \param tnew - const vector<TEid>& */
+  virtual void remap ( const vector<Vid> &vnew, const vector<TEid> &tnew );
+  /** \brief Creates the tables built on demand */
+  virtual void materialize ();
+  /** \brief Takes the tables of c, which is left empty
+    * \param c - CHF_L2& */
+  void take ( CHF_L2 &c );
 };
 #endif
@@ -15,11 +15,12 @@
 #include <GL/glut.h>
 
 #include "CHF_L3.hpp"   /**< Level 2 inheritance*/
+#include "../common/Snapshot.hpp" /**< Binary snapshots*/
 #include "colorramp.h"	/**< Gl color maps*/
 
 using namespace std;
 //--------------------------------------------------//
-Bid CHF_L3::get_bS( Bid i )
+Bid CHF_L3::get_bS( Bid i ) const
 //--------------------------------------------------//
 /** Sets bS and returns the value.*/
 {
@@ -27,12 +28,12 @@ Bid CHF_L3::get_bS( Bid i )
   if( b < 0 || b == i ) return b ;
 
   b = get_bS(b) ;
-  set_bS( i,b );
+  _bS[i] = b;
 
   return b ;
 }
 //--------------------------------------------------//
-void CHF_L3::create_bS()
+void CHF_L3::create_bS() const
 //--------------------------------------------------//
 /** Creates the bS container*/
 {
@@ -44,9 +45,9 @@ void CHF_L3::create_bS()
     if( !v_valid(v) ) continue;
 
     if( O( VH(v) ) < 0 )
-      set_bS( v, v ) ;
+      _bS[v] = v ;
     else
-      set_bS( v, -1) ;
+      _bS[v] = -1 ;
   }
 
   for( TRid j = 0 ; j < bntrig() ; ++j )
@@ -62,26 +63,26 @@ void CHF_L3::create_bS()
     {
       if( b0 < b2 )
       { // b0 min
-        set_bS( b1, b0 ) ;
-        set_bS( b2, b0 ) ;
+        _bS[b1] = b0 ;
+        _bS[b2] = b0 ;
       }
       else
       { // b2 min
-        set_bS( b0, b2 ) ;
-        set_bS( b1, b2 ) ;
+        _bS[b0] = b2 ;
+        _bS[b1] = b2 ;
       }
     }
     else
     {
       if( b1 < b2 )
       { // b1 min
-        set_bS( b0, b1 ) ;
-        set_bS( b2, b1 ) ;
+        _bS[b0] = b1 ;
+        _bS[b2] = b1 ;
       }
       else
       { // b2 min
-        set_bS( b0, b2 ) ;
-        set_bS( b1, b2 ) ;
+        _bS[b0] = b2 ;
+        _bS[b1] = b2 ;
       }
     }
   }
@@ -104,13 +105,13 @@ void CHF_L3::create_bS()
 
     Bid b = bS(v) ;
     if( b < 0 ) continue ;
-     set_bS( v, corresp[b]) ;
+     _bS[v] = corresp[b] ;
   }
 
 	cout << "CHF_L3::create_bS: " << bnsurf() << " boundary surfaces found." << endl;
 }
 //--------------------------------------------------//
-void CHF_L3::create_bV()
+void CHF_L3::create_bV() const
 //--------------------------------------------------//
 /** Creates the bV container*/
 {
@@ -133,7 +134,7 @@ void CHF_L3::create_bV()
   }
 }
 //--------------------------------------------------//
-void CHF_L3::create_bO()
+void CHF_L3::create_bO() const
 //--------------------------------------------------//
 /** Creates the bO container*/
 {
@@ -156,8 +157,8 @@ void CHF_L3::create_bO()
 
     if( pos != adj.end() )
     {
-      set_bO(c, pos->second) ;
-      set_bO( bO(c), c) ;
+      _bO[c] = pos->second ;
+      _bO[ pos->second ] = c ;
 
       adj.erase( pos ) ;
     }
@@ -205,6 +206,7 @@ void CHF_L3::compute_normals()
     v2.set_ny( v2.ny()+norm[1] );
     v2.set_nz( v2.nz()+norm[2] );
   }
+  _bnormals = true;
 }
 //--------------------------------------------------//
 const bool CHF_L3::borient_check(const HEid c, const HEid t)
@@ -226,6 +228,7 @@ void CHF_L3::check()
 //--------------------------------------------------//
 {
   CHF_L2::check();
+  need_boundary();
 
   for(HEid i=0; i< 3*bntrig(); ++i)
   {
@@ -267,6 +270,7 @@ void CHF_L3::draw_smooth(const int t)
 //--------------------------------------------------//
 /** Draws the boundary surface */
 {
+  need_boundary();
   if( t != 8 && t != 9 && t != 10 ) 
   {
     cout << "CHF_L3::draw_smooth ERRO" << endl;
@@ -311,3 +315,119 @@ void CHF_L3::draw_smooth(const int t)
   glEnd();
 }
 //--------------------------------------------------//
+void CHF_L3::write_tables( Snapshot_writer &w ) const
+//--------------------------------------------------//
+{
+  CHF_L2::write_tables( w );
+  w.add_value( "BNS", _bnsurf );
+  w.add_value( "BNT", _bntrig );
+  w.add( "bV", _bV );
+  w.add( "bO", _bO );
+  w.add( "bS", _bS );
+}
+//--------------------------------------------------//
+bool CHF_L3::read_tables( const Snapshot_reader &r )
+//--------------------------------------------------//
+{
+  // the normals of a snapshot are the ones of its boundary (see materialize)
+  _bnormals = true;
+  return CHF_L2::read_tables( r ) && r.get_value( "BNS", _bnsurf ) && r.get_value( "BNT", _bntrig )
+      && r.get( "bV", _bV ) && r.get( "bO", _bO ) && r.get( "bS", _bS )
+      && (HEid)_bV.size() == 3*_bntrig && (Vid)_bS.size() == nvert();
+}
+//--------------------------------------------------//
+void CHF_L3::remap( const vector<Vid> &vnew, const vector<TEid> &tnew )
+//--------------------------------------------------//
+{
+  // boundary half-face of each boundary triangle, as in create_bV
+  vector< pair<HFid,TRid> > bh;
+  for( HFid i=0; i<4*ntetra(); ++i )
+  {
+    if( !hf_valid(i) || O(i) != -1 ) continue;
+    bh.push_back( make_pair( remap_hf( i, tnew ), (TRid)bh.size() ) );
+  }
+
+  const bool boundary = ( _bS.size() == vnew.size() );
+  CHF_L2::remap( vnew, tnew );
+
+  // dropped tetrahedra change the boundary: its tables are built again
+  if( ntetra() < (TEid)tnew.size() )
+  {
+    _bV.clear(); _bO.clear(); _bS.clear(); _bnsurf = 0; _bntrig = 0; _bnormals = false;
+    if( boundary ) need_boundary();
+    return;
+  }
+
+  if( boundary )
+  {
+    vector<Bid> bS( nvert() );
+    for( Vid v=0; v<(Vid)vnew.size(); ++v ) if( vnew[v] >= 0 ) bS[ vnew[v] ] = _bS[v];
+    _bS.swap( bS );
+  }
+
+  // the boundary triangles follow their new half-faces
+  const TRid nb = (TRid)_bV.size() / 3;
+  vector<TRid> bnew( nb );
+  if( (TRid)bh.size() == nb )
+  {
+    sort( bh.begin(), bh.end() );
+    for( TRid k=0; k<nb; ++k ) bnew[ bh[k].second ] = k;
+  }
+  else
+    for( TRid k=0; k<nb; ++k ) bnew[k] = k;
+
+  vector<Vid>  bV( _bV.size() );
+  vector<HEid> bO( _bO.size() );
+  for( TRid k=0; k<nb; ++k )
+    for( int j=0; j<3; ++j )
+    {
+      const Vid v = _bV[3*k+j];
+      bV[ 3*bnew[k]+j ] = ( v >= 0 && v < (Vid)vnew.size() ) ? vnew[v] : v;
+      if( 3*k+j >= (HEid)_bO.size() ) continue;
+      const HEid o = _bO[3*k+j];
+      bO[ 3*bnew[k]+j ] = ( o < 0 ) ? o : 3*bnew[o/3] + o%3;
+    }
+  _bV.swap( bV );
+  _bO.swap( bO );
+}
+//--------------------------------------------------//
+void CHF_L3::need_boundary()
+//--------------------------------------------------//
+/** Creates the boundary tables and normals of a promoted structure, as read_ply*/
+{
+  if( has_boundary() && _bnormals ) return;
+
+  need_btables();
+  CHF_L3::compute_normals();
+}
+//--------------------------------------------------//
+void CHF_L3::need_btables() const
+//--------------------------------------------------//
+/** Creates the boundary tables. _bS is sized first, so that
+  * the queries made while the tables are created do not 
+  * create them again.*/
+{
+  if( has_boundary() ) return;
+
+  need_VH();
+  _bS.assign( nvert(), -1 );
+  create_bV();
+  create_bO();
+  create_bS();
+}
+//--------------------------------------------------//
+void CHF_L3::materialize()
+//--------------------------------------------------//
+{
+  CHF_L2::materialize();
+  need_boundary();
+}
+//--------------------------------------------------//
+void CHF_L3::clear()
+//--------------------------------------------------//
+{
+  CHF_L2::clear();
+  _bV.clear(); _bO.clear(); _bS.clear();
+  _bnsurf = 0; _bntrig = 0; _bnormals = false;
+}
+//--------------------------------------------------//
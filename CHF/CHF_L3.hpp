@@ -35,42 +35,55 @@ class CHF_L3:public CHF_L2
 //-- CHF_L3 protected data.--//        
 protected:
   /** \brief number of boundary surfaces*/
-  Bid  _bnsurf;
+  mutable Bid  _bnsurf;
   
   /** \brief number of boundary triangles*/
-  TRid _bntrig;
+  mutable TRid _bntrig;
 
-  /** \brief Boundary Vertex Table */
-  vector<Vid> _bV;
+  /** \brief Boundary Vertex Table (the boundary tables are 
+    * created by the first query that needs them, even a const one)*/
+  mutable vector<Vid> _bV;
   
   /** \brief Boundary Opposite Table */
-  vector<Vid> _bO;
+  mutable vector<Vid> _bO;
 	
   /** \brief Vertex Surface Table */
-  vector<Bid> _bS;
+  mutable vector<Bid> _bS;
+
+  /** \brief Tells if the normals of the vertices are the ones 
+    * of the boundary surface*/
+  bool _bnormals;
 
 public:
   /** \brief Default constructor.*/
-  CHF_L3():CHF_L2() {}
+  CHF_L3():CHF_L2(), _bnsurf(0), _bntrig(0), _bnormals(false) {}
 
   /** \brief First constructor.
     * \param nv   -  const Vid.
     * \param ntet -  const TEid. */
-  CHF_L3(const Vid nv, const TEid ntet): CHF_L2(nv,ntet) { _bS.resize( nvert(), -1 ); }
+  CHF_L3(const Vid nv, const TEid ntet): CHF_L2(nv,ntet), _bnsurf(0), _bntrig(0), _bnormals(false) { _bS.resize( nvert(), -1 ); }
 
   /** \brief Copy constructor
     * \param h  -  const CHF_L2 object.*/
-  CHF_L3(const CHF_L3& h): CHF_L2(h) { _bV=h._bV; _bO=h._bO; _bS= h._bS; _bnsurf = h._bnsurf; _bntrig= h._bntrig; }
+  CHF_L3(const CHF_L3& h): CHF_L2(h) { _bV=h._bV; _bO=h._bO; _bS= h._bS; _bnsurf = h._bnsurf; _bntrig= h._bntrig; _bnormals= h._bnormals; }
+
+  /** \brief Promotion constructor: takes the tables of a level 2
+    * structure without copying them (h is left empty). The boundary
+    * tables are created by the first boundary query, the normals by
+    * the first draw_smooth or check (call need_boundary before 
+    * parallel traversals).
+    * \param h  -  CHF_L2 object.*/
+  explicit CHF_L3(CHF_L2& h): CHF_L2(), _bnsurf(0), _bntrig(0), _bnormals(false) { CHF_L2::take( h ); }
 
   /** \brief Destructor.*/
   ~CHF_L3() { _bV.clear(); _bO.clear(); _bS.clear(); _bnsurf=0; _bntrig=0; }
 
 public:
   /** \brief Accesses the number of boundary surfaces  of the model  */
-  inline const  Bid bnsurf() const{ return _bnsurf; } 
+  inline const  Bid bnsurf() const{ need_btables(); return _bnsurf; } 
 	
   /** \brief Accesses the number of boundary triangles of the model */
-  inline const TRid bntrig() const{ return _bntrig; }
+  inline const TRid bntrig() const{ need_btables(); return _bntrig; }
 
   /** \brief Accesses the vertex of a boundary half-edge 
     * \param h - const HEid */
@@ -80,7 +93,10 @@ public:
   inline const HEid bO ( const HEid h ) const { if( !he_valid(h) ) return INV;  return _bO[h] ; }
   /** \brief Accesses the boundary surface os a vertex 
     * \param h - const HFid */
-  inline const  Bid bS ( const  Vid v ) const { if(  !v_valid(v) ) return INV;  return _bS[v] ; }
+  inline const  Bid bS ( const  Vid v ) const { if(  !v_valid(v) ) return INV;  need_btables();  return _bS[v] ; }
+
+  /** \brief Tests if the boundary tables are created */
+  inline const bool has_boundary() const { return (Vid)_bS.size() == nvert(); }
 
   /** \brief Tests if a boundary half-edge is valid
     * \param h - const HEid */
@@ -120,18 +136,22 @@ public:
 
 public:
   /** \brief Creates the bS table. */
-  void create_bS () ;
+  void create_bS () const;
   /** \brief Creates the bV table. */
-  void create_bV () ;
+  void create_bV () const;
   /** \brief Creates the bO table. */
-  void create_bO () ;
+  void create_bO () const;
+  /** \brief Creates the boundary tables if they were not created yet */
+  void need_btables () const;
+  /** \brief Creates the boundary tables and normals if they were not created yet */
+  void need_boundary () ;
 
   /** \brief Computes bound faces' normal.*/  
   virtual void compute_normals();
 
 private :
   /** \brief Sets bS and returns the value*/
-  Bid  get_bS( Bid i ) ;
+  Bid  get_bS( Bid i ) const;
 
 public :
   /** \brief Checks the orientation beetwen two boundary triangles. 
@@ -141,6 +161,9 @@ public :
   /** \brief Checks mesh validation*/
   void check ();
 
+  /** \brief Empties the structure*/
+  virtual void clear ();
+
 public:
   /** \brief Draws the bound surface of the mesh. 
     * \param t= 0 - const int*/
@@ -157,16 +180,33 @@ public:
 
     start_time = clock();
 
+    _bS.clear(); 
+    _bnormals = false;
     CHF_L2::read_ply(fn); 
  
-    create_bV(); 
-    create_bO(); 
-    create_bS(); 
-    CHF_L3::compute_normals();
+    need_boundary();
 
     L3_time = clock();
 
     //cout << "L3 load time:" << static_cast<double>(L3_time-start_time)/static_cast<double>(CLOCKS_PER_SEC) << endl;
   }
+
+protected:
+  /** \brief Level of the structure, stored in the snapshots*/
+  virtual const int snapshot_level() const { return 3; }
+  /** \brief Adds the tables of the level to a snapshot
+    * \param w - Snapshot_writer& */
+  virtual void write_tables ( Snapshot_writer &w ) const;
+  /** \brief Reads the tables of the level from a snapshot
+    * \param r - const Snapshot_reader& */
+  virtual bool read_tables ( const Snapshot_reader &r );
+
+  /** \brief Applies a permutation of the vertices and of the tetrahedra
+    * to the tables of the level
+    * \param vnew - const vector<Vid>&
+    * \param tnew - const vector<TEid>& */
+  virtual void remap ( const vector<Vid> &vnew, const vector<TEid> &tnew );
+  /** \brief Creates the tables built on demand */
+  virtual void materialize ();
 };
 #endif
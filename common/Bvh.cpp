@@ -0,0 +1,502 @@
+/**
+* @file    Bvh.cpp
+*
+* @brief  (Bounding volume hierarchy over the triangles of a CHE or CHF mesh)
+*/
+
+#include "Bvh.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+/** \brief Number of bins of the surface area heuristic*/
+#define BVH_BINS  16
+/** \brief Maximal depth of the tree, which bounds the traversal stacks*/
+#define BVH_DEPTH 64
+/** \brief Number of triangles above which a node is always split*/
+#define BVH_LEAF  16
+
+//--------------------------------------------------//
+/** Float just below a double*/
+static inline float bvh_down( const double x )
+//--------------------------------------------------//
+{
+  float f = (float) x;
+  if( (double) f > x ) f -= fabs(f) * FLT_EPSILON + FLT_MIN;
+  return f;
+}
+//--------------------------------------------------//
+/** Float just above a double*/
+static inline float bvh_up( const double x )
+//--------------------------------------------------//
+{
+  float f = (float) x;
+  if( (double) f < x ) f += fabs(f) * FLT_EPSILON + FLT_MIN;
+  return f;
+}
+//--------------------------------------------------//
+/** Half of the surface of a box*/
+static inline double bvh_area( const double *lo, const double *hi )
+//--------------------------------------------------//
+{
+  const double a = hi[0]-lo[0], b = hi[1]-lo[1], c = hi[2]-lo[2];
+  return ( a < 0 ) ? 0 : a*b + b*c + c*a;
+}
+//--------------------------------------------------//
+/** Squared distance from a point to a node box*/
+static inline double bvh_box_dist2( const Bvh::Node &n, const double *p )
+//--------------------------------------------------//
+{
+  double d = 0;
+  for( int k=0; k<3; ++k )
+  {
+    if     ( p[k] < n.lo[k] ) d += ( n.lo[k]-p[k] ) * ( n.lo[k]-p[k] );
+    else if( p[k] > n.hi[k] ) d += ( p[k]-n.hi[k] ) * ( p[k]-n.hi[k] );
+  }
+  return d;
+}
+//--------------------------------------------------//
+/** Entry parameter of a ray in a node box, or tmax if it misses it
+  * (slab test, with the inverse of the direction)*/
+static inline double bvh_box_ray( const Bvh::Node &n, const double *o, const double *inv, const double tmax )
+//--------------------------------------------------//
+{
+  double t0 = 0, t1 = tmax;
+  for( int k=0; k<3; ++k )
+  {
+    double a = ( n.lo[k] - o[k] ) * inv[k], b = ( n.hi[k] - o[k] ) * inv[k];
+    if( a > b ) { const double s = a; a = b; b = s; }
+    if( a > t0 ) t0 = a;
+    if( b < t1 ) t1 = b;
+    if( t0 > t1 ) return tmax;
+  }
+  return t0;
+}
+//--------------------------------------------------//
+/** Intersection of a ray with a triangle (Moller and Trumbore, 1997):
+  * ray parameter and barycentric coordinates*/
+static inline bool bvh_tri_ray( const double *q, const double *o, const double *d, double &t, double &u, double &v )
+//--------------------------------------------------//
+{
+  const double e1[3] = { q[3]-q[0], q[4]-q[1], q[5]-q[2] };
+  const double e2[3] = { q[6]-q[0], q[7]-q[1], q[8]-q[2] };
+  const double pv[3] = { d[1]*e2[2]-d[2]*e2[1], d[2]*e2[0]-d[0]*e2[2], d[0]*e2[1]-d[1]*e2[0] };
+  const double det = e1[0]*pv[0] + e1[1]*pv[1] + e1[2]*pv[2];
+  if( det == 0 ) return false;
+
+  const double id = 1.0 / det;
+  const double s[3] = { o[0]-q[0], o[1]-q[1], o[2]-q[2] };
+  u = ( s[0]*pv[0] + s[1]*pv[1] + s[2]*pv[2] ) * id;
+  if( u < 0 || u > 1 ) return false;
+
+  const double qv[3] = { s[1]*e1[2]-s[2]*e1[1], s[2]*e1[0]-s[0]*e1[2], s[0]*e1[1]-s[1]*e1[0] };
+  v = ( d[0]*qv[0] + d[1]*qv[1] + d[2]*qv[2] ) * id;
+  if( v < 0 || u+v > 1 ) return false;
+
+  t = ( e2[0]*qv[0] + e2[1]*qv[1] + e2[2]*qv[2] ) * id;
+  return true;
+}
+//--------------------------------------------------//
+/** Closest point of a segment to a point: parameter along the segment
+  * (0 for a null segment). Returns the squared distance.*/
+static inline double bvh_seg_closest( const double *a, const double *b, const double *p, double &s )
+//--------------------------------------------------//
+{
+  const double ab[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+  const double l = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+  s = ( l > 0 ) ? ( ab[0]*(p[0]-a[0]) + ab[1]*(p[1]-a[1]) + ab[2]*(p[2]-a[2]) ) / l : 0;
+  if( s < 0 ) s = 0;  else if( s > 1 ) s = 1;
+
+  double d = 0;
+  for( int k=0; k<3; ++k ) { const double x = a[k] + s*ab[k] - p[k];  d += x*x; }
+  return d;
+}
+//--------------------------------------------------//
+/** Closest point of a flat triangle (collinear or repeated vertices) to
+  * a point: the closest one on its three edges*/
+static inline void bvh_flat_closest( const double *q, const double *p, double &u, double &v )
+//--------------------------------------------------//
+{
+  double s, d = bvh_seg_closest( q, q+3, p, s ), e;
+  u = s;  v = 0;
+  e = bvh_seg_closest( q, q+6, p, s );
+  if( e < d ) { d = e;  u = 0;  v = s; }
+  e = bvh_seg_closest( q+3, q+6, p, s );
+  if( e < d ) { d = e;  u = 1-s;  v = s; }
+}
+//--------------------------------------------------//
+/** Closest point of a triangle to a point, by the Voronoi regions of its
+  * vertices and edges (C. Ericson, "Real-time collision detection",
+  * 2005). Returns the squared distance. A flat triangle, or a region
+  * whose denominator vanishes, falls back to the closest edge.*/
+static inline double bvh_tri_closest( const double *q, const double *p, double *c, double &u, double &v )
+//--------------------------------------------------//
+{
+  const double ab[3] = { q[3]-q[0], q[4]-q[1], q[5]-q[2] };
+  const double ac[3] = { q[6]-q[0], q[7]-q[1], q[8]-q[2] };
+  const double n [3] = { ab[1]*ac[2]-ab[2]*ac[1], ab[2]*ac[0]-ab[0]*ac[2], ab[0]*ac[1]-ab[1]*ac[0] };
+  const double ap[3] = { p[0]-q[0], p[1]-q[1], p[2]-q[2] };
+  const double d1 = ab[0]*ap[0] + ab[1]*ap[1] + ab[2]*ap[2];
+  const double d2 = ac[0]*ap[0] + ac[1]*ap[1] + ac[2]*ap[2];
+
+  const double bp[3] = { p[0]-q[3], p[1]-q[4], p[2]-q[5] };
+  const double d3 = ab[0]*bp[0] + ab[1]*bp[1] + ab[2]*bp[2];
+  const double d4 = ac[0]*bp[0] + ac[1]*bp[1] + ac[2]*bp[2];
+
+  const double cp[3] = { p[0]-q[6], p[1]-q[7], p[2]-q[8] };
+  const double d5 = ab[0]*cp[0] + ab[1]*cp[1] + ab[2]*cp[2];
+  const double d6 = ac[0]*cp[0] + ac[1]*cp[1] + ac[2]*cp[2];
+
+  const double vc = d1*d4 - d3*d2, vb = d5*d2 - d1*d6, va = d3*d6 - d5*d4;
+
+  if     ( !( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] > 0 ) ) bvh_flat_closest( q, p, u, v );
+  else if( d1 <= 0 && d2 <= 0 )                         { u = 0; v = 0; }
+  else if( d3 >= 0 && d4 <= d3 )                        { u = 1; v = 0; }
+  else if( d6 >= 0 && d5 <= d6 )                        { u = 0; v = 1; }
+  else if( vc <= 0 && d1 >= 0 && d3 <= 0 && d1 > d3 )   { u = d1 / ( d1-d3 ); v = 0; }
+  else if( vb <= 0 && d2 >= 0 && d6 <= 0 && d2 > d6 )   { u = 0; v = d2 / ( d2-d6 ); }
+  else if( va <= 0 && d4-d3 >= 0 && d5-d6 >= 0 && ( d4-d3 ) + ( d5-d6 ) > 0 ) { v = ( d4-d3 ) / ( ( d4-d3 ) + ( d5-d6 ) ); u = 1-v; }
+  else if( va+vb+vc > 0 ) { const double s = 1.0 / ( va+vb+vc ); u = vb*s; v = vc*s; }
+  else bvh_flat_closest( q, p, u, v );
+
+  double d = 0;
+  for( int k=0; k<3; ++k )
+  {
+    c[k] = q[k] + u*ab[k] + v*ac[k];
+    d += ( p[k]-c[k] ) * ( p[k]-c[k] );
+  }
+  return d;
+}
+//--------------------------------------------------//
+/** Side of a triangle for the partition of a node: its centroid bin
+  * is below the split bin*/
+struct Bvh_side
+//--------------------------------------------------//
+{
+  const double *c;
+  int    axis, split;
+  double lo, scale;
+  Bvh_side( const double *c_, const int a, const int s, const double l, const double k ) : c(c_), axis(a), split(s), lo(l), scale(k) {}
+  inline int  bin( const int t ) const { const int b = (int)( ( c[3*t+axis] - lo ) * scale ); return b < BVH_BINS ? b : BVH_BINS-1; }
+  inline bool operator()( const int t ) const { return bin(t) < split; }
+};
+//--------------------------------------------------//
+void Bvh::clear()
+//--------------------------------------------------//
+/** Releases the nodes and the triangles.*/
+{
+  vector<Node>  ().swap( _nodes );
+  vector<int>   ().swap( _T );
+  vector<double>().swap( _P );
+}
+//--------------------------------------------------//
+void Bvh::build( const Bvh_source &s )
+//--------------------------------------------------//
+/** Reads the triangles in parallel and splits them recursively.*/
+{
+  clear();
+  const int n = s.ntrig();
+
+  // coordinates, boxes and centroids of the triangles
+  vector<double> P( 9*(size_t)n ), bx( 6*(size_t)n ), c( 3*(size_t)n );
+  vector<char>   ok( n );
+  #pragma omp parallel for schedule(static)
+  for( int t=0; t<n; ++t )
+  {
+    ok[t] = s.triangle( t, &P[9*(size_t)t] );
+    if( !ok[t] ) continue;
+    const double *q = &P[9*(size_t)t];
+    for( int k=0; k<3; ++k )
+    {
+      bx[6*t+k]   = min( q[k], min( q[3+k], q[6+k] ) );
+      bx[6*t+3+k] = max( q[k], max( q[3+k], q[6+k] ) );
+      c [3*t+k]   = ( q[k] + q[3+k] + q[6+k] ) / 3;
+    }
+  }
+
+  vector<int> ids;
+  for( int t=0; t<n; ++t ) if( ok[t] ) ids.push_back( t );
+  if( ids.empty() ) return;
+
+  _nodes.reserve( 2 * ids.size() / _leaf + 1 );
+  build_node( ids, c, bx, 0, (int)ids.size(), 0 );
+
+  // triangles in the order of the leaves
+  _T.swap( ids );
+  _P.resize( 9 * _T.size() );
+  #pragma omp parallel for schedule(static)
+  for( int i=0; i<(int)_T.size(); ++i )
+    for( int k=0; k<9; ++k ) _P[9*(size_t)i+k] = P[9*(size_t)_T[i]+k];
+}
+//--------------------------------------------------//
+int Bvh::build_node( vector<int> &ids, const vector<double> &c, const vector<double> &bx, const int b, const int e, const int depth )
+//--------------------------------------------------//
+/** Splits the triangles at the bin boundary of smallest surface area
+  * heuristic cost, or makes a leaf.*/
+{
+  const int i = (int)_nodes.size();
+  _nodes.push_back( Node() );
+
+  // box of the triangles and of their centroids
+  double lo[3] = { DBL_MAX, DBL_MAX, DBL_MAX }, hi[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+  double cl[3] = { DBL_MAX, DBL_MAX, DBL_MAX }, ch[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+  for( int j=b; j<e; ++j )
+  {
+    const int t = ids[j];
+    for( int k=0; k<3; ++k )
+    {
+      lo[k] = min( lo[k], bx[6*t+k] );  hi[k] = max( hi[k], bx[6*t+3+k] );
+      cl[k] = min( cl[k], c [3*t+k] );  ch[k] = max( ch[k], c [3*t+k] );
+    }
+  }
+  for( int k=0; k<3; ++k ) { _nodes[i].lo[k] = bvh_down( lo[k] );  _nodes[i].hi[k] = bvh_up( hi[k] ); }
+
+  const int n = e-b;
+  _nodes[i].index = b;
+  _nodes[i].count = n;
+  if( n <= _leaf || depth >= BVH_DEPTH ) return i;
+
+  // binned surface area heuristic on the three axes
+  int    best_axis = -1, best_split = 0;
+  double best_cost = bvh_area( lo, hi ) * n;
+  for( int a=0; a<3; ++a )
+  {
+    const double ext = ch[a] - cl[a];
+    if( !( ext > 0 ) ) continue;
+    const Bvh_side side( &c[0], a, 0, cl[a], BVH_BINS / ext );
+
+    int    cnt[BVH_BINS];
+    double blo[BVH_BINS][3], bhi[BVH_BINS][3];
+    for( int k=0; k<BVH_BINS; ++k )
+    {
+      cnt[k] = 0;
+      blo[k][0] = blo[k][1] = blo[k][2] =  DBL_MAX;
+      bhi[k][0] = bhi[k][1] = bhi[k][2] = -DBL_MAX;
+    }
+    for( int j=b; j<e; ++j )
+    {
+      const int t = ids[j], k = side.bin(t);
+      ++cnt[k];
+      for( int l=0; l<3; ++l ) { blo[k][l] = min( blo[k][l], bx[6*t+l] );  bhi[k][l] = max( bhi[k][l], bx[6*t+3+l] ); }
+    }
+
+    // areas of the right sides, then sweep from the left
+    double rarea[BVH_BINS];
+    int    rcnt [BVH_BINS];
+    double rl[3] = { DBL_MAX, DBL_MAX, DBL_MAX }, rh[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+    int    r = 0;
+    for( int k=BVH_BINS-1; k>0; --k )
+    {
+      r += cnt[k];
+      for( int l=0; l<3; ++l ) { rl[l] = min( rl[l], blo[k][l] );  rh[l] = max( rh[l], bhi[k][l] ); }
+      rarea[k] = bvh_area( rl, rh );
+      rcnt [k] = r;
+    }
+    double ll[3] = { DBL_MAX, DBL_MAX, DBL_MAX }, lh[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+    int    l = 0;
+    for( int k=1; k<BVH_BINS; ++k )
+    {
+      l += cnt[k-1];
+      for( int m=0; m<3; ++m ) { ll[m] = min( ll[m], blo[k-1][m] );  lh[m] = max( lh[m], bhi[k-1][m] ); }
+      if( l == 0 || rcnt[k] == 0 ) continue;
+      const double cost = bvh_area( ll, lh ) * l + rarea[k] * rcnt[k];
+      if( cost < best_cost ) { best_cost = cost;  best_axis = a;  best_split = k; }
+    }
+  }
+
+  int m;
+  if( best_axis >= 0 )
+  {
+    const Bvh_side side( &c[0], best_axis, best_split, cl[best_axis], BVH_BINS / ( ch[best_axis] - cl[best_axis] ) );
+    m = (int)( partition( ids.begin()+b, ids.begin()+e, side ) - ids.begin() );
+  }
+  else if( n > BVH_LEAF ) m = b + n/2;  // no useful split: halves
+  else return i;
+
+  _nodes[i].count = 0;
+  build_node( ids, c, bx, b, m, depth+1 );
+  const int r = build_node( ids, c, bx, m, e, depth+1 );
+  _nodes[i].index = r;  // after the growth of _nodes
+  return i;
+}
+//--------------------------------------------------//
+void Bvh::fit_node( const int i )
+//--------------------------------------------------//
+/** Box of the triangles of a leaf, or union of the children boxes.*/
+{
+  Node &n = _nodes[i];
+  if( n.count == 0 )
+  {
+    const Node &a = _nodes[i+1], &b = _nodes[n.index];
+    for( int k=0; k<3; ++k ) { n.lo[k] = min( a.lo[k], b.lo[k] );  n.hi[k] = max( a.hi[k], b.hi[k] ); }
+    return;
+  }
+
+  double lo[3] = { DBL_MAX, DBL_MAX, DBL_MAX }, hi[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+  for( int j=n.index; j<n.index+n.count; ++j )
+    for( int v=0; v<3; ++v )
+      for( int k=0; k<3; ++k )
+      {
+        const double x = _P[9*(size_t)j+3*v+k];
+        lo[k] = min( lo[k], x );  hi[k] = max( hi[k], x );
+      }
+  for( int k=0; k<3; ++k ) { n.lo[k] = bvh_down( lo[k] );  n.hi[k] = bvh_up( hi[k] ); }
+}
+//--------------------------------------------------//
+void Bvh::refit( const Bvh_source &s )
+//--------------------------------------------------//
+/** Copies the triangles and fits the leaves in parallel, then fits the
+  * inner nodes from the last one, whose children come after them.*/
+{
+  if( _nodes.empty() ) return;
+
+  #pragma omp parallel for schedule(static)
+  for( int i=0; i<(int)_T.size(); ++i ) s.triangle( _T[i], &_P[9*(size_t)i] );
+
+  #pragma omp parallel for schedule(dynamic,1024)
+  for( int i=0; i<(int)_nodes.size(); ++i ) if( _nodes[i].count > 0 ) fit_node( i );
+
+  for( int i=(int)_nodes.size()-1; i>=0; --i ) if( _nodes[i].count == 0 ) fit_node( i );
+}
+//--------------------------------------------------//
+bool Bvh::ray( const double *o, const double *d, Bvh_hit &h, const double tmax ) const
+//--------------------------------------------------//
+/** Visits the nearer child first and skips the boxes behind the current hit.*/
+{
+  h.t = -1;
+  h.d = tmax;
+  if( _nodes.empty() ) return false;
+
+  // a null direction component does not give an infinite product
+  const double inv[3] = { d[0] != 0 ? 1/d[0] : 1e300, d[1] != 0 ? 1/d[1] : 1e300, d[2] != 0 ? 1/d[2] : 1e300 };
+
+  int stack[BVH_DEPTH+2], ns = 0;
+  if( bvh_box_ray( _nodes[0], o, inv, h.d ) < h.d ) stack[ns++] = 0;
+  while( ns > 0 )
+  {
+    const Node &n = _nodes[ stack[--ns] ];
+    if( n.count > 0 )
+    {
+      for( int j=n.index; j<n.index+n.count; ++j )
+      {
+        double t, u, v;
+        if( !bvh_tri_ray( &_P[9*(size_t)j], o, d, t, u, v ) || t < 0 || t > h.d ) continue;
+        h.t = _T[j];  h.d = t;  h.u = u;  h.v = v;
+      }
+      continue;
+    }
+
+    const int    a  = (int)( &n - &_nodes[0] ) + 1, b = n.index;
+    const double ta = bvh_box_ray( _nodes[a], o, inv, h.d ), tb = bvh_box_ray( _nodes[b], o, inv, h.d );
+    const bool   ha = ta < h.d, hb = tb < h.d;
+    if( ha && hb )
+    {
+      if( ta <= tb ) { stack[ns++] = b;  stack[ns++] = a; }
+      else           { stack[ns++] = a;  stack[ns++] = b; }
+    }
+    else if( ha ) stack[ns++] = a;
+    else if( hb ) stack[ns++] = b;
+  }
+
+  if( h.t < 0 ) return false;
+  for( int k=0; k<3; ++k ) h.p[k] = o[k] + h.d * d[k];
+  return true;
+}
+//--------------------------------------------------//
+bool Bvh::closest( const double *p, Bvh_hit &h, const double dmax ) const
+//--------------------------------------------------//
+/** Visits the nearer child first and skips the boxes farther than the
+  * current closest point.*/
+{
+  h.t = -1;
+  h.d = dmax;
+  if( _nodes.empty() ) return false;
+
+  double best = ( dmax < 1e150 ) ? dmax*dmax : DBL_MAX;
+  int stack[BVH_DEPTH+2], ns = 0;
+  if( bvh_box_dist2( _nodes[0], p ) <= best ) stack[ns++] = 0;
+  while( ns > 0 )
+  {
+    const Node &n = _nodes[ stack[--ns] ];
+    if( bvh_box_dist2( n, p ) > best ) continue;
+    if( n.count > 0 )
+    {
+      for( int j=n.index; j<n.index+n.count; ++j )
+      {
+        double q[3], u, v;
+        const double d = bvh_tri_closest( &_P[9*(size_t)j], p, q, u, v );
+        if( !( d <= best ) || ( d == best && h.t >= 0 ) ) continue;  // a NaN distance is skipped
+        best = d;
+        h.t = _T[j];  h.u = u;  h.v = v;
+        h.p[0] = q[0];  h.p[1] = q[1];  h.p[2] = q[2];
+      }
+      continue;
+    }
+
+    const int    a  = (int)( &n - &_nodes[0] ) + 1, b = n.index;
+    const double da = bvh_box_dist2( _nodes[a], p ), db = bvh_box_dist2( _nodes[b], p );
+    if( da <= db ) { if( db <= best ) stack[ns++] = b;  if( da <= best ) stack[ns++] = a; }
+    else           { if( da <= best ) stack[ns++] = a;  if( db <= best ) stack[ns++] = b; }
+  }
+
+  if( h.t < 0 ) return false;
+  h.d = sqrt( best );
+  return true;
+}
+//--------------------------------------------------//
+int Bvh::radius( const double *p, const double r, vector<int> &t ) const
+//--------------------------------------------------//
+/** Visits the boxes closer than r and tests the distance to their triangles.*/
+{
+  if( _nodes.empty() || r < 0 ) return 0;
+
+  const double r2 = r*r;
+  const size_t n0 = t.size();
+  int stack[BVH_DEPTH+2], ns = 0;
+  stack[ns++] = 0;
+  while( ns > 0 )
+  {
+    const Node &n = _nodes[ stack[--ns] ];
+    if( bvh_box_dist2( n, p ) > r2 ) continue;
+    if( n.count > 0 )
+    {
+      for( int j=n.index; j<n.index+n.count; ++j )
+      {
+        double q[3], u, v;
+        if( bvh_tri_closest( &_P[9*(size_t)j], p, q, u, v ) <= r2 ) t.push_back( _T[j] );
+      }
+      continue;
+    }
+    stack[ns++] = n.index;
+    stack[ns++] = (int)( &n - &_nodes[0] ) + 1;
+  }
+  return (int)( t.size() - n0 );
+}
+//--------------------------------------------------//
+void Bvh::ray_batch( const int n, const double *o, const double *d, Bvh_hit *h, const double tmax ) const
+//--------------------------------------------------//
+/** One ray per iteration.*/
+{
+  #pragma omp parallel for schedule(dynamic,64)
+  for( int i=0; i<n; ++i ) ray( o+3*i, d+3*i, h[i], tmax );
+}
+//--------------------------------------------------//
+void Bvh::closest_batch( const int n, const double *p, Bvh_hit *h, const double dmax ) const
+//--------------------------------------------------//
+/** One point per iteration.*/
+{
+  #pragma omp parallel for schedule(dynamic,64)
+  for( int i=0; i<n; ++i ) closest( p+3*i, h[i], dmax );
+}
+//--------------------------------------------------//
+void Bvh::radius_batch( const int n, const double *p, const double r, vector< vector<int> > &t ) const
+//--------------------------------------------------//
+/** One point per iteration, each in its own list.*/
+{
+  t.resize( n );
+  #pragma omp parallel for schedule(dynamic,64)
+  for( int i=0; i<n; ++i ) { t[i].clear();  radius( p+3*i, r, t[i] ); }
+}
+//--------------------------------------------------//
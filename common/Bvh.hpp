@@ -0,0 +1,245 @@
+/**
+* @file    Bvh.hpp
+*
+* @brief  (Bounding volume hierarchy over the triangles of a CHE or CHF mesh)
+*
+* Spatial index for ray casting (picking), closest point and radius
+* queries on the triangles of a CHE level (Bvh_CHE) or on the boundary
+* triangles of a CHF_L3 (Bvh_CHF):
+*
+* - the tree is built top-down with the surface area heuristic, on 16
+*   bins of the triangle centroids along each axis;
+* - the nodes are stored flat in depth-first order, the left child right
+*   after its parent, with float boxes rounded outwards (32 bytes per
+*   node);
+* - the coordinates of the triangles are copied in the order of the
+*   leaves, so that the queries do not touch the mesh;
+* - refit() reads the triangles again and updates the boxes after the
+*   vertices have moved, without changing the tree. After an edit of the
+*   connectivity, the tree must be built again.
+*
+* The batched queries run in parallel, one query per iteration.
+*/
+//--------------------------------------------------//
+
+#ifndef _BVH_HPP_
+#define _BVH_HPP_
+
+#include <vector>
+#include <cfloat>
+
+using namespace std;
+
+//--------------------------------------------------//
+/** Triangles of a mesh
+  * \brief Source of the triangles of a Bvh*/
+class Bvh_source
+//--------------------------------------------------//
+{
+public:
+  /** \brief Destructor*/
+  virtual ~Bvh_source() {}
+  /** \brief Number of triangle ids, including the removed ones*/
+  virtual int  ntrig() const = 0;
+  /** \brief Coordinates of the three vertices of a triangle. Returns
+    * false if the triangle is removed.
+    * \param t - const int
+    * \param p - double*  9 coordinates*/
+  virtual bool triangle( const int t, double *p ) const = 0;
+};
+
+//--------------------------------------------------//
+/** Triangles of a CHE level (CHE_L0 or above)
+  * \brief Bvh_source of a CHE mesh*/
+template <class M> class Bvh_CHE : public Bvh_source
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Mesh*/
+  const M &_m;
+
+public:
+  /** \brief Constructor
+    * \param m - const M&*/
+  Bvh_CHE( const M &m ) : _m(m) {}
+
+  /** \brief Number of triangle ids*/
+  virtual int  ntrig() const { return _m.ntrig(); }
+  /** \brief Coordinates of the vertices of a triangle
+    * \param t - const int
+    * \param p - double* */
+  virtual bool triangle( const int t, double *p ) const
+  {
+    if( !_m.tr_valid(t) ) return false;
+    for( int k=0; k<3; ++k )
+    {
+      const int v = _m.V( 3*t+k );
+      p[3*k] = _m.x(v);  p[3*k+1] = _m.y(v);  p[3*k+2] = _m.z(v);
+    }
+    return true;
+  }
+};
+
+//--------------------------------------------------//
+/** Boundary triangles of a CHF_L3 (its _bV table)
+  * \brief Bvh_source of the boundary of a CHF mesh*/
+template <class M> class Bvh_CHF : public Bvh_source
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Mesh*/
+  M &_m;
+
+public:
+  /** \brief Constructor: creates the boundary tables if needed
+    * \param m - M&*/
+  Bvh_CHF( M &m ) : _m(m) { _m.need_boundary(); }
+
+  /** \brief Number of boundary triangle ids*/
+  virtual int  ntrig() const { return _m.bntrig(); }
+  /** \brief Coordinates of the vertices of a boundary triangle
+    * \param t - const int
+    * \param p - double* */
+  virtual bool triangle( const int t, double *p ) const
+  {
+    if( !_m.tr_valid(t) ) return false;
+    for( int k=0; k<3; ++k )
+    {
+      const int v = _m.bV( 3*t+k );
+      if( !_m.v_valid(v) ) return false;
+      p[3*k] = _m.G(v).x();  p[3*k+1] = _m.G(v).y();  p[3*k+2] = _m.G(v).z();
+    }
+    return true;
+  }
+};
+
+//--------------------------------------------------//
+/** Result of a query
+  * \brief Triangle hit by a ray or closest to a point*/
+struct Bvh_hit
+//--------------------------------------------------//
+{
+  /** \brief Triangle id in the source, -1 if there is none*/
+  int    t;
+  /** \brief Ray parameter of the hit, or distance to the closest point*/
+  double d;
+  /** \brief Hit point or closest point*/
+  double p[3];
+  /** \brief Barycentric coordinates of p on the second and third
+    * vertices of the triangle*/
+  double u, v;
+};
+
+//--------------------------------------------------//
+/** Bvh class
+  * \brief Flat surface area heuristic BVH of triangles*/
+class Bvh
+//--------------------------------------------------//
+{
+public:
+  /** \brief Node: a leaf (count > 0) holds the triangles index to
+    * index+count-1, an inner node has its left child right after it
+    * and its right child at index*/
+  struct Node
+  {
+    /** \brief Box, rounded outwards*/
+    float lo[3], hi[3];
+    /** \brief First triangle of a leaf, or right child*/
+    int   index;
+    /** \brief Number of triangles of a leaf, 0 for an inner node*/
+    int   count;
+  };
+
+protected:
+  /** \brief Nodes in depth-first order*/
+  vector<Node>   _nodes;
+  /** \brief Source id of the triangles, in the order of the leaves*/
+  vector<int>    _T;
+  /** \brief Coordinates of the triangles, 9 per triangle*/
+  vector<double> _P;
+  /** \brief Number of triangles under which a node is a leaf*/
+  int            _leaf;
+
+public:
+  /** \brief Constructor
+    * \param leaf = 4 - const int  triangles per leaf below which no split is tried*/
+  Bvh( const int leaf = 4 ) : _leaf( leaf < 1 ? 1 : leaf ) {}
+
+public:
+  /** \brief Number of nodes*/
+  inline int nnodes() const { return (int)_nodes.size(); }
+  /** \brief Number of indexed triangles*/
+  inline int ntrig () const { return (int)_T.size(); }
+  /** \brief Tests if the tree is built*/
+  inline bool empty() const { return _nodes.empty(); }
+  /** \brief Access to a node
+    * \param i - const int */
+  inline const Node &node( const int i ) const { return _nodes[i]; }
+  /** \brief Releases the tree*/
+  void clear();
+
+  /** \brief Builds the tree on the valid triangles of a source
+    * \param s - const Bvh_source& */
+  void build( const Bvh_source &s );
+  /** \brief Reads the triangles again and updates the boxes, after the
+    * vertices of the mesh have moved
+    * \param s - const Bvh_source&  the source of the build*/
+  void refit( const Bvh_source &s );
+
+public:
+  /** \brief First triangle hit by the ray o + t d, for t in [0, tmax].
+    * Returns false if there is none.
+    * \param o - const double*  origin
+    * \param d - const double*  direction, not normalized
+    * \param h - Bvh_hit&
+    * \param tmax = DBL_MAX - const double */
+  bool ray    ( const double *o, const double *d, Bvh_hit &h, const double tmax = DBL_MAX ) const;
+  /** \brief Closest point of the triangles, at a distance below dmax.
+    * Returns false if there is none.
+    * \param p - const double*
+    * \param h - Bvh_hit&
+    * \param dmax = DBL_MAX - const double */
+  bool closest( const double *p, Bvh_hit &h, const double dmax = DBL_MAX ) const;
+  /** \brief Appends the triangles at a distance at most r of a point
+    * and returns their number
+    * \param p - const double*
+    * \param r - const double
+    * \param t - vector<int>& */
+  int  radius ( const double *p, const double r, vector<int> &t ) const;
+
+  /** \brief Casts n rays in parallel
+    * \param n - const int
+    * \param o - const double*  3n origins
+    * \param d - const double*  3n directions
+    * \param h - Bvh_hit*  n results (t = -1 for a miss)
+    * \param tmax = DBL_MAX - const double */
+  void ray_batch    ( const int n, const double *o, const double *d, Bvh_hit *h, const double tmax = DBL_MAX ) const;
+  /** \brief Closest points of n points, in parallel
+    * \param n - const int
+    * \param p - const double*  3n coordinates
+    * \param h - Bvh_hit*  n results (t = -1 if none)
+    * \param dmax = DBL_MAX - const double */
+  void closest_batch( const int n, const double *p, Bvh_hit *h, const double dmax = DBL_MAX ) const;
+  /** \brief Triangles around n points, in parallel
+    * \param n - const int
+    * \param p - const double*  3n coordinates
+    * \param r - const double
+    * \param t - vector< vector<int> >&  n lists*/
+  void radius_batch ( const int n, const double *p, const double r, vector< vector<int> > &t ) const;
+
+protected:
+  /** \brief Builds the subtree of the triangles ids[b..e-1] and returns
+    * its node
+    * \param ids - vector<int>&  triangles, partitioned in place
+    * \param c   - const vector<double>&  centroids
+    * \param bx  - const vector<double>&  boxes, 6 per triangle
+    * \param b, e - const int
+    * \param depth - const int */
+  int  build_node( vector<int> &ids, const vector<double> &c, const vector<double> &bx, const int b, const int e, const int depth );
+  /** \brief Sets the box of a node from its triangles or its children
+    * \param i - const int */
+  void fit_node( const int i );
+};
+
+#endif
+//--------------------------------------------------//
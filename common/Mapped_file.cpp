@@ -0,0 +1,115 @@
+/**
+* @file    Mapped_file.cpp
+*
+* @brief  (Memory mapped file)
+*/
+
+#include "Mapped_file.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//--------------------------------------------------//
+Mapped_file::Mapped_file()
+//--------------------------------------------------//
+/** Constructs an empty mapping.*/
+: _data(NULL), _size(0), _writable(false)
+#if defined(_WIN32)
+  , _file(NULL), _map(NULL)
+#endif
+{}
+//--------------------------------------------------//
+bool Mapped_file::open( const char *file )
+//--------------------------------------------------//
+/** Maps the file.*/
+{
+  close();
+
+#if defined(_WIN32)
+  HANDLE f = CreateFileA( file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+  if( f == INVALID_HANDLE_VALUE ) return false;
+  LARGE_INTEGER sz;
+  if( !GetFileSizeEx( f, &sz ) || sz.QuadPart == 0 ) { CloseHandle( f ); return false; }
+  HANDLE m = CreateFileMappingA( f, NULL, PAGE_READONLY, 0, 0, NULL );
+  if( m == NULL ) { CloseHandle( f ); return false; }
+  _data = (const char*) MapViewOfFile( m, FILE_MAP_READ, 0, 0, 0 );
+  if( _data == NULL ) { CloseHandle( m ); CloseHandle( f ); return false; }
+  _file = f;  _map = m;  _size = (size_t) sz.QuadPart;
+#else
+  int fd = ::open( file, O_RDONLY );
+  if( fd < 0 ) return false;
+  struct stat st;
+  if( fstat( fd, &st ) != 0 || st.st_size == 0 ) { ::close( fd ); return false; }
+  void *p = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  ::close( fd );
+  if( p == MAP_FAILED ) return false;
+  madvise( p, (size_t) st.st_size, MADV_SEQUENTIAL );
+  _data = (const char*) p;  _size = (size_t) st.st_size;
+#endif
+  return true;
+}
+//--------------------------------------------------//
+bool Mapped_file::create( const char *file, const size_t size )
+//--------------------------------------------------//
+/** Creates the file and maps it for reading and writing.*/
+{
+  close();
+  if( size == 0 ) return false;
+
+#if defined(_WIN32)
+  HANDLE f = CreateFileA( file, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+  if( f == INVALID_HANDLE_VALUE ) return false;
+  LARGE_INTEGER sz;
+  sz.QuadPart = (LONGLONG) size;
+  HANDLE m = CreateFileMappingA( f, NULL, PAGE_READWRITE, sz.HighPart, sz.LowPart, NULL );
+  if( m == NULL ) { CloseHandle( f ); return false; }
+  _data = (const char*) MapViewOfFile( m, FILE_MAP_WRITE, 0, 0, 0 );
+  if( _data == NULL ) { CloseHandle( m ); CloseHandle( f ); return false; }
+  _file = f;  _map = m;
+#else
+  int fd = ::open( file, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if( fd < 0 ) return false;
+  if( ftruncate( fd, (off_t) size ) != 0 ) { ::close( fd ); return false; }
+  void *p = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  ::close( fd );
+  if( p == MAP_FAILED ) return false;
+  _data = (const char*) p;
+#endif
+  _size = size;
+  _writable = true;
+  return true;
+}
+//--------------------------------------------------//
+bool Mapped_file::sync()
+//--------------------------------------------------//
+/** Flushes a writable mapping.*/
+{
+  if( !_writable ) return true;
+#if defined(_WIN32)
+  return FlushViewOfFile( _data, 0 ) != 0;
+#else
+  return msync( (void*)_data, _size, MS_SYNC ) == 0;
+#endif
+}
+//--------------------------------------------------//
+void Mapped_file::close()
+//--------------------------------------------------//
+/** Unmaps the file.*/
+{
+#if defined(_WIN32)
+  if( _data ) UnmapViewOfFile( _data );
+  if( _map  ) CloseHandle( (HANDLE)_map  );
+  if( _file ) CloseHandle( (HANDLE)_file );
+  _map = _file = NULL;
+#else
+  if( _data ) munmap( (void*)_data, _size );
+#endif
+  _data = NULL;  _size = 0;  _writable = false;
+}
+//--------------------------------------------------//
@@ -0,0 +1,72 @@
+/**
+* @file    Mapped_file.hpp
+*
+* @brief  (Memory mapped file)
+*
+* Used read only by the PLY fast path (Ply_mmap) and by the snapshot
+* reader (Snapshot_reader), and for reading and writing by the
+* snapshot builder (Snapshot_builder).
+*/
+//--------------------------------------------------//
+
+#ifndef _MAPPED_FILE_HPP_
+#define _MAPPED_FILE_HPP_
+
+#include <cstddef>
+
+//--------------------------------------------------//
+/** Memory mapped file
+  * \brief Read only or writable memory mapped file*/
+class Mapped_file
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Mapped data*/
+  const char *_data;
+  /** \brief Size of the file*/
+  size_t      _size;
+  /** \brief True for a writable mapping*/
+  bool        _writable;
+#if defined(_WIN32)
+  /** \brief File and mapping handles*/
+  void       *_file, *_map;
+#endif
+
+public:
+  /** \brief Default constructor.*/
+  Mapped_file();
+  /** \brief Destructor: unmaps the file.*/
+  ~Mapped_file() { close(); }
+
+public:
+  /** \brief Maps a whole file, read only. Returns false if the file
+    * cannot be opened or is empty.
+    * \param file - const char* */
+  bool open ( const char *file );
+  /** \brief Creates (or truncates) a file of the given size, filled
+    * with zeros, and maps it for reading and writing. Returns false if
+    * the file cannot be created or mapped.
+    * \param file - const char*
+    * \param size - const size_t */
+  bool create( const char *file, const size_t size );
+  /** \brief Writes the modified pages of a writable mapping to the disk*/
+  bool sync ();
+  /** \brief Unmaps the file*/
+  void close();
+
+  /** \brief Access to the mapped data*/
+  inline const char  *data() const { return _data; }
+  /** \brief Size of the mapped data*/
+  inline const size_t size() const { return _size; }
+  /** \brief Writable access to the mapped data, NULL for a read only mapping*/
+  inline char *wdata() { return _writable ? (char*)_data : NULL; }
+
+private:
+  /** \brief Not copiable*/
+  Mapped_file( const Mapped_file & );
+  /** \brief Not copiable*/
+  Mapped_file &operator = ( const Mapped_file & );
+};
+
+#endif
+//--------------------------------------------------//
@@ -0,0 +1,103 @@
+/**
+* @file    Parallel.hpp
+*
+* @brief  (Parallel helpers shared by CHE and CHF)
+*
+* The parallel code paths of CHE and CHF use OpenMP. When the library is
+* compiled without OpenMP the pragmas are ignored and the helpers
+* below fall back to their serial meaning.
+*/
+//--------------------------------------------------//
+
+#ifndef _PARALLEL_HPP_
+#define _PARALLEL_HPP_
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/** \brief Number of threads available to the parallel paths*/
+inline int par_nthreads()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+/** \brief Number of threads of the calling team, which can be less
+  * than requested (dynamic adjustment, thread limit, nesting)*/
+inline int par_team_size()
+{
+#ifdef _OPENMP
+  return omp_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
+/** \brief Id of the calling thread inside a parallel region*/
+inline int par_thread()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+/** \brief Id of the calling thread, unique among the running threads:
+  * its number in the only team of more than one thread, or -1 when
+  * several nested teams are active and the numbers repeat*/
+inline int par_thread_id()
+{
+#ifdef _OPENMP
+  if( omp_get_active_level() > 1 ) return -1;
+  for( int l = omp_get_level(); l > 0; --l )
+    if( omp_get_team_size(l) > 1 ) return omp_get_ancestor_thread_num(l);
+#endif
+  return 0;
+}
+
+/** \brief Atomic compare and swap on an integer
+  * \param p - int*   address
+  * \param e - int    expected value
+  * \param d - int    desired value
+  * \return true if *p was e and has been replaced by d*/
+inline bool par_cas( int *p, int e, int d )
+{
+#if defined(_MSC_VER)
+  return _InterlockedCompareExchange( (volatile long*)p, d, e ) == e;
+#elif defined(__GNUC__)
+  return __sync_bool_compare_and_swap( p, e, d );
+#else
+  if( *p != e ) return false;
+  *p = d;
+  return true;
+#endif
+}
+
+/** \brief Atomic addition on an integer
+  * \param p - int*   address
+  * \param d - int    value added
+  * \return the value of *p before the addition*/
+inline int par_fetch_add( int *p, int d )
+{
+#if defined(_MSC_VER)
+  return _InterlockedExchangeAdd( (volatile long*)p, d );
+#elif defined(__GNUC__)
+  return __sync_fetch_and_add( p, d );
+#else
+  const int o = *p;
+  *p += d;
+  return o;
+#endif
+}
+
+#endif
+//--------------------------------------------------//
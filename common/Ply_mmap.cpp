@@ -0,0 +1,471 @@
+/**
+* @file    Ply_mmap.cpp
+*
+* @brief  (Memory mapped reader for binary little endian and ascii PLY files)
+*/
+
+#include "Ply_mmap.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <clocale>
+#include <sstream>
+
+using namespace std;
+
+//--------------------------------------------------//
+Ply_mmap::Ply_mmap()
+//--------------------------------------------------//
+/** Constructs an empty reader.*/
+: _data(NULL), _size(0),
+  _ev(-1), _ef(-1), _vstart(0), _vsize(0), _fstart(0), _fpre(0), _fpost(0), _flist(-1), _header(0),
+  _ascii(false), _vline(0), _fline(0), _px(-1), _py(-1), _pz(-1)
+{}
+//--------------------------------------------------//
+bool Ply_mmap::open( const char *file )
+//--------------------------------------------------//
+/** Maps the file and reads the header.*/
+{
+  close();
+
+  // the blocks are read as they are stored: the host has to be little endian
+  const int one = 1;
+  if( *(const char*)&one != 1 ) return false;
+
+  if( !_file.open( file ) ) return false;
+  _data = _file.data();
+  _size = _file.size();
+
+  if( !parse_header() ) { close(); return false; }
+  return true;
+}
+//--------------------------------------------------//
+void Ply_mmap::close()
+//--------------------------------------------------//
+/** Unmaps the file.*/
+{
+  _file.close();
+  _data = NULL;  _size = 0;
+  _elems.clear();
+  _ev = _ef = _flist = -1;
+  _vstart = _fstart = _header = 0;
+  _vsize = _fpre = _fpost = 0;
+  _ascii = false;
+  _vline = _fline = 0;
+  _px = _py = _pz = -1;
+}
+//--------------------------------------------------//
+int Ply_mmap::type_size( const Type t )
+//--------------------------------------------------//
+/** Size of a scalar type.*/
+{
+  switch( t )
+  {
+  case PLY_CHAR  : case PLY_UCHAR  : return 1;
+  case PLY_SHORT : case PLY_USHORT : return 2;
+  case PLY_INT   : case PLY_UINT   : case PLY_FLOAT : return 4;
+  case PLY_DOUBLE: return 8;
+  default : return 0;
+  }
+}
+//--------------------------------------------------//
+static Ply_mmap::Type ply_type( const string &s )
+//--------------------------------------------------//
+/** Type of a PLY type name.*/
+{
+  if( s == "char"   || s == "int8"    ) return Ply_mmap::PLY_CHAR;
+  if( s == "uchar"  || s == "uint8"   ) return Ply_mmap::PLY_UCHAR;
+  if( s == "short"  || s == "int16"   ) return Ply_mmap::PLY_SHORT;
+  if( s == "ushort" || s == "uint16"  ) return Ply_mmap::PLY_USHORT;
+  if( s == "int"    || s == "int32"   ) return Ply_mmap::PLY_INT;
+  if( s == "uint"   || s == "uint32"  ) return Ply_mmap::PLY_UINT;
+  if( s == "float"  || s == "float32" ) return Ply_mmap::PLY_FLOAT;
+  if( s == "double" || s == "float64" ) return Ply_mmap::PLY_DOUBLE;
+  return Ply_mmap::PLY_NONE;
+}
+//--------------------------------------------------//
+bool Ply_mmap::parse_header()
+//--------------------------------------------------//
+/** Parses the header and computes the block offsets.*/
+{
+  if( _size < 4 || strncmp( _data, "ply", 3 ) != 0 ) return false;
+
+  // end of the header
+  const char *end = NULL;
+  for( size_t i=0; i+11 <= _size && i < (1<<20); ++i )
+    if( _data[i] == 'e' && strncmp( _data+i, "end_header", 10 ) == 0 && ( i == 0 || _data[i-1] == '\n' ) )
+    { end = _data+i+10; break; }
+  if( end == NULL ) return false;
+  if( end < _data+_size && *end == '\r' ) ++end;
+  if( end >= _data+_size || *end != '\n' ) return false;
+  _header = (size_t)( end+1 - _data );
+
+  istringstream in( string( _data, _header ) );
+  string line;
+  bool format = false;
+  while( getline( in, line ) )
+  {
+    if( !line.empty() && line[line.size()-1] == '\r' ) line.erase( line.size()-1 );
+    istringstream ls( line );
+    string key;
+    ls >> key;
+    if( key == "format" )
+    {
+      string f;  ls >> f;
+      if( f == "ascii" ) _ascii = true;
+      else if( f != "binary_little_endian" ) return false;
+      format = true;
+    }
+    else if( key == "element" )
+    {
+      Element e;
+      if( !( ls >> e.name >> e.n ) || e.n < 0 ) return false;
+      _elems.push_back( e );
+    }
+    else if( key == "property" )
+    {
+      if( _elems.empty() ) return false;
+      Property p;
+      string t;
+      ls >> t;
+      p.offset = 0;
+      if( t == "list" )
+      {
+        string c, i;
+        ls >> c >> i >> p.name;
+        p.count = ply_type( c );
+        p.type  = ply_type( i );
+        if( p.count == PLY_NONE ) return false;
+      }
+      else
+      {
+        ls >> p.name;
+        p.count = PLY_NONE;
+        p.type  = ply_type( t );
+      }
+      if( p.type == PLY_NONE ) return false;
+      _elems.back().props.push_back( p );
+    }
+  }
+  if( !format ) return false;
+
+  for( int e=0; e<(int)_elems.size(); ++e )
+  {
+    if( _elems[e].name == "vertex" ) _ev = e;
+    if( _elems[e].name == "face"   ) _ef = e;
+  }
+  if( _ev < 0 || _ef < 0 ) return false;
+
+  // vertex element: scalars only
+  Element &ve = _elems[_ev];
+  _vsize = 0;
+  for( int p=0; p<(int)ve.props.size(); ++p )
+  {
+    if( ve.props[p].count != PLY_NONE ) return false;
+    ve.props[p].offset = _vsize;
+    _vsize += type_size( ve.props[p].type );
+  }
+  _px = property("x");  _py = property("y");  _pz = property("z");
+  if( _px < 0 || _py < 0 || _pz < 0 ) return false;
+
+  // face element: one list (vertex_indices) surrounded by scalars
+  Element &fe = _elems[_ef];
+  _fpre = _fpost = 0;
+  for( int p=0; p<(int)fe.props.size(); ++p )
+  {
+    Property &q = fe.props[p];
+    if( q.count != PLY_NONE )
+    {
+      if( _flist >= 0 ) return false;
+      if( q.name != "vertex_indices" && q.name != "vertex_index" ) return false;
+      if( q.type == PLY_FLOAT || q.type == PLY_DOUBLE ) return false;
+      _flist = p;
+      q.offset = _fpre;
+      continue;
+    }
+    q.offset = ( _flist < 0 ) ? _fpre : _fpost;
+    ( _flist < 0 ? _fpre : _fpost ) += type_size( q.type );
+  }
+  if( _flist < 0 ) return false;
+
+  // ascii: one line per element
+  if( _ascii )
+  {
+    int l = 0;
+    for( int e=0; e<(int)_elems.size(); ++e )
+    {
+      if( e == _ev ) _vline = l;
+      if( e == _ef ) _fline = l;
+      l += _elems[e].n;
+    }
+    return true;
+  }
+
+  // only the elements before the vertex and face blocks need a fixed size
+  size_t off = _header;
+  for( int e=0; e<(int)_elems.size() && ( e <= _ev || e <= _ef ); ++e )
+  {
+    if( e == _ev ) { _vstart = off;  off += (size_t)_elems[e].n * _vsize; continue; }
+    if( e == _ef )
+    {
+      _fstart = off;
+      // the face block is variable: it has to be the last block read
+      if( _ev > _ef ) return false;
+      break;
+    }
+    int s = 0;
+    for( int p=0; p<(int)_elems[e].props.size(); ++p )
+    {
+      if( _elems[e].props[p].count != PLY_NONE ) return false;
+      s += type_size( _elems[e].props[p].type );
+    }
+    off += (size_t)_elems[e].n * s;
+  }
+  if( _vstart + (size_t)nvert()*_vsize > _size ) return false;
+  if( _fstart > _size ) return false;
+
+  return true;
+}
+//--------------------------------------------------//
+int Ply_mmap::property( const char *name ) const
+//--------------------------------------------------//
+/** Index of a vertex property.*/
+{
+  if( _ev < 0 ) return -1;
+  const vector<Property> &p = _elems[_ev].props;
+  for( int i=0; i<(int)p.size(); ++i )
+    if( p[i].name == name ) return i;
+  return -1;
+}
+//--------------------------------------------------//
+template <class C, class I> static bool read_face_block( const char *src, const size_t step, const int pre, const int nf, const int n, int *V )
+//--------------------------------------------------//
+/** Reads the fixed size faces of a block, converting the indices.
+  * Returns false if a face does not have n vertices.*/
+{
+  int bad = 0;
+  #pragma omp parallel for schedule(static) reduction(+:bad) if( nf > 65536 )
+  for( int f=0; f<nf; ++f )
+  {
+    const char *q = src + (size_t)f*step + pre;
+    C c;
+    memcpy( &c, q, sizeof(C) );
+    if( (int)c != n ) { ++bad; continue; }
+    q += sizeof(C);
+    for( int k=0; k<n; ++k )
+    {
+      I i;
+      memcpy( &i, q + k*sizeof(I), sizeof(I) );
+      V[ (size_t)f*n + k ] = (int) i;
+    }
+  }
+  return bad == 0;
+}
+//--------------------------------------------------//
+template <class C> static bool read_face_block( const Ply_mmap::Type t, const char *src, const size_t step, const int pre, const int nf, const int n, int *V )
+//--------------------------------------------------//
+/** Dispatches on the type of the indices.*/
+{
+  switch( t )
+  {
+  case Ply_mmap::PLY_CHAR   : return read_face_block<C, signed char   >( src, step, pre, nf, n, V );
+  case Ply_mmap::PLY_UCHAR  : return read_face_block<C, unsigned char >( src, step, pre, nf, n, V );
+  case Ply_mmap::PLY_SHORT  : return read_face_block<C, short         >( src, step, pre, nf, n, V );
+  case Ply_mmap::PLY_USHORT : return read_face_block<C, unsigned short>( src, step, pre, nf, n, V );
+  case Ply_mmap::PLY_INT    : return read_face_block<C, int           >( src, step, pre, nf, n, V );
+  case Ply_mmap::PLY_UINT   : return read_face_block<C, unsigned int  >( src, step, pre, nf, n, V );
+  default : return false;
+  }
+}
+//--------------------------------------------------//
+bool Ply_mmap::read_faces( int *V, const int n ) const
+//--------------------------------------------------//
+/** Reads the vertex indices of the faces, assuming n vertices per face.*/
+{
+  if( _data == NULL || _ef < 0 || _ascii ) return false;
+
+  const Property &l = _elems[_ef].props[_flist];
+  const size_t step = (size_t)( _fpre + type_size(l.count) + n*type_size(l.type) + _fpost );
+  const int    nf   = nface();
+  if( _fstart + (size_t)nf*step > _size ) return false;
+
+  const char *src = _data + _fstart;
+  switch( l.count )
+  {
+  case PLY_CHAR   : return read_face_block<signed char   >( l.type, src, step, _fpre, nf, n, V );
+  case PLY_UCHAR  : return read_face_block<unsigned char >( l.type, src, step, _fpre, nf, n, V );
+  case PLY_SHORT  : return read_face_block<short         >( l.type, src, step, _fpre, nf, n, V );
+  case PLY_USHORT : return read_face_block<unsigned short>( l.type, src, step, _fpre, nf, n, V );
+  case PLY_INT    : return read_face_block<int           >( l.type, src, step, _fpre, nf, n, V );
+  case PLY_UINT   : return read_face_block<unsigned int  >( l.type, src, step, _fpre, nf, n, V );
+  default : return false;
+  }
+}
+//--------------------------------------------------//
+void Ply_mmap::ascii_chunks( vector<size_t> &cut ) const
+//--------------------------------------------------//
+/** Cuts the body in chunks of about 256kB ending on a newline.*/
+{
+  const size_t chunk = 1<<18;
+  cut.clear();
+  cut.push_back( _header );
+  size_t c = _header;
+  while( c < _size )
+  {
+    size_t e = c + chunk;
+    if( e >= _size ) e = _size;
+    else
+    {
+      const char *nl = (const char*) memchr( _data+e, '\n', _size-e );
+      e = nl ? (size_t)( nl+1 - _data ) : _size;
+    }
+    cut.push_back( e );
+    c = e;
+  }
+}
+//--------------------------------------------------//
+int Ply_mmap::count_lines( const char *b, const char *e )
+//--------------------------------------------------//
+/** Counts the non blank lines of a chunk.*/
+{
+  int n = 0;
+  const char *l;
+  while( next_line( b, e, l, l ) ) ++n;
+  return n;
+}
+//--------------------------------------------------//
+bool Ply_mmap::next_line( const char *&p, const char *e, const char *&b, const char *&le )
+//--------------------------------------------------//
+/** Finds the next non blank line.*/
+{
+  while( p < e )
+  {
+    const char *nl = (const char*) memchr( p, '\n', e-p );
+    const char *end = nl ? nl : e;
+    const char *q = p;
+    while( q < end && ( *q == ' ' || *q == '\t' || *q == '\r' ) ) ++q;
+    p = nl ? nl+1 : e;
+    if( q < end ) { b = q; le = end; return true; }
+  }
+  return false;
+}
+//--------------------------------------------------//
+static inline const char *skip_blank( const char *p, const char *e )
+//--------------------------------------------------//
+/** Skips the blanks before a token.*/
+{
+  while( p < e && ( *p == ' ' || *p == '\t' || *p == '\r' ) ) ++p;
+  return p;
+}
+//--------------------------------------------------//
+static inline const char *skip_token( const char *p, const char *e )
+//--------------------------------------------------//
+/** Skips a token.*/
+{
+  while( p < e && *p != ' ' && *p != '\t' && *p != '\r' ) ++p;
+  return p;
+}
+//--------------------------------------------------//
+static bool parse_real( const char *&p, const char *e, double &x )
+//--------------------------------------------------//
+/** Parses a real number with a '.' decimal point, whatever the
+  * locale (std::from_chars is C++17). A number of at most 15 
+  * significant digits and a power of ten up to 22 is exact with a 
+  * single product or quotient, as strtod would round it. The other 
+  * ones are given to strtod, on a copy of the token (so that it 
+  * never reads past the end of the mapped file) that uses the 
+  * decimal point of the current locale.*/
+{
+  static const double p10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  p = skip_blank( p, e );
+  const char *t = skip_token( p, e );
+  const size_t n = (size_t)( t-p );
+  if( n == 0 || n >= 64 ) return false;
+
+  // sign, digits and fraction, exponent
+  const char *q = p;
+  const bool neg = ( *q == '-' );
+  if( *q == '-' || *q == '+' ) ++q;
+  double m = 0;
+  int nd = 0, ng = 0, ex = 0;
+  for( ; q < t && *q >= '0' && *q <= '9'; ++q, ++ng ) { if( m > 0 || *q != '0' ) ++nd; m = 10*m + ( *q - '0' ); }
+  if( q < t && *q == '.' )
+    for( ++q; q < t && *q >= '0' && *q <= '9'; ++q, ++ng, --ex ) { if( m > 0 || *q != '0' ) ++nd; m = 10*m + ( *q - '0' ); }
+  if( ng > 0 && q < t && ( *q == 'e' || *q == 'E' ) )
+  {
+    ++q;
+    const bool eneg = ( q < t && *q == '-' );
+    if( q < t && ( *q == '-' || *q == '+' ) ) ++q;
+    int v = 0, nv = 0;
+    for( ; q < t && *q >= '0' && *q <= '9'; ++q, ++nv ) if( v < 10000 ) v = 10*v + ( *q - '0' );
+    ex = ( nv == 0 ) ? 10000 : ex + ( eneg ? -v : v );
+  }
+  if( ng > 0 && q == t && nd <= 15 && ex >= -22 && ex <= 22 )
+  {
+    x = ( ex < 0 ) ? m / p10[-ex] : m * p10[ex];
+    if( neg ) x = -x;
+    p = t;
+    return true;
+  }
+
+  char buf[64];
+  memcpy( buf, p, n );
+  buf[n] = '\0';
+  const char dp = localeconv()->decimal_point[0];
+  if( dp != '.' ) { char *d = (char*) memchr( buf, '.', n ); if( d ) *d = dp; }
+  char *end;
+  x = strtod( buf, &end );
+  if( end != buf+n ) return false;
+  p = t;
+  return true;
+}
+//--------------------------------------------------//
+static bool parse_int( const char *&p, const char *e, int &i )
+//--------------------------------------------------//
+/** Parses an integer.*/
+{
+  p = skip_blank( p, e );
+  bool neg = false;
+  if( p < e && ( *p == '-' || *p == '+' ) ) { neg = ( *p == '-' ); ++p; }
+  if( p >= e || *p < '0' || *p > '9' ) return false;
+  long v = 0;
+  while( p < e && *p >= '0' && *p <= '9' ) { v = 10*v + ( *p - '0' ); if( v > 2147483647L ) return false; ++p; }
+  if( p < e && *p != ' ' && *p != '\t' && *p != '\r' ) return false;
+  i = (int)( neg ? -v : v );
+  return true;
+}
+//--------------------------------------------------//
+bool Ply_mmap::parse_vertex( const char *b, const char *e, double *xyz ) const
+//--------------------------------------------------//
+/** Parses a vertex line.*/
+{
+  const int np = (int)_elems[_ev].props.size();
+  for( int i=0; i<np; ++i )
+  {
+    if( i != _px && i != _py && i != _pz )
+    {
+      b = skip_token( skip_blank( b, e ), e );
+      continue;
+    }
+    double x;
+    if( !parse_real( b, e, x ) ) return false;
+    xyz[ i == _px ? 0 : ( i == _py ? 1 : 2 ) ] = x;
+  }
+  return true;
+}
+//--------------------------------------------------//
+bool Ply_mmap::parse_face( const char *b, const char *e, int *V, const int n ) const
+//--------------------------------------------------//
+/** Parses a face line.*/
+{
+  for( int i=0; i<_flist; ++i ) b = skip_token( skip_blank( b, e ), e );
+
+  int c;
+  if( !parse_int( b, e, c ) || c != n ) return false;
+  for( int k=0; k<n; ++k )
+    if( !parse_int( b, e, V[k] ) ) return false;
+  return true;
+}
+//--------------------------------------------------//
@@ -0,0 +1,271 @@
+/**
+* @file    Ply_mmap.hpp
+*
+* @brief  (Memory mapped reader for binary little endian and ascii PLY files)
+*
+* Fast path of CHE_L0::read_ply and CHF_L0::read_ply. The file is
+* mapped in memory and the header is validated once.
+*
+* Binary little endian files: the vertex and face blocks are
+* converted in bulk, without a function call per element.
+*
+* Ascii files: the body is cut in newline aligned chunks that are
+* parsed in parallel. A prefix sum of the number of lines of each
+* chunk gives the element of each line, so that every chunk writes
+* its vertices and faces straight to their final place.
+*
+* Files that this reader does not handle (big endian files, lists in
+* the vertex element, several lists in the face element, faces of
+* different sizes...) make open(), read_faces() or read_ascii()
+* return false, and the caller falls back to the generic ply reader.
+*/
+//--------------------------------------------------//
+
+#ifndef _PLY_MMAP_HPP_
+#define _PLY_MMAP_HPP_
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Mapped_file.hpp"
+
+using namespace std;
+
+//--------------------------------------------------//
+/** Memory mapped PLY file
+  * \brief Memory mapped binary little endian and ascii PLY reader*/
+class Ply_mmap
+//--------------------------------------------------//
+{
+public:
+  /** \brief Scalar types of the PLY format*/
+  enum Type { PLY_NONE, PLY_CHAR, PLY_UCHAR, PLY_SHORT, PLY_USHORT, PLY_INT, PLY_UINT, PLY_FLOAT, PLY_DOUBLE };
+
+  /** \brief Property of an element*/
+  struct Property
+  {
+    /** \brief Name of the property*/
+    string name;
+    /** \brief Type of the scalar, or of the list items*/
+    Type   type;
+    /** \brief Type of the list count, PLY_NONE for a scalar*/
+    Type   count;
+    /** \brief Offset of the property in the element, in bytes (before the list for the face element)*/
+    int    offset;
+  };
+
+  /** \brief Element of the file*/
+  struct Element
+  {
+    /** \brief Name of the element*/
+    string           name;
+    /** \brief Number of elements*/
+    int              n;
+    /** \brief Properties of the element*/
+    vector<Property> props;
+  };
+
+protected:
+  /** \brief Mapped file*/
+  Mapped_file      _file;
+  /** \brief Mapped data*/
+  const char      *_data;
+  /** \brief Size of the mapped data*/
+  size_t           _size;
+
+  /** \brief Elements of the file, in order*/
+  vector<Element>  _elems;
+  /** \brief Index of the vertex element*/
+  int              _ev;
+  /** \brief Index of the face element*/
+  int              _ef;
+  /** \brief Start of the vertex block*/
+  size_t           _vstart;
+  /** \brief Size of a vertex, in bytes*/
+  int              _vsize;
+  /** \brief Start of the face block*/
+  size_t           _fstart;
+  /** \brief Number of bytes before the vertex_indices list of a face*/
+  int              _fpre;
+  /** \brief Number of bytes after the vertex_indices list of a face*/
+  int              _fpost;
+  /** \brief Property vertex_indices of the face element*/
+  int              _flist;
+  /** \brief End of the header*/
+  size_t           _header;
+  /** \brief True for an ascii file*/
+  bool             _ascii;
+  /** \brief First line of the vertex and face elements in the body of an ascii file*/
+  int              _vline, _fline;
+  /** \brief Index of the x, y and z vertex properties*/
+  int              _px, _py, _pz;
+
+public:
+  /** \brief Default constructor.*/
+  Ply_mmap();
+  /** \brief Destructor: unmaps the file.*/
+  ~Ply_mmap() { close(); }
+
+public:
+  /** \brief Maps a file and reads its header. Returns false if the
+    * file is not a binary little endian or ascii ply file with a
+    * vertex and a face element that this reader can handle.
+    * \param file - const char* */
+  bool open ( const char *file );
+  /** \brief Unmaps the file*/
+  void close();
+
+  /** \brief True for an ascii file*/
+  inline const bool ascii() const { return _ascii; }
+
+  /** \brief Number of vertices*/
+  inline const int nvert() const { return _ev < 0 ? 0 : _elems[_ev].n; }
+  /** \brief Number of faces*/
+  inline const int nface() const { return _ef < 0 ? 0 : _elems[_ef].n; }
+
+  /** \brief Index of a property of the vertex element, -1 if absent
+    * \param name - const char* */
+  int  property( const char *name ) const;
+
+  /** \brief Reads a property of the vertices v0 to v1-1 in out[ (v-v0)*stride ]
+    * (binary files)
+    * \param p      - const int   property index
+    * \param out    - Real*
+    * \param stride - const int
+    * \param v0, v1 - const int   range of vertices*/
+  template <class Real> void read_vertex_property( const int p, Real *out, const int stride, const int v0, const int v1 ) const
+  {
+    const Property &q = _elems[_ev].props[p];
+    const char *src = _data + _vstart + (size_t)v0*_vsize + q.offset;
+    const int n = v1 - v0;
+    switch( q.type )
+    {
+    case PLY_CHAR   : convert<signed char   , Real>( src, _vsize, out, stride, n ); break;
+    case PLY_UCHAR  : convert<unsigned char , Real>( src, _vsize, out, stride, n ); break;
+    case PLY_SHORT  : convert<short         , Real>( src, _vsize, out, stride, n ); break;
+    case PLY_USHORT : convert<unsigned short, Real>( src, _vsize, out, stride, n ); break;
+    case PLY_INT    : convert<int           , Real>( src, _vsize, out, stride, n ); break;
+    case PLY_UINT   : convert<unsigned int  , Real>( src, _vsize, out, stride, n ); break;
+    case PLY_FLOAT  : convert<float         , Real>( src, _vsize, out, stride, n ); break;
+    case PLY_DOUBLE : convert<double        , Real>( src, _vsize, out, stride, n ); break;
+    default : break;
+    }
+  }
+
+  /** \brief Reads the x, y and z coordinates of the vertices v0 to v1-1, interleaved
+    * (binary files)
+    * \param v0, v1 - const int
+    * \param xyz    - Real*  3*(v1-v0) values*/
+  template <class Real> void read_positions( const int v0, const int v1, Real *xyz ) const
+  {
+    read_vertex_property( _px, xyz  , 3, v0, v1 );
+    read_vertex_property( _py, xyz+1, 3, v0, v1 );
+    read_vertex_property( _pz, xyz+2, 3, v0, v1 );
+  }
+
+  /** \brief Reads the vertex indices of all the faces into V, n per face
+    * (binary files).
+    * Returns false if a face does not have n vertices.
+    * \param V - int*  n*nface() values
+    * \param n - const int */
+  bool read_faces( int *V, const int n ) const;
+
+  /** \brief Reads an ascii file: calls set( v, x, y, z ) for each vertex
+    * and writes the vertex indices of the faces into V, n per face.
+    * The chunks are parsed in parallel: set is called concurrently
+    * for different vertices. Returns false if a line cannot be parsed
+    * or if a face does not have n vertices.
+    * \param set - const Set&  functor ( int, double, double, double )
+    * \param V   - int*        n*nface() values
+    * \param n   - const int */
+  template <class Set> bool read_ascii( const Set &set, int *V, const int n ) const
+  {
+    if( _data == NULL || !_ascii ) return false;
+
+    vector<size_t> cut;
+    ascii_chunks( cut );
+    const int nc = (int)cut.size() - 1;
+
+    // number of lines of each chunk, then first line of each chunk
+    vector<int> first( nc+1, 0 );
+    #pragma omp parallel for schedule(dynamic)
+    for( int c=0; c<nc; ++c ) first[c+1] = count_lines( _data+cut[c], _data+cut[c+1] );
+    for( int c=0; c<nc; ++c ) first[c+1] += first[c];
+    if( first[nc] < _vline + nvert() || first[nc] < _fline + nface() ) return false;
+
+    const int nv = nvert(), nf = nface();
+    int bad = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(+:bad)
+    for( int c=0; c<nc; ++c )
+    {
+      const char *p = _data+cut[c], *e = _data+cut[c+1], *b, *le;
+      int l = first[c];
+      while( bad == 0 && next_line( p, e, b, le ) )
+      {
+        const int v = l - _vline, f = l - _fline;
+        ++l;
+        if( v >= 0 && v < nv )
+        {
+          double xyz[3];
+          if( parse_vertex( b, le, xyz ) ) set( v, xyz[0], xyz[1], xyz[2] );
+          else ++bad;
+        }
+        else if( f >= 0 && f < nf )
+        {
+          if( !parse_face( b, le, V + (size_t)f*n, n ) ) ++bad;
+        }
+      }
+    }
+    return bad == 0;
+  }
+
+  /** \brief Size of a scalar type, in bytes
+    * \param t - const Type */
+  static int type_size( const Type t );
+
+protected:
+  /** \brief Parses the header and computes the block offsets*/
+  bool parse_header();
+
+  /** \brief Cuts the body of an ascii file in newline aligned chunks
+    * \param cut - vector<size_t>&  offsets of the chunk limits*/
+  void ascii_chunks( vector<size_t> &cut ) const;
+  /** \brief Number of non blank lines between b and e
+    * \param b, e - const char* */
+  static int  count_lines( const char *b, const char *e );
+  /** \brief Finds the next non blank line [b,le) from p, and moves p after it
+    * \param p     - const char*&
+    * \param e     - const char*   end of the chunk
+    * \param b, le - const char*&  line found*/
+  static bool next_line( const char *&p, const char *e, const char *&b, const char *&le );
+  /** \brief Parses the x, y and z coordinates of a vertex line
+    * \param b, e - const char*
+    * \param xyz  - double* */
+  bool parse_vertex( const char *b, const char *e, double *xyz ) const;
+  /** \brief Parses the vertex indices of a face line
+    * \param b, e - const char*
+    * \param V    - int*
+    * \param n    - const int */
+  bool parse_face( const char *b, const char *e, int *V, const int n ) const;
+
+  /** \brief Converts n values of type T spaced by step bytes
+    * \param src    - const char*
+    * \param step   - const int
+    * \param out    - Real*
+    * \param stride - const int
+    * \param n      - const int */
+  template <class T, class Real> static void convert( const char *src, const int step, Real *out, const int stride, const int n )
+  {
+    #pragma omp parallel for schedule(static) if( n > 65536 )
+    for( int i=0; i<n; ++i )
+    {
+      T t;
+      memcpy( &t, src + (size_t)i*step, sizeof(T) );
+      out[ (size_t)i*stride ] = (Real) t;
+    }
+  }
+};
+
+#endif
+//--------------------------------------------------//
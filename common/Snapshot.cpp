@@ -0,0 +1,249 @@
+/**
+* @file    Snapshot.cpp
+*
+* @brief  (Binary snapshot of the tables of a CHE or CHF level)
+*/
+
+#include "Snapshot.hpp"
+
+#include <cstdio>
+
+using namespace std;
+
+/** \brief Magic string of the snapshot files*/
+static const char SNAP_MAGIC[8] = { 'C','H','E','S','N','A','P','\0' };
+
+//--------------------------------------------------//
+uint64_t snap_checksum( const void *p, const size_t n )
+//--------------------------------------------------//
+/** Checksum of a memory block: four FNV-1a lanes on 64 bit words.*/
+{
+  const uint64_t prime = 1099511628211ULL;
+  uint64_t h[4] = { 14695981039346656037ULL, 14695981039346656037ULL ^ 1, 14695981039346656037ULL ^ 2, 14695981039346656037ULL ^ 3 };
+  const char *c = (const char*) p;
+
+  size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    uint64_t w[4];
+    memcpy( w, c+i, 32 );
+    h[0] = ( h[0] ^ w[0] ) * prime;
+    h[1] = ( h[1] ^ w[1] ) * prime;
+    h[2] = ( h[2] ^ w[2] ) * prime;
+    h[3] = ( h[3] ^ w[3] ) * prime;
+  }
+  for( ; i < n; ++i ) h[0] = ( h[0] ^ (unsigned char)c[i] ) * prime;
+
+  uint64_t r = (uint64_t) n;
+  for( int k=0; k<4; ++k ) r = ( r ^ h[k] ) * prime;
+  return r;
+}
+//--------------------------------------------------//
+void Snapshot_writer::add( const char *tag, const void *data, const size_t size, const size_t count )
+//--------------------------------------------------//
+/** Adds a table.*/
+{
+  Table t;
+  memset( t.tag, ' ', 4 );
+  memcpy( t.tag, tag, strlen(tag) < 4 ? strlen(tag) : 4 );
+  t.size  = (uint32_t) size;
+  t.count = (uint64_t) count;
+  t.data  = data;
+  t.value = -1;
+  _t.push_back( t );
+}
+//--------------------------------------------------//
+const void *Snapshot_writer::table_data( const int i ) const
+//--------------------------------------------------//
+/** Data of the table i.*/
+{
+  const Table &t = _t[i];
+  return ( t.value >= 0 ) ? (const void*)&_values[t.value][0] : t.data;
+}
+//--------------------------------------------------//
+uint64_t Snapshot_writer::layout( vector<Snap_entry> &dir ) const
+//--------------------------------------------------//
+/** Aligns the tables after the header and the directory.*/
+{
+  const int nt = (int)_t.size();
+
+  dir.resize( nt );
+  uint64_t off = sizeof(Snap_header) + nt*sizeof(Snap_entry);
+  for( int i=0; i<nt; ++i )
+  {
+    const Table &t = _t[i];
+    off = ( ( off + SNAP_ALIGN-1 ) / SNAP_ALIGN ) * SNAP_ALIGN;
+    memcpy( dir[i].tag, t.tag, 4 );
+    dir[i].size     = t.size;
+    dir[i].count    = t.count;
+    dir[i].offset   = off;
+    dir[i].checksum = 0;
+    off += t.size*t.count;
+  }
+  return off;
+}
+//--------------------------------------------------//
+void Snapshot_writer::header( Snap_header &h, const char *kind, const int level, const vector<Snap_entry> &dir )
+//--------------------------------------------------//
+/** Fills the header.*/
+{
+  const int nt = (int)dir.size();
+
+  memset( &h, 0, sizeof(h) );
+  memcpy( h.magic, SNAP_MAGIC, 8 );
+  h.version = SNAP_VERSION;
+  memset( h.kind, 0, 4 );
+  memcpy( h.kind, kind, strlen(kind) < 3 ? strlen(kind) : 3 );
+  h.level    = (uint32_t) level;
+  h.ntables  = (uint32_t) nt;
+  h.checksum = snap_checksum( nt ? &dir[0] : NULL, nt*sizeof(Snap_entry) );
+}
+//--------------------------------------------------//
+bool Snapshot_writer::write( const char *file, const char *kind, const int level ) const
+//--------------------------------------------------//
+/** Writes the header, the directory and the aligned tables.*/
+{
+  const int nt = (int)_t.size();
+
+  // directory
+  vector<Snap_entry> dir;
+  layout( dir );
+  for( int i=0; i<nt; ++i )
+    dir[i].checksum = snap_checksum( table_data(i), (size_t)( dir[i].size*dir[i].count ) );
+
+  Snap_header h;
+  header( h, kind, level, dir );
+
+  FILE *fp = fopen( file, "wb" );
+  if( fp == NULL ) return false;
+
+  bool ok = fwrite( &h, sizeof(h), 1, fp ) == 1;
+  if( nt ) ok = ok && fwrite( &dir[0], sizeof(Snap_entry), nt, fp ) == (size_t)nt;
+
+  uint64_t pos = sizeof(Snap_header) + nt*sizeof(Snap_entry);
+  const char zero[SNAP_ALIGN] = { 0 };
+  for( int i=0; i<nt && ok; ++i )
+  {
+    if( dir[i].offset > pos ) ok = fwrite( zero, 1, (size_t)( dir[i].offset - pos ), fp ) == (size_t)( dir[i].offset - pos );
+    const size_t bytes = (size_t)( dir[i].size*dir[i].count );
+    if( bytes ) ok = ok && fwrite( table_data(i), 1, bytes, fp ) == bytes;
+    pos = dir[i].offset + bytes;
+  }
+  ok = ( fclose( fp ) == 0 ) && ok;
+  return ok;
+}
+//--------------------------------------------------//
+bool Snapshot_builder::create( const char *file, const char *kind, const int level )
+//--------------------------------------------------//
+/** Creates and maps the file, and copies the given tables.*/
+{
+  _file.close();
+
+  const uint64_t n = layout( _dir );
+  if( !_file.create( file, (size_t) n ) ) return false;
+
+  memset( _kind, 0, 4 );
+  memcpy( _kind, kind, strlen(kind) < 3 ? strlen(kind) : 3 );
+  _level = level;
+
+  char *d = _file.wdata();
+  for( int i=0; i<(int)_dir.size(); ++i )
+  {
+    const void *p = table_data(i);
+    const size_t bytes = (size_t)( _dir[i].size*_dir[i].count );
+    if( p && bytes ) memcpy( d + _dir[i].offset, p, bytes );
+  }
+  return true;
+}
+//--------------------------------------------------//
+void *Snapshot_builder::table( const char *tag )
+//--------------------------------------------------//
+/** Finds a table in the directory.*/
+{
+  if( _file.wdata() == NULL ) return NULL;
+
+  char t[4];
+  memset( t, ' ', 4 );
+  memcpy( t, tag, strlen(tag) < 4 ? strlen(tag) : 4 );
+
+  for( int i=0; i<(int)_dir.size(); ++i )
+    if( memcmp( _dir[i].tag, t, 4 ) == 0 ) return _file.wdata() + _dir[i].offset;
+  return NULL;
+}
+//--------------------------------------------------//
+bool Snapshot_builder::close()
+//--------------------------------------------------//
+/** Computes the checksums and writes the header and the directory.*/
+{
+  char *d = _file.wdata();
+  if( d == NULL ) return false;
+
+  const int nt = (int)_dir.size();
+  for( int i=0; i<nt; ++i )
+    _dir[i].checksum = snap_checksum( d + _dir[i].offset, (size_t)( _dir[i].size*_dir[i].count ) );
+
+  Snap_header h;
+  header( h, _kind, _level, _dir );
+  memcpy( d, &h, sizeof(h) );
+  if( nt ) memcpy( d + sizeof(h), &_dir[0], nt*sizeof(Snap_entry) );
+
+  const bool ok = _file.sync();
+  _file.close();
+  return ok;
+}
+//--------------------------------------------------//
+bool Snapshot_reader::open( const char *file, const char *kind, const bool verify )
+//--------------------------------------------------//
+/** Maps the snapshot and validates it.*/
+{
+  close();
+  if( !_file.open( file ) ) return false;
+
+  const char  *d = _file.data();
+  const size_t n = _file.size();
+
+  const Snap_header *h = (const Snap_header*) d;
+  if( n < sizeof(Snap_header) || memcmp( h->magic, SNAP_MAGIC, 8 ) != 0 ) { close(); return false; }
+  if( h->version != SNAP_VERSION || strncmp( h->kind, kind, 4 ) != 0 )     { close(); return false; }
+
+  if( h->ntables > ( n - sizeof(Snap_header) ) / sizeof(Snap_entry) ) { close(); return false; }
+  const size_t dn = h->ntables * sizeof(Snap_entry);
+  const Snap_entry *e = (const Snap_entry*)( d + sizeof(Snap_header) );
+  if( snap_checksum( e, dn ) != h->checksum ) { close(); return false; }
+
+  for( uint32_t i=0; i<h->ntables; ++i )
+  {
+    // the count is bounded before the product, which could overflow
+    if( e[i].offset % SNAP_ALIGN || e[i].offset > n ) { close(); return false; }
+    const uint64_t room = n - e[i].offset;
+    if( e[i].size == 0 ? e[i].count != 0 : e[i].count > room / e[i].size ) { close(); return false; }
+    const uint64_t bytes = e[i].size * e[i].count;
+    if( verify && snap_checksum( d + e[i].offset, (size_t)bytes ) != e[i].checksum ) { close(); return false; }
+  }
+
+  _h = h;
+  _e = e;
+  return true;
+}
+//--------------------------------------------------//
+const void *Snapshot_reader::table( const char *tag, const size_t size, size_t &count ) const
+//--------------------------------------------------//
+/** Finds a table in the directory.*/
+{
+  count = 0;
+  if( _h == NULL ) return NULL;
+
+  char t[4];
+  memset( t, ' ', 4 );
+  memcpy( t, tag, strlen(tag) < 4 ? strlen(tag) : 4 );
+
+  for( uint32_t i=0; i<_h->ntables; ++i )
+  {
+    if( memcmp( _e[i].tag, t, 4 ) != 0 ) continue;
+    if( _e[i].size != size ) return NULL;
+    count = (size_t) _e[i].count;
+    return _file.data() + _e[i].offset;
+  }
+  return NULL;
+}
+//--------------------------------------------------//
@@ -0,0 +1,253 @@
+/**
+* @file    Snapshot.hpp
+*
+* @brief  (Binary snapshot of the tables of a CHE or CHF level)
+*
+* A snapshot stores the tables of a fully built level, so that a
+* process can restart without reading the PLY file and rebuilding
+* the opposites, orientation, edges... The file is
+*
+*   Snap_header                      (64 bytes)
+*   Snap_entry[ntables]              (32 bytes each)
+*   table 0, table 1, ...            (each aligned on SNAP_ALIGN bytes)
+*
+* The header carries a magic string, the format version, the library
+* ("CHE" or "CHF") and the level. Each entry carries a 4 character
+* tag, the size of an element, the number of elements, the offset
+* of the table and a checksum of its bytes; the header carries the
+* checksum of the directory. The reader maps the file and checks
+* all of them before giving access to the tables.
+*
+* The element size is stored with each table, so a snapshot written
+* with another vertex precision (CHE_REAL, CHF_REAL) is rejected.
+*
+* Snapshot_builder creates the file with its final layout and maps it
+* for writing, so that tables larger than the memory can be filled in
+* place (out of core construction, see CHE_Stream); the checksums are
+* computed when it is closed.
+*/
+//--------------------------------------------------//
+
+#ifndef _SNAPSHOT_HPP_
+#define _SNAPSHOT_HPP_
+
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+#include "Mapped_file.hpp"
+
+using namespace std;
+
+/** \brief Version of the snapshot format*/
+#define SNAP_VERSION 1
+/** \brief Alignment of the tables in the file, in bytes*/
+#define SNAP_ALIGN   64
+
+//--------------------------------------------------//
+/** \brief Header of a snapshot file*/
+struct Snap_header
+//--------------------------------------------------//
+{
+  /** \brief "CHESNAP" (with its terminal 0)*/
+  char     magic[8];
+  /** \brief SNAP_VERSION*/
+  uint32_t version;
+  /** \brief Library: "CHE" or "CHF"*/
+  char     kind[4];
+  /** \brief Level of the structure*/
+  uint32_t level;
+  /** \brief Number of tables*/
+  uint32_t ntables;
+  /** \brief Checksum of the directory*/
+  uint64_t checksum;
+  /** \brief Padding to 64 bytes*/
+  char     reserved[32];
+};
+
+//--------------------------------------------------//
+/** \brief Directory entry of a snapshot table*/
+struct Snap_entry
+//--------------------------------------------------//
+{
+  /** \brief Name of the table*/
+  char     tag[4];
+  /** \brief Size of an element, in bytes*/
+  uint32_t size;
+  /** \brief Number of elements*/
+  uint64_t count;
+  /** \brief Offset of the table in the file*/
+  uint64_t offset;
+  /** \brief Checksum of the table*/
+  uint64_t checksum;
+};
+
+/** \brief Checksum of a memory block (4 interleaved FNV-1a lanes on 64 bit words)
+  * \param p - const void*
+  * \param n - const size_t  number of bytes*/
+uint64_t snap_checksum( const void *p, const size_t n );
+
+//--------------------------------------------------//
+/** Snapshot writer
+  * \brief Collects tables and writes them in a snapshot file*/
+class Snapshot_writer
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Table to write*/
+  struct Table { char tag[4]; uint32_t size; uint64_t count; const void *data; int value; };
+  /** \brief Tables to write, in order*/
+  vector<Table> _t;
+  /** \brief Storage of the values added by add_value*/
+  vector< vector<char> > _values;
+
+public:
+  /** \brief Adds a table. The data must live until write() is called.
+    * A NULL data gives a table filled later through Snapshot_builder::table.
+    * \param tag   - const char*  4 characters
+    * \param data  - const void*
+    * \param size  - const size_t  size of an element
+    * \param count - const size_t  number of elements*/
+  void add( const char *tag, const void *data, const size_t size, const size_t count );
+
+  /** \brief Adds a vector as a table
+    * \param tag - const char*
+    * \param v   - const vector<T>& */
+  template <class T> void add( const char *tag, const vector<T> &v ) { add( tag, v.empty() ? NULL : &v[0], sizeof(T), v.size() ); }
+
+  /** \brief Adds a single value as a table (the value is copied)
+    * \param tag - const char*
+    * \param x   - const T */
+  template <class T> void add_value( const char *tag, const T x )
+  {
+    _values.push_back( vector<char>( sizeof(T) ) );
+    memcpy( &_values.back()[0], &x, sizeof(T) );
+    add( tag, NULL, sizeof(T), 1 );
+    _t.back().value = (int)_values.size() - 1;
+  }
+
+  /** \brief Writes the snapshot
+    * \param file  - const char*
+    * \param kind  - const char*  "CHE" or "CHF"
+    * \param level - const int */
+  bool write( const char *file, const char *kind, const int level ) const;
+
+protected:
+  /** \brief Data of a table, NULL for a table to be filled later
+    * \param i - const int */
+  const void *table_data( const int i ) const;
+  /** \brief Computes the directory (without the checksums) and returns
+    * the size of the file
+    * \param dir - vector<Snap_entry>& */
+  uint64_t layout( vector<Snap_entry> &dir ) const;
+  /** \brief Fills the header, with the checksum of the directory
+    * \param h     - Snap_header&
+    * \param kind  - const char*
+    * \param level - const int
+    * \param dir   - const vector<Snap_entry>& */
+  static void header( Snap_header &h, const char *kind, const int level, const vector<Snap_entry> &dir );
+};
+
+//--------------------------------------------------//
+/** Snapshot builder
+  * \brief Creates a snapshot file and maps it, to fill its tables in place*/
+class Snapshot_builder : public Snapshot_writer
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Mapped file*/
+  Mapped_file        _file;
+  /** \brief Directory*/
+  vector<Snap_entry> _dir;
+  /** \brief Library*/
+  char               _kind[4];
+  /** \brief Level*/
+  int                _level;
+
+public:
+  /** \brief Default constructor.*/
+  Snapshot_builder() : _level(0) { memset( _kind, 0, 4 ); }
+
+public:
+  /** \brief Creates the file with the tables added so far and maps it.
+    * The tables given with their data are copied, the others are
+    * filled with zeros.
+    * \param file  - const char*
+    * \param kind  - const char*  "CHE" or "CHF"
+    * \param level - const int */
+  bool  create( const char *file, const char *kind, const int level );
+  /** \brief Writable access to a table in the mapped file, NULL if it is absent
+    * \param tag - const char* */
+  void *table ( const char *tag );
+  /** \brief Computes the checksums, writes the header and the directory
+    * and unmaps the file*/
+  bool  close ();
+};
+
+//--------------------------------------------------//
+/** Snapshot reader
+  * \brief Maps a snapshot file and gives access to its tables*/
+class Snapshot_reader
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Mapped file*/
+  Mapped_file        _file;
+  /** \brief Header, in the mapped file*/
+  const Snap_header *_h;
+  /** \brief Directory, in the mapped file*/
+  const Snap_entry  *_e;
+
+public:
+  /** \brief Default constructor.*/
+  Snapshot_reader() : _h(NULL), _e(NULL) {}
+
+public:
+  /** \brief Maps a snapshot and checks its header, directory and
+    * checksums. Returns false if the file is not a valid snapshot
+    * of the given library.
+    * \param file   - const char*
+    * \param kind   - const char*  "CHE" or "CHF"
+    * \param verify = true - const bool  checks the table checksums*/
+  bool open( const char *file, const char *kind, const bool verify = true );
+  /** \brief Unmaps the file*/
+  void close() { _file.close(); _h = NULL; _e = NULL; }
+
+  /** \brief Level of the snapshot, -1 if no snapshot is open*/
+  inline const int level() const { return _h ? (int)_h->level : -1; }
+
+  /** \brief Access to a table in the mapped file, NULL if it is absent
+    * or if its elements do not have the given size
+    * \param tag   - const char*
+    * \param size  - const size_t
+    * \param count - size_t&  number of elements*/
+  const void *table( const char *tag, const size_t size, size_t &count ) const;
+
+  /** \brief Copies a table into a vector
+    * \param tag - const char*
+    * \param v   - vector<T>& */
+  template <class T> bool get( const char *tag, vector<T> &v ) const
+  {
+    size_t n;
+    const void *p = table( tag, sizeof(T), n );
+    if( p == NULL ) return false;
+    v.resize( n );
+    if( n ) memcpy( &v[0], p, n*sizeof(T) );
+    return true;
+  }
+
+  /** \brief Reads a single value
+    * \param tag - const char*
+    * \param x   - T& */
+  template <class T> bool get_value( const char *tag, T &x ) const
+  {
+    size_t n;
+    const void *p = table( tag, sizeof(T), n );
+    if( p == NULL || n != 1 ) return false;
+    memcpy( &x, p, sizeof(T) );
+    return true;
+  }
+};
+
+#endif
+//--------------------------------------------------//
@@ -0,0 +1,119 @@
+/**
+* @file    Space_curve.hpp
+*
+* @brief  (Morton and Hilbert keys of points in a box)
+*
+* Used by the locality reordering of CHE_L0::reorder and
+* CHF_L0::reorder: elements sorted by the key of their position are
+* close in memory when they are close in space. The coordinates are
+* quantized on CURVE_BITS bits per axis, and the key is a 64 bit
+* integer.
+*/
+//--------------------------------------------------//
+
+#ifndef _SPACE_CURVE_HPP_
+#define _SPACE_CURVE_HPP_
+
+#include <stdint.h>
+
+/** \brief Number of bits of the quantized coordinates*/
+#define CURVE_BITS 21
+
+//--------------------------------------------------//
+/** Space filling curve keys
+  * \brief Quantization of a box and keys of its points along a curve*/
+class Space_curve
+//--------------------------------------------------//
+{
+protected:
+  /** \brief Lower corner of the box*/
+  double _min[3];
+  /** \brief Quantization scale*/
+  double _scale;
+  /** \brief True for the Hilbert curve, false for the Morton order*/
+  bool   _hilbert;
+
+public:
+  /** \brief Constructor from the bounding box of the points
+    * \param min, max - const double*
+    * \param hilbert = true - const bool */
+  Space_curve( const double *min, const double *max, const bool hilbert = true ) : _hilbert(hilbert)
+  {
+    double l = 0;
+    for( int i=0; i<3; ++i )
+    {
+      _min[i] = min[i];
+      if( max[i]-min[i] > l ) l = max[i]-min[i];
+    }
+    _scale = ( l > 0 ) ? ( (double)( (1u << CURVE_BITS) - 1 ) ) / l : 0;
+  }
+
+public:
+  /** \brief Key of a point of the box
+    * \param x, y, z - const double */
+  inline uint64_t key( const double x, const double y, const double z ) const
+  {
+    uint32_t q[3];
+    const double p[3] = { x, y, z };
+    for( int i=0; i<3; ++i )
+    {
+      double t = ( p[i] - _min[i] ) * _scale;
+      if( !( t > 0 ) ) t = 0;  // also for NaN
+      if( t > (double)( (1u << CURVE_BITS) - 1 ) ) t = (double)( (1u << CURVE_BITS) - 1 );
+      q[i] = (uint32_t) t;
+    }
+    if( _hilbert ) hilbert_transpose( q );
+    return interleave( q );
+  }
+
+  /** \brief Interleaves the bits of three coordinates (Morton order)
+    * \param q - const uint32_t*  CURVE_BITS bits each*/
+  static inline uint64_t interleave( const uint32_t *q )
+  {
+    return spread( q[0] ) << 2 | spread( q[1] ) << 1 | spread( q[2] );
+  }
+
+  /** \brief Transforms quantized coordinates into the transposed Hilbert
+    * index, whose interleaving is the Hilbert key (J. Skilling, "Programming
+    * the Hilbert curve", 2004)
+    * \param q - uint32_t*  CURVE_BITS bits each*/
+  static inline void hilbert_transpose( uint32_t *q )
+  {
+    const uint32_t M = 1u << ( CURVE_BITS-1 );
+
+    // inverse undo
+    for( uint32_t Q = M; Q > 1; Q >>= 1 )
+    {
+      const uint32_t P = Q - 1;
+      for( int i=0; i<3; ++i )
+      {
+        if( q[i] & Q ) q[0] ^= P;  // invert
+        else { const uint32_t t = ( q[0] ^ q[i] ) & P; q[0] ^= t; q[i] ^= t; }  // exchange
+      }
+    }
+
+    // Gray encode
+    q[1] ^= q[0];
+    q[2] ^= q[1];
+    uint32_t t = 0;
+    for( uint32_t Q = M; Q > 1; Q >>= 1 ) if( q[2] & Q ) t ^= Q - 1;
+    for( int i=0; i<3; ++i ) q[i] ^= t;
+  }
+
+protected:
+  /** \brief Spreads the CURVE_BITS bits of x every three bits
+    * \param x - const uint32_t */
+  static inline uint64_t spread( const uint32_t x )
+  {
+    uint64_t v = x & 0x1fffff;
+    v = ( v | v << 32 ) & 0x1f00000000ffffULL;
+    v = ( v | v << 16 ) & 0x1f0000ff0000ffULL;
+    v = ( v | v <<  8 ) & 0x100f00f00f00f00fULL;
+    v = ( v | v <<  4 ) & 0x10c30c30c30c30c3ULL;
+    v = ( v | v <<  2 ) & 0x1249249249249249ULL;
+    return v;
+  }
+};
+
+#endif
+//--------------------------------------------------//
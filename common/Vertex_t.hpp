@@ -0,0 +1,304 @@
+/**
+* @file    Vertex_t.hpp
+*
+* @brief  (Vertex core shared by CHE and CHF)
+*
+* Vertex_t<Real, Attr> stores the coordinates of a vertex in the
+* precision Real (float or double). When Attr is false the normal
+* and the scalar field are not stored: their accessors return 0
+* and their setters do nothing. The geometric helpers (norms,
+* normals, areas, volumes and tangent bases) are written once here
+* and work on arrays of any floating point type.
+*
+* CHE/Vertex.hpp and CHF/Vertex.hpp derive their Vertex class from
+* this template; the precision is chosen at compile time with
+* CHE_REAL / CHF_REAL and the attributes with CHE_VERTEX_ATTR /
+* CHF_VERTEX_ATTR.
+*/
+//--------------------------------------------------//
+
+#ifndef _VERTEX_T_HPP_
+#define _VERTEX_T_HPP_
+
+#include <cmath>
+#include <cfloat>
+
+//--------------------------------------------------//
+/** Normal and scalar field of a vertex
+  * \brief Vertex attributes (stored)*/
+template <class Real, bool Attr> class Vertex_attr
+//--------------------------------------------------//
+{
+protected:
+  /** \brief normal of the vertex*/
+  Real _nx, _ny, _nz;
+  /** \brief scalar field of the vertex*/
+  Real _f;
+
+public:
+  /** \brief Constructor
+    * \param nx, ny, nz, f - Real */
+  Vertex_attr( Real nx=0, Real ny=0, Real nz=0, Real f=0 ) : _nx(nx), _ny(ny), _nz(nz), _f(f) {}
+
+  /** \brief Access to the coordenate nx of the normal*/
+  inline const Real nx() const { return _nx; }
+  /** \brief Access to the coordenate ny of the normal*/
+  inline const Real ny() const { return _ny; }
+  /** \brief Access to the coordenate nz of the normal*/
+  inline const Real nz() const { return _nz; }
+  /** \brief Access to the scalar field*/
+  inline const Real  f() const { return  _f; }
+
+  /** \brief Sets the coordenate nx of the normal*/
+  inline const void set_nx( const Real nx ) { _nx=nx; }
+  /** \brief Sets the coordenate ny of the normal*/
+  inline const void set_ny( const Real ny ) { _ny=ny; }
+  /** \brief Sets the coordenate nz of the normal*/
+  inline const void set_nz( const Real nz ) { _nz=nz; }
+  /** \brief Sets the scalar field*/
+  inline const void set_f ( const Real f  ) { _f=f;   }
+};
+
+//--------------------------------------------------//
+/** Normal and scalar field of a vertex
+  * \brief Vertex attributes (not stored)*/
+template <class Real> class Vertex_attr<Real, false>
+//--------------------------------------------------//
+{
+public:
+  /** \brief Constructor: the values are dropped*/
+  Vertex_attr( Real=0, Real=0, Real=0, Real=0 ) {}
+
+  /** \brief Access to the coordenate nx of the normal: 0*/
+  inline const Real nx() const { return 0; }
+  /** \brief Access to the coordenate ny of the normal: 0*/
+  inline const Real ny() const { return 0; }
+  /** \brief Access to the coordenate nz of the normal: 0*/
+  inline const Real nz() const { return 0; }
+  /** \brief Access to the scalar field: 0*/
+  inline const Real  f() const { return 0; }
+
+  /** \brief Ignored*/
+  inline const void set_nx( const Real ) {}
+  /** \brief Ignored*/
+  inline const void set_ny( const Real ) {}
+  /** \brief Ignored*/
+  inline const void set_nz( const Real ) {}
+  /** \brief Ignored*/
+  inline const void set_f ( const Real ) {}
+};
+
+//--------------------------------------------------//
+/** Vertex core of CHE and CHF
+  * \brief Templated vertex class*/
+template <class Real, bool Attr = true> class Vertex_t : public Vertex_attr<Real, Attr>
+//--------------------------------------------------//
+{
+public:
+  /** \brief Precision of the vertex*/
+  typedef Real real_type;
+
+protected:
+  /** \brief coordenate x of the vertex*/
+  Real _x;
+  /** \brief coordenate y of the vertex*/
+  Real _y;
+  /** \brief coordenate z of the vertex*/
+  Real _z;
+
+public:
+  /** \brief Constructor
+    * \param x, y, z    - Real coordinates
+    * \param nx, ny, nz - Real normal
+    * \param f          - Real field */
+  Vertex_t( Real x=0, Real y=0, Real z=0, Real nx=0, Real ny=0, Real nz=0, Real f=0 ) :
+    Vertex_attr<Real, Attr>(nx, ny, nz, f), _x(x), _y(y), _z(z) {}
+
+public:
+  /** \brief Access to the coordinate x of the vertex*/
+  inline const Real     x() const { return _x; }
+  /** \brief Access to the coordinate y of the vertex*/
+  inline const Real     y() const { return _y; }
+  /** \brief Access to the coordinate z of the vertex*/
+  inline const Real     z() const { return _z; }
+  /** \brief Access to the scalar field of the vertex*/
+  inline const Real field() const { return this->f(); }
+
+  /** \brief Sets the coordenate x of the vertex*/
+  inline const void set_x( const Real x ) { _x=x; }
+  /** \brief Sets the coordenate y of the vertex*/
+  inline const void set_y( const Real y ) { _y=y; }
+  /** \brief Sets the coordenate z of the vertex*/
+  inline const void set_z( const Real z ) { _z=z; }
+  /** \brief Sets the scalar field of the vertex*/
+  inline const void set_field( const Real f ) { this->set_f(f); }
+
+//-- Vertex bool operators --//
+public:
+  /** \brief Equal operator for Vertex objects
+    * \param v - const Vertex_t& */
+  bool operator == (const Vertex_t& v) const { return (_x==v._x && _y==v._y && _z==v._z && this->nx()==v.nx() && this->ny()==v.ny() && this->nz()==v.nz() && this->f()==v.f()); }
+  /** \brief Different operator for Vertex objects
+    * \param v - const Vertex_t& */
+  bool operator != (const Vertex_t& v) const { return !( *this == v ); }
+
+//-- Static Methods --//
+public:
+  /** \brief computes the squared norm of a vector in R^3*/
+  template <class T> inline static T norm2( const T v[3] ) { return v[0]*v[0] + v[1]*v[1] + v[2]*v[2]; }
+  /** \brief computes the squared norm of a vector in R^3*/
+  template <class T> inline static T norm2( const T a, const T b, const T c ) { return a*a + b*b + c*c; }
+  /** \brief computes the norm of a vector in R^3*/
+  template <class T> inline static T norm ( const T v[3] ) { return (T) sqrt( norm2(v) ); }
+  /** \brief computes the norm of a vector in R^3*/
+  template <class T> inline static T norm ( const T a, const T b, const T c ) { return (T) sqrt( norm2(a,b,c) ); }
+  /** \brief computes the squared norm of a vector in R^4*/
+  template <class T> inline static T norm2_4( const T v[4] ) { return v[0]*v[0] + v[1]*v[1] + v[2]*v[2] + v[3]*v[3]; }
+  /** \brief computes the squared norm of a vector in R^4*/
+  template <class T> inline static T norm2_4( const T a, const T b, const T c, const T d ) { return a*a + b*b + c*c + d*d; }
+  /** \brief computes the norm of a vector in R^4*/
+  template <class T> inline static T norm_4( const T v[4] ) { return (T) sqrt( norm2_4(v) ); }
+  /** \brief computes the norm of a vector in R^4*/
+  template <class T> inline static T norm_4( const T a, const T b, const T c, const T d ) { return (T) sqrt( norm2_4(a,b,c,d) ); }
+
+  /** \brief Normalizes a vector in R^3
+    * \param v - T* */
+  template <class T> static void normalize( T *v )
+  {
+    T n = norm( v[0], v[1], v[2] );
+    if( n > FLT_EPSILON ) { v[0]/=n; v[1]/=n; v[2]/=n; }
+  }
+  /** \brief Normalizes a vector in R^4 (by the norm of its first three coordinates)
+    * \param v - T* */
+  template <class T> static void normalize_4( T *v )
+  {
+    T n = norm( v[0], v[1], v[2] );
+    if( n > FLT_EPSILON ) { v[0]/=n; v[1]/=n; v[2]/=n; v[3]/=n; }
+  }
+
+  /** \brief Computes the normal of a triangle, not normalized
+    * (its norm is twice the area of the triangle)
+    * \param v0, v1, v2 - const Vertex_t&
+    * \param n - T* */
+  template <class T> static void normal( const Vertex_t &v0, const Vertex_t &v1, const Vertex_t &v2, T *n )
+  {
+    T a0[3], a1[3];
+    a0[0]= v1.x()-v0.x();  a0[1]= v1.y()-v0.y();  a0[2]= v1.z()-v0.z();
+    a1[0]= v2.x()-v0.x();  a1[1]= v2.y()-v0.y();  a1[2]= v2.z()-v0.z();
+
+    n[0]= a0[1]*a1[2]-a1[1]*a0[2];
+    n[1]= a0[2]*a1[0]-a1[2]*a0[0];
+    n[2]= a0[0]*a1[1]-a1[0]*a0[1];
+  }
+
+  /** \brief computes the area of a triangle
+    * \param v0, v1, v2 - const Vertex_t& */
+  static const Real trig_area( const Vertex_t &v0, const Vertex_t &v1, const Vertex_t &v2 )
+  {
+    Real n[3];
+    normal( v0, v1, v2, n );
+    return norm( n[0], n[1], n[2] )/2;
+  }
+
+  /** \brief computes the signed volume of a tetrahedron (six times the volume)
+    * \param v0, v1, v2, v3 - const Vertex_t& */
+  static const Real signed_tetra_volume( const Vertex_t &v0, const Vertex_t &v1, const Vertex_t &v2, const Vertex_t &v3 )
+  {
+    Real a[3], b[3], c[3];
+    a[0]=v1.x()-v0.x();  b[0]=v2.x()-v0.x();  c[0]=v3.x()-v0.x();
+    a[1]=v1.y()-v0.y();  b[1]=v2.y()-v0.y();  c[1]=v3.y()-v0.y();
+    a[2]=v1.z()-v0.z();  b[2]=v2.z()-v0.z();  c[2]=v3.z()-v0.z();
+    return a[0]*(b[1]*c[2]-b[2]*c[1]) - a[1]*(b[0]*c[2]-b[2]*c[0]) + a[2]*(b[0]*c[1]-b[1]*c[0]);
+  }
+
+  /** \brief computes the volume of a tetrahedron in R^4 (x, y, z, field)
+    * \param v0, v1, v2, v3 - const Vertex_t& */
+  static const Real tetra_volume( const Vertex_t &v0, const Vertex_t &v1, const Vertex_t &v2, const Vertex_t &v3 )
+  {
+    Real a[4], b[4], c[4], prod[4];
+    a[0]=v1.x()-v0.x();  b[0]=v2.x()-v0.x();  c[0]=v3.x()-v0.x();
+    a[1]=v1.y()-v0.y();  b[1]=v2.y()-v0.y();  c[1]=v3.y()-v0.y();
+    a[2]=v1.z()-v0.z();  b[2]=v2.z()-v0.z();  c[2]=v3.z()-v0.z();
+    a[3]=v1.f()-v0.f();  b[3]=v2.f()-v0.f();  c[3]=v3.f()-v0.f();
+
+    prod[0]=  (a[1]*b[2]*c[3] + a[2]*b[3]*c[1] + a[3]*b[1]*c[2] - a[3]*b[2]*c[1] - a[2]*b[1]*c[3] - a[1]*b[3]*c[2]);
+    prod[1]= -(a[0]*b[2]*c[3] + a[2]*b[3]*c[0] + a[3]*b[0]*c[2] - a[3]*b[2]*c[0] - a[2]*b[0]*c[3] - a[0]*b[3]*c[2]);
+    prod[2]=  (a[0]*b[1]*c[3] + a[1]*b[3]*c[0] + a[3]*b[0]*c[1] - a[3]*b[1]*c[0] - a[1]*b[0]*c[3] - a[0]*b[3]*c[1]);
+    prod[3]= -(a[0]*b[1]*c[2] + a[1]*b[2]*c[0] + a[2]*b[0]*c[1] - a[2]*b[1]*c[0] - a[1]*b[0]*c[2] - a[0]*b[2]*c[1]);
+
+    return (Real)( (0.166667)*norm_4(prod) );
+  }
+
+  /** \brief computes the aspect ratio of a tetrahedron
+    * \param v0, v1, v2, v3 - const Vertex_t& */
+  static const Real tetra_aspect_ratio( const Vertex_t &v0, const Vertex_t &v1, const Vertex_t &v2, const Vertex_t &v3 )
+  {
+    const Vertex_t *p[4] = { &v0, &v1, &v2, &v3 };
+    static const int e[6][2] = { {1,0}, {2,0}, {3,0}, {1,2}, {2,3}, {3,1} };
+
+    Real m = 0;
+    for( int i=0; i<6; ++i )
+    {
+      const Vertex_t &a = *p[ e[i][0] ], &b = *p[ e[i][1] ];
+      Real l = norm( a.x()-b.x(), a.y()-b.y(), a.z()-b.z() );
+      if( l > m ) m = l;
+    }
+
+    Real cx = (v0.x() + v1.x() + v2.x() + v3.x())/4;
+    Real cy = (v0.y() + v1.y() + v2.y() + v3.y())/4;
+    Real cz = (v0.z() + v1.z() + v2.z() + v3.z())/4;
+    Real radio = norm( cx - v1.x(), cy - v1.y(), cz - v1.z() );
+
+    return (Real)( m/(2*sqrt(6.0)*radio) );
+  }
+
+  /** \brief computes a basis of the tangent space of a tetrahedron in R^4
+    * \param v0, v1, v2, v3 - const Vertex_t&
+    * \param base - T* (12 values) */
+  template <class T> static void tetra_base( const Vertex_t &v0, const Vertex_t &v1, const Vertex_t &v2, const Vertex_t &v3, T *base )
+  {
+    T a_0[4], a_1[4], a_2[4], temp[4];
+
+    a_0[0]=v1.x()-v0.x();  a_0[1]=v1.y()-v0.y();  a_0[2]=v1.z()-v0.z();  a_0[3]=v1.f()-v0.f();
+    a_1[0]=v2.x()-v0.x();  a_1[1]=v2.y()-v0.y();  a_1[2]=v2.z()-v0.z();  a_1[3]=v2.f()-v0.f();
+    a_2[0]=v3.x()-v0.x();  a_2[1]=v3.y()-v0.y();  a_2[2]=v3.z()-v0.z();  a_2[3]=v3.f()-v0.f();
+
+    for(int i=0; i<4; i++)
+      temp[i]= a_1[i]- ( (a_1[0]*a_0[0] + a_1[1]*a_0[1] + a_1[2]*a_0[2] + a_1[3]*a_0[3])/norm2_4(a_0) )*a_0[i];
+    for(int i=0; i<4; i++) a_1[i]=temp[i];
+
+    for(int i=0; i<4; i++)
+      temp[i]= a_2[i] - ( ( (a_2[0]*a_0[0] + a_2[1]*a_0[1] + a_2[2]*a_0[2] + a_2[3]*a_0[3] )/norm2_4(a_0) )*a_0[i]
+                         +( (a_2[0]*a_1[0] + a_2[1]*a_1[1] + a_2[2]*a_1[2] + a_2[3]*a_1[3] )/norm2_4(a_1) )*a_1[i] ) ;
+    for(int i=0; i<4; i++) a_2[i]=temp[i];
+
+    normalize_4( a_0 );
+    normalize_4( a_1 );
+    normalize_4( a_2 );
+
+    for(int i=0; i<4; i++) { base[i] = a_0[i]; base[4+i] = a_1[i]; base[8+i] = a_2[i]; }
+  }
+
+  /** \brief computes a basis of the tangent space of a triangle in R^4
+    * \param v0, v1, v2 - const Vertex_t&
+    * \param base - T* (8 values) */
+  template <class T> static void trig_base( const Vertex_t &v0, const Vertex_t &v1, const Vertex_t &v2, T *base )
+  {
+    T a_0[4], a_1[4], temp[4];
+
+    a_0[0]=v1.x()-v0.x();  a_0[1]=v1.y()-v0.y();  a_0[2]=v1.z()-v0.z();  a_0[3]=v1.f()-v0.f();
+    a_1[0]=v2.x()-v0.x();  a_1[1]=v2.y()-v0.y();  a_1[2]=v2.z()-v0.z();  a_1[3]=v2.f()-v0.f();
+
+    for(int i=0; i<4; i++)
+      temp[i]= a_1[i]- ( (a_1[0]*a_0[0] + a_1[1]*a_0[1] + a_1[2]*a_0[2])/norm2_4(a_0) )*a_0[i];
+    for(int i=0; i<4; i++) a_1[i]=temp[i];
+
+    normalize_4( a_0 );
+    normalize_4( a_1 );
+
+    for(int i=0; i<4; i++) { base[i] = a_0[i]; base[4+i] = a_1[i]; }
+  }
+};
+
+#endif
+//--------------------------------------------------//